@@ -252,7 +252,9 @@ func audioInit() error {
 		return fmt.Errorf("failed to initialize SDL2 audio: %w", err)
 	}
 
-	audioEventId = eventStream.Subscribe()
+	audioEventId = eventStream.Subscribe(PointOutEventType, AcceptedHandoffEventType,
+		OfferedHandoffEventType, RejectedHandoffEventType, CanceledHandoffEventType,
+		ReceivedATISEventType, TextMessageEventType)
 
 	soundEffects = make(map[string]*SoundEffect)
 	addEffect(bbrocer__digital_alarm_loopWAV, "Alarm - Digital", 2)
@@ -8,6 +8,7 @@ import (
 	"fmt"
 	"strconv"
 	"strings"
+	"sync"
 	"text/tabwriter"
 	"time"
 )
@@ -135,6 +136,194 @@ type RadarTrack struct {
 	Time        time.Time
 }
 
+// Number of radar tracks stored for each aircraft by default;
+// GlobalConfig.TrackHistoryLength can be used to choose a different
+// number.
+const defaultTrackHistoryLength = 30
+
+// Upper limit on the number of radar tracks stored for each aircraft;
+// storage for trackSlabHistories of them is allocated at once.
+const maxTrackHistoryLength = 500
+
+// trackHistoryLength is the number of tracks stored in TrackHistories
+// when their storage is allocated.
+var trackHistoryLength = defaultTrackHistoryLength
+
+// SetTrackHistoryLength sets the number of radar tracks that are stored
+// for aircraft; it only affects aircraft that don't yet have any tracks.
+func SetTrackHistoryLength(n int) {
+	if n < 3 {
+		// InterpolatedPosition needs at least three.
+		n = 3
+	}
+	if n > maxTrackHistoryLength {
+		lg.Printf("%d: track history length too long; using %d", n, maxTrackHistoryLength)
+		n = maxTrackHistoryLength
+	}
+	trackHistoryLength = n
+}
+
+// TrackHistory stores an aircraft's most recent radar tracks in a
+// fixed-size ring buffer, so that adding a track doesn't require moving
+// the earlier ones.  The zero value is an empty history; storage for
+// the tracks is allocated when the first one is added.
+type TrackHistory struct {
+	tracks []RadarTrack
+	// Index of the most recent track in tracks.
+	head int
+	// Number of valid tracks.
+	n int
+}
+
+// Storage for TrackHistory tracks is allocated from shared slabs to
+// reduce the number of allocations and to keep the tracks of different
+// aircraft close together in memory.  The storage of released
+// TrackHistories is kept for reuse.
+var trackSlab struct {
+	sync.Mutex
+	// The part of the current slab that hasn't been handed out.
+	unused []RadarTrack
+	// Released storage, indexed by its length.
+	free map[int][][]RadarTrack
+}
+
+// Number of TrackHistories that share a slab.
+const trackSlabHistories = 256
+
+func allocateTracks(n int) []RadarTrack {
+	trackSlab.Lock()
+	defer trackSlab.Unlock()
+
+	if free := trackSlab.free[n]; len(free) > 0 {
+		t := free[len(free)-1]
+		trackSlab.free[n] = free[:len(free)-1]
+		return t
+	}
+
+	if len(trackSlab.unused) < n {
+		trackSlab.unused = make([]RadarTrack, trackSlabHistories*n)
+	}
+	t := trackSlab.unused[:n:n]
+	trackSlab.unused = trackSlab.unused[n:]
+	return t
+}
+
+func releaseTracks(t []RadarTrack) {
+	trackSlab.Lock()
+	defer trackSlab.Unlock()
+
+	if trackSlab.free == nil {
+		trackSlab.free = make(map[int][][]RadarTrack)
+	}
+	trackSlab.free[len(t)] = append(trackSlab.free[len(t)], t)
+}
+
+// Add adds the given track as the most recent one, replacing the oldest
+// track if the history is full.
+func (h *TrackHistory) Add(t RadarTrack) {
+	if h.tracks == nil {
+		h.tracks = allocateTracks(trackHistoryLength)
+		h.head = len(h.tracks) - 1
+	}
+
+	h.head++
+	if h.head == len(h.tracks) {
+		h.head = 0
+	}
+	h.tracks[h.head] = t
+	h.n = min(h.n+1, len(h.tracks))
+}
+
+// Release makes the history's storage available for other aircraft's
+// tracks; the history is empty afterward.  It should be called when an
+// aircraft is removed.
+func (h *TrackHistory) Release() {
+	if h.tracks != nil {
+		releaseTracks(h.tracks)
+	}
+	*h = TrackHistory{}
+}
+
+// Len returns the number of tracks stored.
+func (h *TrackHistory) Len() int { return h.n }
+
+// Capacity returns the maximum number of tracks that are stored.
+func (h *TrackHistory) Capacity() int {
+	if h.tracks == nil {
+		return trackHistoryLength
+	}
+	return len(h.tracks)
+}
+
+// At returns the i'th most recent track, where 0 is the most recent.  If
+// there aren't that many tracks, the zero RadarTrack is returned.
+func (h *TrackHistory) At(i int) RadarTrack {
+	if i < 0 || i >= h.n {
+		return RadarTrack{}
+	}
+	return h.tracks[h.index(i)]
+}
+
+func (h *TrackHistory) index(i int) int {
+	idx := h.head - i
+	if idx < 0 {
+		idx += len(h.tracks)
+	}
+	return idx
+}
+
+// Duplicate returns a copy of the history with its own storage.
+func (h *TrackHistory) Duplicate() TrackHistory {
+	d := TrackHistory{head: h.head, n: h.n}
+	if h.tracks != nil {
+		d.tracks = allocateTracks(len(h.tracks))
+		copy(d.tracks, h.tracks)
+	}
+	return d
+}
+
+// Iterate returns a TrackIterator that visits the n most recent tracks
+// (or all of them, if fewer are stored), starting with the most recent.
+func (h *TrackHistory) Iterate(n int) TrackIterator {
+	n = min(n, h.n)
+	return TrackIterator{h: h, i: -1, end: n, step: 1}
+}
+
+// IterateOldestFirst returns a TrackIterator that visits the n most
+// recent tracks (or all of them, if fewer are stored), starting with the
+// oldest of them.
+func (h *TrackHistory) IterateOldestFirst(n int) TrackIterator {
+	n = min(n, h.n)
+	return TrackIterator{h: h, i: n, end: -1, step: -1}
+}
+
+// TrackIterator walks over the tracks in a TrackHistory without copying
+// them. Typical usage is:
+//
+//	for it := ac.Tracks.Iterate(n); it.Next(); {
+//		t := it.Track()
+//		...
+//	}
+type TrackIterator struct {
+	h            *TrackHistory
+	i, end, step int
+}
+
+// Next advances to the next track, returning false if there are no more.
+func (it *TrackIterator) Next() bool {
+	it.i += it.step
+	return it.i != it.end
+}
+
+// Index returns the current track's index, where 0 is the most recent.
+func (it *TrackIterator) Index() int { return it.i }
+
+// Track returns a pointer to the current track; it may be used to modify
+// it in place.
+func (it *TrackIterator) Track() *RadarTrack {
+	return &it.h.tracks[it.h.index(it.i)]
+}
+
 type FlightRules int
 
 const (
@@ -198,7 +387,7 @@ type Aircraft struct {
 	VoiceCapability VoiceCapability
 	FlightPlan      *FlightPlan
 
-	Tracks [10]RadarTrack
+	Tracks TrackHistory
 
 	TrackingController        string
 	InboundHandoffController  string
@@ -320,17 +509,18 @@ func (v VoiceCapability) String() string {
 }
 
 func (a *Aircraft) Altitude() int {
-	return a.Tracks[0].Altitude
+	return a.Tracks.At(0).Altitude
 }
 
 // Reported in feet per minute
 func (a *Aircraft) AltitudeChange() int {
-	if a.Tracks[0].Position.IsZero() || a.Tracks[1].Position.IsZero() {
+	t0, t1 := a.Tracks.At(0), a.Tracks.At(1)
+	if t0.Position.IsZero() || t1.Position.IsZero() {
 		return 0
 	}
 
-	dt := a.Tracks[0].Time.Sub(a.Tracks[1].Time)
-	return int(float64(a.Tracks[0].Altitude-a.Tracks[1].Altitude) / dt.Minutes())
+	dt := t0.Time.Sub(t1.Time)
+	return int(float64(t0.Altitude-t1.Altitude) / dt.Minutes())
 }
 
 func (a *Aircraft) HaveTrack() bool {
@@ -338,28 +528,26 @@ func (a *Aircraft) HaveTrack() bool {
 }
 
 func (a *Aircraft) Position() Point2LL {
-	return a.Tracks[0].Position
+	return a.Tracks.At(0).Position
 }
 
 func (a *Aircraft) InterpolatedPosition(t float32) Point2LL {
 	// Return the first valid one; this makes things cleaner at the start when
 	// we don't have a full set of track history.
 	pos := func(idx int) Point2LL {
-		if idx >= len(a.Tracks) {
+		n := a.Tracks.Len()
+		if idx < n {
+			return a.Tracks.At(idx).Position
+		} else if n < a.Tracks.Capacity() || n < 2 {
+			// We don't have a full set of history yet.
+			return a.Tracks.At(n - 1).Position
+		} else {
 			// Linearly extrapolate the last two. (We don't expect to be
 			// doing this often...)
-			steps := 1 + idx - len(a.Tracks)
-			last := len(a.Tracks) - 1
-			v := sub2ll(a.Tracks[last].Position, a.Tracks[last-1].Position)
-			return add2ll(a.Tracks[last].Position, scale2ll(v, float32(steps)))
-		}
-		for idx > 0 {
-			if !a.Tracks[idx].Position.IsZero() {
-				break
-			}
-			idx--
+			steps := 1 + idx - n
+			last, prev := a.Tracks.At(n-1).Position, a.Tracks.At(n-2).Position
+			return add2ll(last, scale2ll(sub2ll(last, prev), float32(steps)))
 		}
-		return a.Tracks[idx].Position
 	}
 
 	if t < 0 {
@@ -391,7 +579,7 @@ func (a *Aircraft) InterpolatedPosition(t float32) Point2LL {
 }
 
 func (a *Aircraft) GroundSpeed() int {
-	return a.Tracks[0].Groundspeed
+	return a.Tracks.At(0).Groundspeed
 }
 
 // Note: returned value includes the magnetic correction
@@ -409,7 +597,7 @@ func (a *Aircraft) HeadingVector() Point2LL {
 		return Point2LL{}
 	}
 
-	p0, p1 := a.Tracks[0].Position, a.Tracks[1].Position
+	p0, p1 := a.Tracks.At(0).Position, a.Tracks.At(1).Position
 	v := sub2ll(p0, p1)
 	nm := nmlength2ll(v)
 	// v's length should be groundspeed / 60 nm.
@@ -417,14 +605,14 @@ func (a *Aircraft) HeadingVector() Point2LL {
 }
 
 func (a *Aircraft) HaveHeading() bool {
-	return !a.Tracks[0].Position.IsZero() && !a.Tracks[1].Position.IsZero()
+	return !a.Tracks.At(0).Position.IsZero() && !a.Tracks.At(1).Position.IsZero()
 }
 
 func (a *Aircraft) ExtrapolatedHeadingVector(lag float32) Point2LL {
 	if !a.HaveHeading() {
 		return Point2LL{}
 	}
-	t := float32(time.Since(a.Tracks[0].Time).Seconds()) - lag
+	t := float32(time.Since(a.Tracks.At(0).Time).Seconds()) - lag
 	return sub2ll(a.InterpolatedPosition(t+.5), a.InterpolatedPosition(t-0.5))
 }
 
@@ -435,20 +623,17 @@ func (a *Aircraft) HeadingTo(p Point2LL) float32 {
 func (a *Aircraft) LostTrack(now time.Time) bool {
 	// Only return true if we have at least one valid track from the past
 	// but haven't heard from the aircraft recently.
-	return !a.Tracks[0].Position.IsZero() && now.Sub(a.Tracks[0].Time) > 30*time.Second
+	t := a.Tracks.At(0)
+	return !t.Position.IsZero() && now.Sub(t.Time) > 30*time.Second
 }
 
 func (a *Aircraft) AddTrack(t RadarTrack) {
-	// Move everthing forward one to make space for the new one. We could
-	// be clever and use a circular buffer to skip the copies, though at
-	// the cost of more painful indexing elsewhere...
-	copy(a.Tracks[1:], a.Tracks[:len(a.Tracks)-1])
-	a.Tracks[0] = t
+	a.Tracks.Add(t)
 }
 
 func (a *Aircraft) Telephony() string {
 	cs := strings.TrimRight(a.Callsign, "0123456789")
-	if sign, ok := database.callsigns[cs]; ok {
+	if sign, ok := database.FAA.LookupCallsign(cs); ok {
 		return sign.Telephony
 	} else {
 		return ""
@@ -466,7 +651,7 @@ func (a *Aircraft) OnGround() bool {
 
 	if fp := a.FlightPlan; fp != nil {
 		for _, airport := range [2]string{fp.DepartureAirport, fp.ArrivalAirport} {
-			if ap, ok := database.FAA.airports[airport]; ok {
+			if ap, ok := database.FAA.LookupAirport(airport); ok {
 				heightAGL := abs(a.Altitude() - ap.Elevation)
 				return heightAGL < 100
 			}
@@ -559,37 +744,219 @@ type Conflict struct {
 	limits   RangeLimits
 }
 
+// GetConflicts returns all of the pairs of the given aircraft that are
+// closer than the given range limits.
 func GetConflicts(aircraft []*Aircraft, rangeLimits [NumRangeTypes]RangeLimits) (warning []Conflict, violation []Conflict) {
-	for i, ac1 := range aircraft {
-		for j := i + 1; j < len(aircraft); j++ {
-			ac2 := aircraft[j]
-
-			var r RangeLimits
-			if ac1.FlightPlan != nil && ac1.FlightPlan.Rules == IFR {
-				if ac2.FlightPlan != nil && ac2.FlightPlan.Rules == IFR {
-					r = rangeLimits[IFR_IFR]
-				} else {
-					r = rangeLimits[IFR_VFR]
-				}
-			} else {
-				if ac2.FlightPlan != nil && ac2.FlightPlan.Rules == IFR {
-					r = rangeLimits[IFR_VFR]
-				} else {
-					r = rangeLimits[VFR_VFR]
+	var cd ConflictDetector
+	return cd.Update(aircraft, rangeLimits)
+}
+
+// checkConflict checks whether the two aircraft are in conflict given the
+// range limits, returning the Conflict and whether it is a violation (vs.
+// a warning) if so.
+func checkConflict(ac1, ac2 *Aircraft, rangeLimits [NumRangeTypes]RangeLimits) (c Conflict, violation bool, ok bool) {
+	var r RangeLimits
+	if ac1.FlightPlan != nil && ac1.FlightPlan.Rules == IFR {
+		if ac2.FlightPlan != nil && ac2.FlightPlan.Rules == IFR {
+			r = rangeLimits[IFR_IFR]
+		} else {
+			r = rangeLimits[IFR_VFR]
+		}
+	} else {
+		if ac2.FlightPlan != nil && ac2.FlightPlan.Rules == IFR {
+			r = rangeLimits[IFR_VFR]
+		} else {
+			r = rangeLimits[VFR_VFR]
+		}
+	}
+
+	c = Conflict{aircraft: [2]*Aircraft{ac1, ac2}, limits: r}
+	ldist := nmdistance2ll(ac1.Position(), ac2.Position())
+	vdist := int32(abs(ac1.Altitude() - ac2.Altitude()))
+	if ldist < r.ViolationLateral && vdist < r.ViolationVertical {
+		return c, true, true
+	} else if ldist < r.WarningLateral && vdist < r.WarningVertical {
+		return c, false, true
+	}
+	return Conflict{}, false, false
+}
+
+// ConflictDetector finds conflicts between aircraft incrementally: it
+// keeps the conflicts found in previous calls to Update and only checks
+// the aircraft whose tracks have changed since then.  Further, a uniform
+// grid in nm space is used so that each such aircraft is only checked
+// against the ones that are nearby.
+type ConflictDetector struct {
+	rangeLimits                   [NumRangeTypes]RangeLimits
+	nmPerLatitude, nmPerLongitude float32
+	// Grid cell size, in nm.
+	cellSize float32
+
+	// The state of each aircraft as of the last update.
+	tracks map[*Aircraft]conflictTrack
+	// For each aircraft that is in conflict, the other aircraft it's in
+	// conflict with; entries are symmetric.
+	conflicts map[*Aircraft]map[*Aircraft]conflictEntry
+
+	updates    int
+	nextSerial int
+
+	// Returned by Update; reused across calls.
+	warnings, violations []Conflict
+}
+
+// conflictTrack records what an aircraft's conflicts depend on.
+type conflictTrack struct {
+	position Point2LL
+	altitude int
+	ifr      bool
+	// Distinguishes aircraft that were passed to the most recent Update.
+	update int
+	// Set when the aircraft is first seen; used to report each conflict
+	// only once.
+	serial int
+}
+
+type conflictEntry struct {
+	conflict  Conflict
+	violation bool
+}
+
+func (cd *ConflictDetector) unlink(ac *Aircraft) {
+	for other := range cd.conflicts[ac] {
+		delete(cd.conflicts[other], ac)
+		if len(cd.conflicts[other]) == 0 {
+			delete(cd.conflicts, other)
+		}
+	}
+	delete(cd.conflicts, ac)
+}
+
+func (cd *ConflictDetector) link(ac1, ac2 *Aircraft, e conflictEntry) {
+	for _, p := range [2][2]*Aircraft{{ac1, ac2}, {ac2, ac1}} {
+		m, ok := cd.conflicts[p[0]]
+		if !ok {
+			m = make(map[*Aircraft]conflictEntry)
+			cd.conflicts[p[0]] = m
+		}
+		m[p[1]] = e
+	}
+}
+
+func (cd *ConflictDetector) cell(p Point2LL) [2]int32 {
+	return [2]int32{int32(floor(p[0] * cd.nmPerLongitude / cd.cellSize)),
+		int32(floor(p[1] * cd.nmPerLatitude / cd.cellSize))}
+}
+
+// Update returns the conflicts between the provided aircraft; the
+// returned slices are only valid until the next call to Update.
+func (cd *ConflictDetector) Update(aircraft []*Aircraft, rangeLimits [NumRangeTypes]RangeLimits) (warning []Conflict, violation []Conflict) {
+	// Start from scratch if anything that affects all of the results has
+	// changed.
+	if cd.tracks == nil || rangeLimits != cd.rangeLimits ||
+		database.NmPerLatitude != cd.nmPerLatitude || database.NmPerLongitude != cd.nmPerLongitude {
+		cd.rangeLimits = rangeLimits
+		cd.nmPerLatitude, cd.nmPerLongitude = database.NmPerLatitude, database.NmPerLongitude
+		cd.tracks = make(map[*Aircraft]conflictTrack)
+		cd.conflicts = make(map[*Aircraft]map[*Aircraft]conflictEntry)
+
+		cd.cellSize = 0
+		for _, r := range rangeLimits {
+			cd.cellSize = max(cd.cellSize, max(r.WarningLateral, r.ViolationLateral))
+		}
+	}
+
+	// Find the aircraft that are new or have changed since the last
+	// update.
+	cd.updates++
+	var changed []*Aircraft
+	for _, ac := range aircraft {
+		state := conflictTrack{
+			position: ac.Position(),
+			altitude: ac.Altitude(),
+			ifr:      ac.FlightPlan != nil && ac.FlightPlan.Rules == IFR,
+			update:   cd.updates,
+		}
+		if prev, ok := cd.tracks[ac]; ok {
+			state.serial = prev.serial
+			if prev.position != state.position || prev.altitude != state.altitude || prev.ifr != state.ifr {
+				changed = append(changed, ac)
+			}
+		} else {
+			state.serial = cd.nextSerial
+			cd.nextSerial++
+			changed = append(changed, ac)
+		}
+		cd.tracks[ac] = state
+	}
+
+	// Forget about aircraft that weren't passed in this time.
+	for ac, t := range cd.tracks {
+		if t.update != cd.updates {
+			cd.unlink(ac)
+			delete(cd.tracks, ac)
+		}
+	}
+
+	if len(changed) > 0 && cd.cellSize > 0 {
+		// The cached conflicts for the changed aircraft are stale.
+		for _, ac := range changed {
+			cd.unlink(ac)
+		}
+
+		// Broad phase: bin all of the aircraft into grid cells that are
+		// as large as the largest lateral limit, so that any aircraft in
+		// conflict with one in a given cell must be in that cell or one
+		// of its neighbors.
+		grid := make(map[[2]int32][]*Aircraft)
+		for _, ac := range aircraft {
+			c := cd.cell(ac.Position())
+			grid[c] = append(grid[c], ac)
+		}
+
+		for _, ac1 := range changed {
+			t1 := cd.tracks[ac1]
+			cell := cd.cell(ac1.Position())
+			for dy := int32(-1); dy <= 1; dy++ {
+				for dx := int32(-1); dx <= 1; dx++ {
+					for _, ac2 := range grid[[2]int32{cell[0] + dx, cell[1] + dy}] {
+						if ac2 == ac1 {
+							continue
+						}
+						if _, ok := cd.conflicts[ac1][ac2]; ok {
+							// Already found when ac2 was checked.
+							continue
+						}
+
+						// Narrow phase
+						if c, v, ok := checkConflict(ac1, ac2, rangeLimits); ok {
+							// Keep the aircraft in a consistent order.
+							if cd.tracks[ac2].serial < t1.serial {
+								c.aircraft[0], c.aircraft[1] = c.aircraft[1], c.aircraft[0]
+							}
+							cd.link(ac1, ac2, conflictEntry{conflict: c, violation: v})
+						}
+					}
 				}
 			}
+		}
+	}
 
-			ldist := nmdistance2ll(ac1.Position(), ac2.Position())
-			vdist := int32(abs(ac1.Altitude() - ac2.Altitude()))
-			if ldist < r.ViolationLateral && vdist < r.ViolationVertical {
-				violation = append(violation,
-					Conflict{aircraft: [2]*Aircraft{ac1, ac2}, limits: r})
-			} else if ldist < r.WarningLateral && vdist < r.WarningVertical {
-				warning = append(warning,
-					Conflict{aircraft: [2]*Aircraft{ac1, ac2}, limits: r})
+	cd.warnings, cd.violations = cd.warnings[:0], cd.violations[:0]
+	for ac1, m := range cd.conflicts {
+		s1 := cd.tracks[ac1].serial
+		for ac2, e := range m {
+			// Each conflict is in the map twice; only report it once.
+			if s1 > cd.tracks[ac2].serial {
+				continue
+			}
+			if e.violation {
+				cd.violations = append(cd.violations, e.conflict)
+			} else {
+				cd.warnings = append(cd.warnings, e.conflict)
 			}
 		}
 	}
 
-	return
+	return cd.warnings, cd.violations
 }
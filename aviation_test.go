@@ -5,6 +5,7 @@
 package main
 
 import (
+	"math/rand"
 	"testing"
 )
 
@@ -39,3 +40,167 @@ func TestParseSquawk(t *testing.T) {
 		}
 	}
 }
+
+func TestConflictDetector(t *testing.T) {
+	savedDatabase := database
+	database = &StaticDatabase{NmPerLatitude: 60, NmPerLongitude: 45}
+	defer func() { database = savedDatabase }()
+
+	var limits [NumRangeTypes]RangeLimits
+	limits[IFR_IFR] = RangeLimits{WarningLateral: 5, WarningVertical: 1000, ViolationLateral: 3, ViolationVertical: 700}
+	limits[IFR_VFR] = RangeLimits{WarningLateral: 2, WarningVertical: 500, ViolationLateral: 1.5, ViolationVertical: 500}
+	limits[VFR_VFR] = RangeLimits{WarningLateral: 1.5, WarningVertical: 500, ViolationLateral: 1, ViolationVertical: 200}
+
+	r := rand.New(rand.NewSource(1))
+	randomize := func(ac *Aircraft) {
+		// Over a roughly 30nm square so that there are plenty of conflicts.
+		ac.AddTrack(RadarTrack{
+			Position: Point2LL{-73 + r.Float32()*.66, 40 + r.Float32()*.5},
+			Altitude: 2000 + r.Intn(3000)})
+	}
+
+	var aircraft []*Aircraft
+	for i := 0; i < 200; i++ {
+		ac := &Aircraft{}
+		if i%3 != 0 {
+			ac.FlightPlan = &FlightPlan{Rules: IFR}
+		}
+		randomize(ac)
+		aircraft = append(aircraft, ac)
+	}
+
+	// Brute-force set of conflicting pairs, keyed in a canonical order.
+	expected := func(ac []*Aircraft) (map[AircraftPair]bool, map[AircraftPair]bool) {
+		w, v := make(map[AircraftPair]bool), make(map[AircraftPair]bool)
+		for i := range ac {
+			for j := i + 1; j < len(ac); j++ {
+				if _, violation, ok := checkConflict(ac[i], ac[j], limits); ok {
+					if violation {
+						v[AircraftPair{ac[i], ac[j]}] = true
+					} else {
+						w[AircraftPair{ac[i], ac[j]}] = true
+					}
+				}
+			}
+		}
+		return w, v
+	}
+	index := make(map[*Aircraft]int)
+	for i, ac := range aircraft {
+		index[ac] = i
+	}
+	canonical := func(c Conflict) AircraftPair {
+		if index[c.aircraft[0]] < index[c.aircraft[1]] {
+			return AircraftPair{c.aircraft[0], c.aircraft[1]}
+		}
+		return AircraftPair{c.aircraft[1], c.aircraft[0]}
+	}
+	check := func(step int, got []Conflict, expected map[AircraftPair]bool, kind string) {
+		seen := make(map[AircraftPair]bool)
+		for _, c := range got {
+			p := canonical(c)
+			if !expected[p] {
+				t.Errorf("step %d: unexpected %s between %d and %d", step, kind, index[p.a], index[p.b])
+			}
+			if seen[p] {
+				t.Errorf("step %d: %s between %d and %d reported twice", step, kind, index[p.a], index[p.b])
+			}
+			seen[p] = true
+		}
+		if len(seen) != len(expected) {
+			t.Errorf("step %d: got %d %ss, expected %d", step, len(seen), kind, len(expected))
+		}
+	}
+
+	var cd ConflictDetector
+	for step := 0; step < 20; step++ {
+		// Move some of the aircraft and drop a few from the set passed
+		// to Update.
+		var current []*Aircraft
+		for _, ac := range aircraft {
+			if r.Intn(4) == 0 {
+				randomize(ac)
+			}
+			if r.Intn(10) != 0 {
+				current = append(current, ac)
+			}
+		}
+
+		warnings, violations := cd.Update(current, limits)
+		ew, ev := expected(current)
+		check(step, warnings, ew, "warning")
+		check(step, violations, ev, "violation")
+	}
+}
+
+func TestTrackHistory(t *testing.T) {
+	var h TrackHistory
+	if h.Len() != 0 || !h.At(0).Position.IsZero() {
+		t.Errorf("empty history has tracks")
+	}
+
+	n := h.Capacity()
+	for i := 1; i <= n+5; i++ {
+		h.Add(RadarTrack{Altitude: i})
+
+		if h.Len() != min(i, n) {
+			t.Errorf("after %d adds: got length %d", i, h.Len())
+		}
+		for j := 0; j < h.Len(); j++ {
+			if h.At(j).Altitude != i-j {
+				t.Errorf("after %d adds: track %d has altitude %d, expected %d", i, j, h.At(j).Altitude, i-j)
+			}
+		}
+		if h.At(h.Len()).Altitude != 0 {
+			t.Errorf("after %d adds: got track past the end", i)
+		}
+	}
+
+	d := h.Duplicate()
+	for it := d.Iterate(3); it.Next(); {
+		it.Track().Altitude = -1
+	}
+	if h.At(0).Altitude < 0 {
+		t.Errorf("Duplicate shares storage")
+	}
+
+	var recent []int
+	for it := d.Iterate(5); it.Next(); {
+		recent = append(recent, it.Track().Altitude)
+	}
+	var oldest []int
+	for it := d.IterateOldestFirst(5); it.Next(); {
+		oldest = append(oldest, it.Track().Altitude)
+	}
+	top := n + 5
+	expectRecent := []int{-1, -1, -1, top - 3, top - 4}
+	expectOldest := []int{top - 4, top - 3, -1, -1, -1}
+	if !SliceEqual(recent, expectRecent) {
+		t.Errorf("Iterate: got %v, expected %v", recent, expectRecent)
+	}
+	if !SliceEqual(oldest, expectOldest) {
+		t.Errorf("IterateOldestFirst: got %v, expected %v", oldest, expectOldest)
+	}
+}
+
+func TestTrackHistoryRelease(t *testing.T) {
+	var h TrackHistory
+	h.Add(RadarTrack{Altitude: 1000})
+	storage := &h.tracks[0]
+
+	h.Release()
+	if h.Len() != 0 || h.At(0).Altitude != 0 {
+		t.Errorf("released history still has tracks")
+	}
+
+	// The next history of the same length should reuse the storage.
+	var h2 TrackHistory
+	h2.Add(RadarTrack{Altitude: 2000})
+	if &h2.tracks[0] != storage {
+		t.Errorf("released storage wasn't reused")
+	}
+	if h2.Len() != 1 || h2.At(0).Altitude != 2000 || h2.At(1).Altitude != 0 {
+		t.Errorf("reused storage has unexpected tracks")
+	}
+	h2.Release()
+}
@@ -0,0 +1,265 @@
+// benchmark.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+package main
+
+// This file implements a headless benchmark that replays a recorded
+// VATSIM session as quickly as possible, running the same per-frame
+// update and drawing code as the main loop, but without a window and
+// with rendering disabled.  It is used both by the -benchmark
+// command-line option and by the benchmarks in benchmark_test.go.
+
+import (
+	"fmt"
+	"image"
+	"runtime/metrics"
+	"sort"
+	"strings"
+	"time"
+	"unsafe"
+
+	"github.com/mmp/imgui-go/v4"
+)
+
+///////////////////////////////////////////////////////////////////////////
+// headlessPlatform
+
+// headlessPlatform implements the Platform interface without a window;
+// it reports a fixed display size and no user input.
+type headlessPlatform struct {
+	imguiIO     imgui.IO
+	displaySize [2]float32
+}
+
+func newHeadlessPlatform(io imgui.IO, size [2]int) *headlessPlatform {
+	return &headlessPlatform{
+		imguiIO:     io,
+		displaySize: [2]float32{float32(size[0]), float32(size[1])},
+	}
+}
+
+func (h *headlessPlatform) NewFrame() {
+	h.imguiIO.SetDisplaySize(imgui.Vec2{X: h.displaySize[0], Y: h.displaySize[1]})
+	h.imguiIO.SetDeltaTime(1. / 60.)
+}
+
+func (h *headlessPlatform) ProcessEvents() bool           { return false }
+func (h *headlessPlatform) WaitEvents(time.Duration) bool { return false }
+func (h *headlessPlatform) PostEmptyEvent()               {}
+func (h *headlessPlatform) PostRender()                   {}
+func (h *headlessPlatform) Dispose()                      {}
+func (h *headlessPlatform) ShouldStop() bool              { return false }
+func (h *headlessPlatform) CancelShouldStop()             {}
+func (h *headlessPlatform) SetWindowTitle(text string)    {}
+func (h *headlessPlatform) IsControlFPressed() bool       { return false }
+func (h *headlessPlatform) InputCharacters() string       { return "" }
+func (h *headlessPlatform) EnableVSync(sync bool)         {}
+func (h *headlessPlatform) DisplaySize() [2]float32       { return h.displaySize }
+func (h *headlessPlatform) FramebufferSize() [2]float32   { return h.displaySize }
+func (h *headlessPlatform) GetClipboard() imgui.Clipboard { return nil }
+func (h *headlessPlatform) StartCaptureMouse(e Extent2D)  {}
+func (h *headlessPlatform) EndCaptureMouse()              {}
+
+func (h *headlessPlatform) WindowSize() [2]int {
+	return [2]int{int(h.displaySize[0]), int(h.displaySize[1])}
+}
+
+func (h *headlessPlatform) WindowPosition() [2]int {
+	return [2]int{0, 0}
+}
+
+///////////////////////////////////////////////////////////////////////////
+// headlessRenderer
+
+// headlessRenderer implements the Renderer interface but doesn't draw
+// anything; CommandBuffers are just discarded.
+type headlessRenderer struct {
+	nextTextureID uint32
+}
+
+func (r *headlessRenderer) CreateRGBA8Texture(w, h int, rgba unsafe.Pointer) uint32 {
+	r.nextTextureID++
+	return r.nextTextureID
+}
+
+func (r *headlessRenderer) UpdateRGBA8Texture(id uint32, w, h int, rgba unsafe.Pointer) {}
+
+func (r *headlessRenderer) CreateTextureFromImage(image image.Image, generateMIPs bool) uint32 {
+	r.nextTextureID++
+	return r.nextTextureID
+}
+
+func (r *headlessRenderer) UpdateTextureFromImage(id uint32, image image.Image, generateMIPs bool) {}
+
+func (r *headlessRenderer) RenderCommandBuffer(cb *CommandBuffer) RendererStats {
+	return RendererStats{}
+}
+
+func (r *headlessRenderer) Dispose() {}
+
+///////////////////////////////////////////////////////////////////////////
+// Benchmark
+
+// The size of the (virtual) window that the panes are drawn into.
+var benchmarkDisplaySize = [2]int{1920, 1080}
+
+// BenchmarkResults summarizes the performance of a single benchmark run.
+type BenchmarkResults struct {
+	Messages int
+	Frames   int
+	Elapsed  time.Duration
+
+	// Duration of each frame, sorted from shortest to longest.
+	FrameTimes []time.Duration
+
+	// Number of heap allocations made over the course of the run.
+	Allocs uint64
+	// Largest size of the live heap (including objects that are no
+	// longer reachable but haven't yet been collected) observed at the
+	// end of a frame.
+	PeakHeapBytes uint64
+}
+
+func (r *BenchmarkResults) MessagesPerSecond() float64 {
+	return float64(r.Messages) / r.Elapsed.Seconds()
+}
+
+// FrameTime returns the given percentile (in [0,100]) of the frame
+// times.
+func (r *BenchmarkResults) FrameTime(percentile float64) time.Duration {
+	if len(r.FrameTimes) == 0 {
+		return 0
+	}
+	i := int(percentile / 100 * float64(len(r.FrameTimes)))
+	return r.FrameTimes[clamp(i, 0, len(r.FrameTimes)-1)]
+}
+
+func (r *BenchmarkResults) AllocsPerFrame() float64 {
+	if r.Frames == 0 {
+		return 0
+	}
+	return float64(r.Allocs) / float64(r.Frames)
+}
+
+func (r *BenchmarkResults) String() string {
+	var b strings.Builder
+	fmt.Fprintf(&b, "%d messages, %d frames in %v: %.0f messages/sec\n", r.Messages, r.Frames,
+		r.Elapsed.Round(time.Millisecond), r.MessagesPerSecond())
+	fmt.Fprintf(&b, "frame time: p50 %v p90 %v p99 %v max %v\n", r.FrameTime(50), r.FrameTime(90),
+		r.FrameTime(99), r.FrameTime(100))
+	fmt.Fprintf(&b, "%.1f allocations/frame, peak heap %.2f MB\n", r.AllocsPerFrame(),
+		float64(r.PeakHeapBytes)/(1024*1024))
+	return b.String()
+}
+
+// benchmarkInit initializes all of the global state needed to run
+// benchmarks. If userConfig is true, the user's configuration is used
+// (and thus, their sector file, position file, and window layout);
+// otherwise the default configuration is used.  It returns the imgui
+// context that it created.
+func benchmarkInit(userConfig bool) *imgui.Context {
+	if eventStream == nil {
+		eventStream = NewEventStream()
+	}
+	if lg == nil {
+		lg = NewLogger(false, false, 50000)
+	}
+
+	context := imguiInit()
+
+	server = &DisconnectedATCServer{}
+
+	if userConfig {
+		LoadOrMakeDefaultConfig()
+	} else {
+		loadGlobalConfig([]byte(defaultConfig))
+	}
+
+	dbChan := make(chan *StaticDatabase)
+	go InitializeStaticDatabase(dbChan, globalConfig.SectorFile, globalConfig.PositionFile)
+
+	platform = newHeadlessPlatform(imgui.CurrentIO(), benchmarkDisplaySize)
+	renderer = &headlessRenderer{}
+
+	fontsInit(renderer)
+
+	database = <-dbChan
+
+	wmInit()
+
+	globalConfig.MakeConfigActive(globalConfig.ActivePosition)
+
+	// Just the parts of uiInit() that the panes depend on; in particular,
+	// we don't want to check for a new release.
+	ui.font = GetFont(FontIdentifier{Name: "Roboto Regular", Size: 16})
+	ui.fixedFont = GetFont(FontIdentifier{Name: "Source Code Pro Regular", Size: 16})
+	if ui.errorText == nil {
+		ui.errorText = make(map[string]func() bool)
+	}
+
+	return context
+}
+
+// runReplayBenchmark replays the given session file as quickly as
+// possible, running the message handling, updates, and pane drawing for
+// each frame just as the main loop does.  benchmarkInit must have been
+// called first.
+func runReplayBenchmark(filename string) (*BenchmarkResults, error) {
+	v, err := NewVATSIMReplayServer(filename, 0, 0 /* as fast as possible */)
+	if err != nil {
+		return nil, err
+	}
+	server = v
+
+	results := &BenchmarkResults{Messages: len(v.replayConnection().messages)}
+
+	samples := []metrics.Sample{
+		{Name: "/gc/heap/allocs:objects"},
+		{Name: "/memory/classes/heap/objects:bytes"},
+	}
+	metrics.Read(samples)
+	startAllocs := samples[0].Value.Uint64()
+
+	start := time.Now()
+	for v.Connected() || len(v.backlog) > 0 {
+		frameStart := time.Now()
+
+		benchmarkFrame()
+
+		results.FrameTimes = append(results.FrameTimes, time.Since(frameStart))
+
+		metrics.Read(samples)
+		results.PeakHeapBytes = max(results.PeakHeapBytes, samples[1].Value.Uint64())
+	}
+	results.Elapsed = time.Since(start)
+
+	metrics.Read(samples)
+	results.Allocs = samples[0].Value.Uint64() - startAllocs
+	results.Frames = len(results.FrameTimes)
+	sort.Slice(results.FrameTimes, func(i, j int) bool { return results.FrameTimes[i] < results.FrameTimes[j] })
+
+	// Run one more frame after disconnecting so that the panes see that
+	// all of the aircraft are gone and the next run starts out fresh.
+	server.Disconnect()
+	server = &DisconnectedATCServer{}
+	benchmarkFrame()
+
+	return results, nil
+}
+
+// benchmarkFrame runs the parts of a single iteration of the main loop
+// that don't involve user input or rendering.
+func benchmarkFrame() {
+	server.GetUpdates()
+	positionConfig.Update()
+
+	fontsUpdate(renderer)
+
+	platform.NewFrame()
+	imgui.NewFrame()
+
+	wmDrawPanes(platform, renderer)
+
+	imgui.EndFrame()
+}
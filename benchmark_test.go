@@ -0,0 +1,45 @@
+// benchmark_test.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+package main
+
+import (
+	"path/filepath"
+	"sync"
+	"testing"
+)
+
+var benchmarkInitOnce sync.Once
+
+// BenchmarkReplay runs the headless replay benchmark with each of the
+// session files in testdata/.
+func BenchmarkReplay(b *testing.B) {
+	sessions, err := filepath.Glob(filepath.Join("testdata", "*.vsess"))
+	if err != nil {
+		b.Fatal(err)
+	}
+	if len(sessions) == 0 {
+		b.Skip("no session files found in testdata/")
+	}
+
+	benchmarkInitOnce.Do(func() { benchmarkInit(false) })
+
+	for _, session := range sessions {
+		b.Run(filepath.Base(session), func(b *testing.B) {
+			var r *BenchmarkResults
+			for i := 0; i < b.N; i++ {
+				var err error
+				if r, err = runReplayBenchmark(session); err != nil {
+					b.Fatal(err)
+				}
+			}
+
+			b.ReportMetric(r.MessagesPerSecond(), "msgs/s")
+			b.ReportMetric(float64(r.FrameTime(50).Microseconds()), "p50-µs/frame")
+			b.ReportMetric(float64(r.FrameTime(99).Microseconds()), "p99-µs/frame")
+			b.ReportMetric(r.AllocsPerFrame(), "allocs/frame")
+			b.ReportMetric(float64(r.PeakHeapBytes)/(1024*1024), "peak-heap-MB")
+		})
+	}
+}
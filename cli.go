@@ -128,7 +128,7 @@ func (cli *CLIPane) Duplicate(nameAsCopy bool) Pane {
 		font:           cli.font,
 		console:        NewRingBuffer[*ConsoleEntry](consoleLimit),
 		errorCount:     make(map[string]int),
-		eventsId:       eventStream.Subscribe(),
+		eventsId:       eventStream.Subscribe(cliEventTypes...),
 	}
 }
 
@@ -147,7 +147,7 @@ func (cli *CLIPane) Activate() {
 		lg.RegisterErrorMonitor(cli)
 	}
 
-	cli.eventsId = eventStream.Subscribe()
+	cli.eventsId = eventStream.Subscribe(cliEventTypes...)
 
 	checkCommands(cliCommands)
 }
@@ -190,6 +190,10 @@ func (cli *CLIPane) ErrorReported(msg string) {
 
 func (cli *CLIPane) CanTakeKeyboardFocus() bool { return true }
 
+// cliEventTypes lists the events that the CLIPane handles in processEvents.
+var cliEventTypes = []EventType{SelectedAircraftEventType, PointOutEventType, OfferedHandoffEventType,
+	AcceptedHandoffEventType, RejectedHandoffEventType, CanceledHandoffEventType, TextMessageEventType}
+
 func (cli *CLIPane) processEvents(es *EventStream) {
 	for _, event := range es.Get(cli.eventsId) {
 		switch v := event.(type) {
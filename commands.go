@@ -1126,7 +1126,7 @@ func (*PRDCommand) Run(cmd string, ac *Aircraft, ctrl *Controller, args []string
 		arrive = arrive[1:]
 	}
 
-	if prdEntries, ok := database.FAA.prd[AirportPair{depart, arrive}]; !ok {
+	if prdEntries, ok := database.FAA.LookupPRD(depart, arrive); !ok {
 		return ErrorStringConsoleEntry(fmt.Sprintf(depart + "-" + arrive + ": no entry in FAA PRD"))
 	} else {
 		anyType := false
@@ -1414,18 +1414,18 @@ func (*InfoCommand) Run(cmd string, ac *Aircraft, ctrl *Controller, args []strin
 
 		// e.g. "fft" matches both a VOR and a callsign, so report both...
 		var info []string
-		if navaid, ok := database.FAA.navaids[name]; ok {
+		if navaid, ok := database.FAA.LookupNavaid(name); ok {
 			info = append(info, fmt.Sprintf("%s: %s %s %s", name, stopShouting(navaid.Name),
 				navaid.Type, navaid.Location.DMSString()))
 		}
-		if fix, ok := database.FAA.fixes[name]; ok {
+		if fix, ok := database.FAA.LookupFix(name); ok {
 			info = append(info, fmt.Sprintf("%s: Fix %s", name, fix.Location.DMSString()))
 		}
-		if ap, ok := database.FAA.airports[name]; ok {
+		if ap, ok := database.FAA.LookupAirport(name); ok {
 			info = append(info, fmt.Sprintf("%s: %s: %s, alt %d", name, stopShouting(ap.Name),
 				ap.Location.DMSString(), ap.Elevation))
 		}
-		if cs, ok := database.callsigns[name]; ok {
+		if cs, ok := database.FAA.LookupCallsign(name); ok {
 			info = append(info, fmt.Sprintf("%s: %s (%s)", name, cs.Telephony, cs.Company))
 		}
 		if ct := server.GetController(name); ct != nil {
@@ -17,6 +17,7 @@ import (
 	"reflect"
 	"strconv"
 	"strings"
+	"sync"
 	"time"
 
 	"github.com/mmp/imgui-go/v4"
@@ -43,6 +44,11 @@ type GlobalConfig struct {
 	InitialWindowPosition [2]int
 	ImGuiSettings         string
 	AudioSettings         AudioSettings
+	// Number of radar tracks stored for each aircraft; zero selects the
+	// default.
+	TrackHistoryLength int
+	// If set, the configuration is periodically saved if it has changed.
+	Autosave bool
 
 	aliases map[string]string
 
@@ -259,6 +265,17 @@ func configFilePath() string {
 }
 
 func (gc *GlobalConfig) Encode(w io.Writer) error {
+	// Discard cached encodings of PositionConfigs that have been deleted.
+	for pc := range encodedPositionConfigs {
+		found := false
+		for _, c := range gc.PositionConfigs {
+			found = found || c == pc
+		}
+		if !found {
+			delete(encodedPositionConfigs, pc)
+		}
+	}
+
 	enc := json.NewEncoder(w)
 	enc.SetIndent("", "    ")
 	return enc.Encode(gc)
@@ -266,13 +283,141 @@ func (gc *GlobalConfig) Encode(w io.Writer) error {
 
 func (c *GlobalConfig) Save() error {
 	lg.Printf("Saving config to: %s", configFilePath())
-	f, err := os.Create(configFilePath())
-	if err != nil {
+
+	var b bytes.Buffer
+	if err := c.Encode(&b); err != nil {
 		return err
 	}
-	defer f.Close()
+	return configSaver.Write(b.Bytes())
+}
+
+// MaybeAutosave should be called periodically; if autosave is enabled and
+// it has been long enough since the last check, it encodes the current
+// configuration and then has it written to disk in the background if it
+// has changed.
+func (gc *GlobalConfig) MaybeAutosave() {
+	if !gc.Autosave || time.Since(configSaver.lastCheck) < configAutosaveInterval {
+		return
+	}
+	configSaver.lastCheck = time.Now()
+
+	var b bytes.Buffer
+	if err := gc.Encode(&b); err != nil {
+		lg.Errorf("unable to encode config: %v", err)
+		return
+	}
+	configSaver.Schedule(b.Bytes())
+}
+
+const (
+	configAutosaveInterval = 30 * time.Second
+	// How long ConfigSaver waits after a save is requested before writing
+	// the file, so that bursts of requests only lead to a single write.
+	configSaveDelay = 2 * time.Second
+)
+
+// ConfigSaver handles writing JSON-encoded configurations to the config
+// file. Writes are atomic, so a crash while saving doesn't lose the
+// previous configuration, and they can be done in the background, so
+// that autosaves don't stall the main thread.
+type ConfigSaver struct {
+	// The file to write to; if empty, configFilePath() is used.
+	filename string
+
+	// Protects pending, timer, and lastWritten.
+	mu      sync.Mutex
+	pending []byte
+	timer   *time.Timer
+	// The last configuration that was successfully written.
+	lastWritten []byte
+
+	// Held while writing the file so that writes are never reordered.
+	writeMu sync.Mutex
+
+	// Only accessed on the main thread: when MaybeAutosave last checked
+	// the configuration.
+	lastCheck time.Time
+}
+
+var configSaver ConfigSaver
+
+func (s *ConfigSaver) path() string {
+	if s.filename != "" {
+		return s.filename
+	}
+	return configFilePath()
+}
+
+// Schedule arranges for the given configuration to be written in the
+// background; if another one is scheduled before it is written, only the
+// newer one is written.  Nothing is done if the configuration is the same
+// as the one that was last written or that is already scheduled.  If a
+// write fails, the next call to Schedule tries again.
+func (s *ConfigSaver) Schedule(contents []byte) {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	if s.pending != nil && bytes.Equal(contents, s.pending) {
+		return
+	} else if s.pending == nil && bytes.Equal(contents, s.lastWritten) {
+		return
+	}
+
+	s.pending = contents
+	if s.timer == nil {
+		s.timer = time.AfterFunc(configSaveDelay, s.writePending)
+	} else {
+		s.timer.Reset(configSaveDelay)
+	}
+}
+
+// Write immediately writes the given configuration, superseding any that
+// is scheduled to be written.
+func (s *ConfigSaver) Write(contents []byte) error {
+	s.mu.Lock()
+	s.pending = nil
+	s.mu.Unlock()
 
-	return c.Encode(f)
+	s.writeMu.Lock()
+	defer s.writeMu.Unlock()
+	return s.write(contents)
+}
+
+// Flush writes the scheduled configuration, if any, before returning.
+func (s *ConfigSaver) Flush() {
+	s.writePending()
+}
+
+func (s *ConfigSaver) writePending() {
+	s.writeMu.Lock()
+	defer s.writeMu.Unlock()
+
+	s.mu.Lock()
+	contents := s.pending
+	s.pending = nil
+	s.mu.Unlock()
+
+	if contents != nil {
+		fn := s.path()
+		if err := s.write(contents); err != nil {
+			lg.Errorf("%s: unable to save config: %v", fn, err)
+		} else {
+			lg.Printf("%s: saved config", fn)
+		}
+	}
+}
+
+// write writes the configuration to the file; the caller must hold
+// writeMu.
+func (s *ConfigSaver) write(contents []byte) error {
+	if err := writeFileAtomically(s.path(), contents); err != nil {
+		return err
+	}
+
+	s.mu.Lock()
+	s.lastWritten = contents
+	s.mu.Unlock()
+	return nil
 }
 
 func (gc *GlobalConfig) MakeConfigActive(name string) {
@@ -300,6 +445,9 @@ func (gc *GlobalConfig) MakeConfigActive(name string) {
 	if oldConfig != nil && oldConfig != positionConfig {
 		oldConfig.Deactivate()
 	}
+	// The previously-active config may have been modified since it was
+	// last encoded.
+	delete(encodedPositionConfigs, oldConfig)
 
 	wmActivateNewConfig(oldConfig, positionConfig)
 
@@ -310,6 +458,8 @@ func (gc *GlobalConfig) MakeConfigActive(name string) {
 }
 
 func (gc *GlobalConfig) PromptToSaveIfChanged(renderer Renderer, platform Platform) bool {
+	configSaver.Flush()
+
 	fn := configFilePath()
 	onDisk, err := os.ReadFile(fn)
 	if err != nil {
@@ -345,7 +495,7 @@ func (pc *PositionConfig) Activate() {
 		pc.Frequencies = make(map[string]Frequency)
 	}
 	if pc.eventsId == InvalidEventSubscriberId {
-		pc.eventsId = eventStream.Subscribe()
+		pc.eventsId = eventStream.Subscribe(SelectedAircraftEventType)
 	}
 
 	pc.CheckRadarCenters()
@@ -591,6 +741,30 @@ func (c *PositionConfig) DrawRadioUI() {
 		})
 }
 
+// Encoding the PositionConfigs, including their Pane hierarchies, is most
+// of the work of encoding the GlobalConfig. Only the active one can be
+// modified, so the encodings of the others are cached until they are next
+// activated.
+var encodedPositionConfigs = make(map[*PositionConfig]json.RawMessage)
+
+// positionConfigJSON has the same fields as PositionConfig but not its
+// MarshalJSON method, so that it can be used to do the actual encoding.
+type positionConfigJSON PositionConfig
+
+func (c *PositionConfig) MarshalJSON() ([]byte, error) {
+	if c == positionConfig {
+		return json.Marshal((*positionConfigJSON)(c))
+	} else if enc, ok := encodedPositionConfigs[c]; ok {
+		return enc, nil
+	}
+
+	enc, err := json.Marshal((*positionConfigJSON)(c))
+	if err == nil {
+		encodedPositionConfigs[c] = enc
+	}
+	return enc, err
+}
+
 func (c *PositionConfig) Duplicate() *PositionConfig {
 	nc := &PositionConfig{}
 	*nc = *c
@@ -628,6 +802,12 @@ func LoadOrMakeDefaultConfig() {
 		}
 	}
 
+	loadGlobalConfig(config)
+}
+
+// loadGlobalConfig initializes globalConfig from the given JSON-encoded
+// configuration.
+func loadGlobalConfig(config []byte) {
 	r := bytes.NewReader(config)
 	d := json.NewDecoder(r)
 
@@ -638,6 +818,9 @@ func LoadOrMakeDefaultConfig() {
 	if globalConfig.CustomServers == nil {
 		globalConfig.CustomServers = make(map[string]string)
 	}
+	if globalConfig.TrackHistoryLength > 0 {
+		SetTrackHistoryLength(globalConfig.TrackHistoryLength)
+	}
 
 	globalConfig.LoadAliasesFile()
 	globalConfig.LoadNotesFile()
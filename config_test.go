@@ -0,0 +1,122 @@
+// config_test.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+package main
+
+import (
+	"encoding/json"
+	"os"
+	"path"
+	"runtime"
+	"testing"
+)
+
+func TestConfigSaver(t *testing.T) {
+	if lg == nil {
+		lg = NewLogger(false, false, 100)
+	}
+
+	dir := t.TempDir()
+	s := &ConfigSaver{filename: path.Join(dir, "config.json")}
+
+	check := func(expected string) {
+		t.Helper()
+		if b, err := os.ReadFile(s.filename); err != nil {
+			t.Errorf("unable to read config: %v", err)
+		} else if string(b) != expected {
+			t.Errorf("got config %q, expected %q", string(b), expected)
+		}
+	}
+
+	if err := s.Write([]byte("one")); err != nil {
+		t.Fatalf("Write: %v", err)
+	}
+	check("one")
+
+	// Only the most recently scheduled configuration is written.
+	s.Schedule([]byte("two"))
+	s.Schedule([]byte("three"))
+	s.Flush()
+	check("three")
+
+	// Scheduling the configuration that was just written is a no-op.
+	s.Schedule([]byte("three"))
+	if s.pending != nil {
+		t.Errorf("unchanged config was scheduled")
+	}
+
+	// A write supersedes a scheduled one.
+	s.Schedule([]byte("four"))
+	if err := s.Write([]byte("five")); err != nil {
+		t.Fatalf("Write: %v", err)
+	}
+	s.Flush()
+	check("five")
+
+	if runtime.GOOS != "windows" {
+		// The existing file's permissions are preserved.
+		if err := os.Chmod(s.filename, 0o640); err != nil {
+			t.Fatalf("Chmod: %v", err)
+		}
+		if err := s.Write([]byte("six")); err != nil {
+			t.Fatalf("Write: %v", err)
+		}
+		if fi, err := os.Stat(s.filename); err != nil || fi.Mode().Perm() != 0o640 {
+			t.Errorf("config permissions not preserved: %v %v", fi.Mode(), err)
+		}
+	}
+
+	// After a failed write, scheduling the same configuration again
+	// tries again.
+	s.filename = path.Join(dir, "config.json", "not-a-directory", "config.json")
+	s.Schedule([]byte("seven"))
+	s.Flush()
+	s.filename = path.Join(dir, "config.json")
+	s.Schedule([]byte("seven"))
+	s.Flush()
+	check("seven")
+}
+
+func TestPositionConfigEncodingCache(t *testing.T) {
+	active, inactive := &PositionConfig{ControllerATIS: "a"}, &PositionConfig{ControllerATIS: "b"}
+	saved := positionConfig
+	positionConfig = active
+	defer func() {
+		positionConfig = saved
+		delete(encodedPositionConfigs, inactive)
+	}()
+
+	encode := func(c *PositionConfig) string {
+		t.Helper()
+		var dec PositionConfig
+		if b, err := json.Marshal(c); err != nil {
+			t.Fatalf("Marshal: %v", err)
+		} else if err := json.Unmarshal(b, &dec); err != nil {
+			t.Fatalf("Unmarshal: %v", err)
+		}
+		return dec.ControllerATIS
+	}
+
+	if atis := encode(inactive); atis != "b" {
+		t.Errorf("got ATIS %q, expected \"b\"", atis)
+	}
+
+	// Inactive configurations can't be modified, so their cached
+	// encodings are used.
+	inactive.ControllerATIS = "c"
+	if atis := encode(inactive); atis != "b" {
+		t.Errorf("got ATIS %q for the inactive config, expected the cached \"b\"", atis)
+	}
+	delete(encodedPositionConfigs, inactive)
+	if atis := encode(inactive); atis != "c" {
+		t.Errorf("got ATIS %q after invalidating the cache, expected \"c\"", atis)
+	}
+
+	// The active configuration is always encoded.
+	encode(active)
+	active.ControllerATIS = "d"
+	if atis := encode(active); atis != "d" {
+		t.Errorf("got ATIS %q for the active config, expected \"d\"", atis)
+	}
+}
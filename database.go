@@ -9,10 +9,13 @@ import (
 	"bytes"
 	_ "embed"
 	"encoding/csv"
+	"errors"
 	"fmt"
 	"io"
+	"math"
 	"os"
 	"runtime/debug"
+	"sort"
 	"strconv"
 	"strings"
 	"sync"
@@ -28,13 +31,7 @@ import (
 // the sector file, and the position file.
 type StaticDatabase struct {
 	// From the FAA (et al.) databases
-	FAA struct {
-		navaids  map[string]Navaid
-		airports map[string]Airport
-		fixes    map[string]Fix
-		prd      map[AirportPair][]PRDEntry
-	}
-	callsigns map[string]Callsign
+	FAA *FAADatabase
 
 	// From the sector file
 	NmPerLatitude     float32
@@ -59,9 +56,12 @@ type StaticDatabase struct {
 	//
 	// These only store geometry; no colors; the caller should set current
 	// RGB based on the active color scheme.
-	runwayCommandBuffer               CommandBuffer
-	lowAirwayCommandBuffer            CommandBuffer
-	highAirwayCommandBuffer           CommandBuffer
+	//
+	// Runways and airways are split into tiles so that they can be culled
+	// like everything else.
+	runwayTiles                       []StaticDrawable
+	lowAirwayTiles                    []StaticDrawable
+	highAirwayTiles                   []StaticDrawable
 	regions                           []StaticDrawable
 	ARTCC                             []StaticDrawable
 	ARTCCLow                          []StaticDrawable
@@ -74,11 +74,37 @@ type StaticDatabase struct {
 	labelColorBufferIndex             ColorBufferIndex
 	labels                            []Label
 
+	// Spatial indices for culling each of the sets of StaticDrawables
+	// above; the NoColor variants share the index of the corresponding
+	// colored ones.
+	runwayIndex, lowAirwayIndex, highAirwayIndex *StaticDrawableIndex
+	regionIndex                                  *StaticDrawableIndex
+	ARTCCIndex, ARTCCLowIndex, ARTCCHighIndex    *StaticDrawableIndex
+	geoIndex, SIDIndex, STARIndex                *StaticDrawableIndex
+
 	// From the position file
 	positions             map[string][]Position // map key is e.g. JFK_TWR
 	positionFileLoadError error
+
+	// Names passed to Locate that are found are interned to LocationIds
+	// that index into locations, so that each one only needs to be
+	// resolved once.
+	// locationGeneration is incremented whenever these are reset (e.g.,
+	// when a new sector file is loaded), which invalidates any ids that
+	// callers are holding on to.  locationMutex protects all three.
+	locationIds        map[string]LocationId
+	locations          []Point2LL
+	locationGeneration int
+	locationMutex      sync.Mutex
 }
 
+// LocationId is a dense integer identifier for a named location that has
+// been resolved by the StaticDatabase.
+type LocationId int32
+
+// InvalidLocationId is returned for names that aren't known.
+const InvalidLocationId LocationId = -1
+
 // Label represents a labeled point on a map.
 type Label struct {
 	name  string
@@ -97,6 +123,152 @@ type StaticDrawable struct {
 	colorBufferIndex ColorBufferIndex
 }
 
+// Maximum number of grid cells along each axis of a StaticDrawableIndex.
+const staticDrawableIndexMaxResolution = 64
+
+// StaticDrawableIndex is a uniform grid over the bounds of a slice of
+// StaticDrawables. It is used to find the ones that overlap the visible
+// region with work proportional to the number that are nearby rather
+// than to the total number of them.
+type StaticDrawableIndex struct {
+	bounds   Extent2D
+	res      [2]int
+	cellSize [2]float32
+	// For each cell, the indices of the drawables whose bounds overlap it,
+	// in increasing order.
+	cells [][]int32
+	// Bounds of each of the drawables.
+	drawableBounds []Extent2D
+}
+
+// NewStaticDrawableIndex returns a StaticDrawableIndex for the provided
+// drawables.  The indices it returns are into the provided slice; the
+// slice must not be modified afterward.
+func NewStaticDrawableIndex(drawables []StaticDrawable) *StaticDrawableIndex {
+	si := &StaticDrawableIndex{bounds: EmptyExtent2D()}
+	for _, sd := range drawables {
+		si.drawableBounds = append(si.drawableBounds, sd.bounds)
+		if sd.bounds.Width() >= 0 && sd.bounds.Height() >= 0 {
+			si.bounds = Union(si.bounds, sd.bounds)
+		}
+	}
+	if si.bounds.Width() < 0 || si.bounds.Height() < 0 {
+		// Nothing to index.
+		return si
+	}
+
+	// Aim for roughly one drawable per cell.
+	r := clamp(int(math.Sqrt(float64(len(drawables)))), 1, staticDrawableIndexMaxResolution)
+	si.res = [2]int{r, r}
+	si.cellSize = [2]float32{max(si.bounds.Width(), 1e-6) / float32(r),
+		max(si.bounds.Height(), 1e-6) / float32(r)}
+	si.cells = make([][]int32, r*r)
+
+	for i, e := range si.drawableBounds {
+		if e.Width() < 0 || e.Height() < 0 {
+			continue
+		}
+		x0, y0, x1, y1 := si.cellRange(e)
+		for y := y0; y <= y1; y++ {
+			for x := x0; x <= x1; x++ {
+				c := x + y*si.res[0]
+				si.cells[c] = append(si.cells[c], int32(i))
+			}
+		}
+	}
+
+	return si
+}
+
+// cellRange returns the range of grid cells that the given extent
+// overlaps; it must overlap the grid's bounds.
+func (si *StaticDrawableIndex) cellRange(e Extent2D) (x0, y0, x1, y1 int) {
+	cell := func(v float32, d int) int {
+		return clamp(int((v-si.bounds.p0[d])/si.cellSize[d]), 0, si.res[d]-1)
+	}
+	return cell(e.p0[0], 0), cell(e.p0[1], 1), cell(e.p1[0], 0), cell(e.p1[1], 1)
+}
+
+// Overlapping appends the indices of the drawables with bounds that
+// overlap the given extent to result, in increasing order, and returns
+// the resulting slice.
+func (si *StaticDrawableIndex) Overlapping(e Extent2D, result []int32) []int32 {
+	if si == nil || len(si.cells) == 0 || !Overlaps(si.bounds, e) {
+		return result
+	}
+
+	start := len(result)
+	x0, y0, x1, y1 := si.cellRange(e)
+	if x0 == 0 && y0 == 0 && x1 == si.res[0]-1 && y1 == si.res[1]-1 {
+		// Everything is potentially visible; skip the cells and just
+		// check all of them.
+		for i, b := range si.drawableBounds {
+			if Overlaps(b, e) {
+				result = append(result, int32(i))
+			}
+		}
+		return result
+	}
+
+	for y := y0; y <= y1; y++ {
+		for x := x0; x <= x1; x++ {
+			for _, i := range si.cells[x+y*si.res[0]] {
+				if Overlaps(si.drawableBounds[i], e) {
+					result = append(result, i)
+				}
+			}
+		}
+	}
+
+	// Drawables that span multiple cells will have been found more than
+	// once; sort so that they're drawn in their original order and then
+	// remove duplicates.
+	found := result[start:]
+	sort.Slice(found, func(i, j int) bool { return found[i] < found[j] })
+	n := 0
+	for i, idx := range found {
+		if i == 0 || idx != found[n-1] {
+			found[n] = idx
+			n++
+		}
+	}
+	return result[:start+n]
+}
+
+// Size of the tiles, in degrees latitude and longitude, that runways and
+// airways are split into.
+const staticLinesTileSize = 0.5
+
+// tiledLines returns a StaticDrawable for each tile in a grid over the
+// given lines that stores the lines whose midpoints are inside it.
+func tiledLines(lines [][2]Point2LL) []StaticDrawable {
+	tileLines := make(map[[2]int]*LinesDrawBuilder)
+	for _, l := range lines {
+		mid := mid2f(l[0], l[1])
+		t := [2]int{int(math.Floor(float64(mid[0] / staticLinesTileSize))),
+			int(math.Floor(float64(mid[1] / staticLinesTileSize)))}
+		ld, ok := tileLines[t]
+		if !ok {
+			ld = &LinesDrawBuilder{}
+			tileLines[t] = ld
+		}
+		ld.AddLine(l[0], l[1])
+	}
+
+	// Sort the tiles so that the results are deterministic.
+	tiles := SortedMapKeysPred(tileLines, func(a *[2]int, b *[2]int) bool {
+		return a[1] < b[1] || (a[1] == b[1] && a[0] < b[0])
+	})
+	var sds []StaticDrawable
+	for _, t := range tiles {
+		ld := tileLines[t]
+		sd := StaticDrawable{bounds: ld.Bounds()}
+		ld.GenerateCommands(&sd.cb)
+		sds = append(sds, sd)
+	}
+	return sds
+}
+
 // ColorBufferIndex provides an efficient encoding of named sections of an
 // RGB buffer used for rendering. More to the point, sector files include
 // various objects that defined by lines where each line has a string
@@ -155,20 +327,9 @@ func InitializeStaticDatabase(dbChan chan *StaticDatabase, sectorFile, positionF
 	start := time.Now()
 
 	db := &StaticDatabase{}
-	var wg sync.WaitGroup
-	wg.Add(1)
-	go func() { db.FAA.navaids = parseNavaids(); wg.Done() }()
-	wg.Add(1)
-	go func() { db.FAA.airports = parseAirports(); wg.Done() }()
-	wg.Add(1)
-	go func() { db.FAA.fixes = parseFixes(); wg.Done() }()
-	wg.Add(1)
-	go func() { db.FAA.prd = parsePRD(); wg.Done() }()
-	wg.Add(1)
-	go func() { db.callsigns = parseCallsigns(); wg.Done() }()
-	wg.Wait()
-
-	lg.Printf("Parsed built-in databases in %v", time.Since(start))
+	db.FAA = InitializeFAADatabase()
+
+	lg.Printf("Initialized built-in databases in %v", time.Since(start))
 
 	// These errors will appear the first time vice is launched and the
 	// user hasn't yet set these up.  (And also if the chosen files are
@@ -371,12 +532,80 @@ func Point2LLFromLL64(latitude, longitude float64) Point2LL {
 
 func (db *StaticDatabase) LoadSectorFile(filename string) error {
 	lg.Printf("%s: loading sector file", filename)
-	sectorFile, err := parseSectorFile(filename)
+	contents, err := os.ReadFile(filename)
 	db.sectorFileLoadError = err
 	if err != nil {
 		return err
 	}
 
+	// Use the cached geometry if it's available and up to date; otherwise
+	// parse the sector file and process it from scratch.
+	if err := db.loadSectorFileCache(filename, contents); err == nil {
+		lg.Printf("%s: using cached sector file", filename)
+	} else {
+		if !errors.Is(err, os.ErrNotExist) {
+			lg.Printf("%s: not using sector file cache: %v", filename, err)
+		}
+
+		sectorFile, err := parseSectorFile(filename, contents)
+		db.sectorFileLoadError = err
+		if err != nil {
+			return err
+		}
+		db.initializeFromSectorFile(sectorFile)
+
+		if err := db.writeSectorFileCache(filename, contents); err != nil {
+			lg.Errorf("%s: unable to write sector file cache: %v", filename, err)
+		}
+	}
+
+	// None of the StaticDrawables' geometry will change (other than their
+	// colors), so the renderer can hold on to it.
+	for _, sds := range [][]StaticDrawable{db.runwayTiles, db.lowAirwayTiles, db.highAirwayTiles,
+		db.regions, db.ARTCC, db.ARTCCLow, db.ARTCCHigh, db.geos, db.geosNoColor,
+		db.SIDs, db.STARs, db.SIDsNoColor, db.STARsNoColor} {
+		for i := range sds {
+			sds[i].cb.MarkStatic()
+		}
+	}
+
+	// Any names resolved using the previous sector file may now be
+	// somewhere else (or nowhere at all.)
+	db.resetLocations()
+
+	// Build the spatial indices now that all of the StaticDrawables are
+	// ready.
+	db.runwayIndex = NewStaticDrawableIndex(db.runwayTiles)
+	db.lowAirwayIndex = NewStaticDrawableIndex(db.lowAirwayTiles)
+	db.highAirwayIndex = NewStaticDrawableIndex(db.highAirwayTiles)
+	db.regionIndex = NewStaticDrawableIndex(db.regions)
+	db.ARTCCIndex = NewStaticDrawableIndex(db.ARTCC)
+	db.ARTCCLowIndex = NewStaticDrawableIndex(db.ARTCCLow)
+	db.ARTCCHighIndex = NewStaticDrawableIndex(db.ARTCCHigh)
+	db.geoIndex = NewStaticDrawableIndex(db.geos)
+	db.SIDIndex = NewStaticDrawableIndex(db.SIDs)
+	db.STARIndex = NewStaticDrawableIndex(db.STARs)
+
+	// Various post-load tidying.
+	for _, scheme := range globalConfig.ColorSchemes {
+		// Add any colors in the sector file that aren't in scopes'
+		// color schemes.
+		for name, color := range db.sectorFileColors {
+			if _, ok := scheme.DefinedColors[name]; !ok {
+				c := color
+				scheme.DefinedColors[name] = &c
+			}
+		}
+	}
+
+	lg.Printf("%s: finished loading sector file", filename)
+
+	return nil
+}
+
+// initializeFromSectorFile initializes all of the fields of the
+// StaticDatabase that are derived from the provided sector file.
+func (db *StaticDatabase) initializeFromSectorFile(sectorFile *sct2.SectorFile) {
 	// Copy over some basic stuff from the sector file
 	db.defaultAirport = strings.TrimSpace(sectorFile.DefaultAirport) // TODO: sct2 should do this
 	db.defaultCenter = Point2LLFromSct2(sectorFile.Center)
@@ -398,7 +627,7 @@ func (db *StaticDatabase) LoadSectorFile(filename string) error {
 
 	// Also clear out all of the things to draw that are derived from the
 	// sector file.
-	db.runwayCommandBuffer = CommandBuffer{}
+	db.runwayTiles = nil
 	db.geos = nil
 	db.geosNoColor = nil
 	db.regions = nil
@@ -408,8 +637,8 @@ func (db *StaticDatabase) LoadSectorFile(filename string) error {
 	db.STARsNoColor = nil
 	db.lowAirwayLabels = nil
 	db.highAirwayLabels = nil
-	db.lowAirwayCommandBuffer = CommandBuffer{}
-	db.highAirwayCommandBuffer = CommandBuffer{}
+	db.lowAirwayTiles = nil
+	db.highAirwayTiles = nil
 	db.labelColorBufferIndex = ColorBufferIndex{}
 	db.labels = nil
 
@@ -528,13 +757,14 @@ func (db *StaticDatabase) LoadSectorFile(filename string) error {
 	}
 
 	// Runway lines
-	rld := LinesDrawBuilder{}
+	var runwayLines [][2]Point2LL
 	for _, runway := range sectorFile.Runways {
 		if runway.P[0].Latitude != 0 || runway.P[0].Longitude != 0 {
-			rld.AddLine(Point2LLFromSct2(runway.P[0]), Point2LLFromSct2(runway.P[1]))
+			runwayLines = append(runwayLines,
+				[2]Point2LL{Point2LLFromSct2(runway.P[0]), Point2LLFromSct2(runway.P[1])})
 		}
 	}
-	rld.GenerateCommands(&db.runwayCommandBuffer)
+	db.runwayTiles = tiledLines(runwayLines)
 
 	// Labels (e.g., taxiways and runways.)
 	db.labelColorBufferIndex = NewColorBufferIndex()
@@ -543,8 +773,8 @@ func (db *StaticDatabase) LoadSectorFile(filename string) error {
 		db.labelColorBufferIndex.Add(label.Color)
 		db.labels = append(db.labels, l)
 	}
-	db.lowAirwayCommandBuffer, db.lowAirwayLabels = getAirwayCommandBuffers(sectorFile.LowAirways)
-	db.highAirwayCommandBuffer, db.highAirwayLabels = getAirwayCommandBuffers(sectorFile.HighAirways)
+	db.lowAirwayTiles, db.lowAirwayLabels = getAirwayDrawables(sectorFile.LowAirways)
+	db.highAirwayTiles, db.highAirwayLabels = getAirwayDrawables(sectorFile.HighAirways)
 
 	// Various things are represented by colored line segments where their
 	// color is either given by a color that is #defined in the sector file
@@ -620,30 +850,9 @@ func (db *StaticDatabase) LoadSectorFile(filename string) error {
 	for _, color := range sectorFile.Colors {
 		db.sectorFileColors[color.Name] = RGB{R: color.R, G: color.G, B: color.B}
 	}
-
-	// Various post-load tidying.
-	for _, scheme := range globalConfig.ColorSchemes {
-		// Add any colors in the sector file that aren't in scopes'
-		// color schemes.
-		for name, color := range db.sectorFileColors {
-			if _, ok := scheme.DefinedColors[name]; !ok {
-				c := color
-				scheme.DefinedColors[name] = &c
-			}
-		}
-	}
-
-	lg.Printf("%s: finished loading sector file", filename)
-
-	return nil
 }
 
-func parseSectorFile(sectorFilename string) (*sct2.SectorFile, error) {
-	contents, err := os.ReadFile(sectorFilename)
-	if err != nil {
-		return nil, err
-	}
-
+func parseSectorFile(sectorFilename string, contents []byte) (*sct2.SectorFile, error) {
 	type SctResult struct {
 		sf  *sct2.SectorFile
 		err error
@@ -693,7 +902,7 @@ func parseSectorFile(sectorFilename string) (*sct2.SectorFile, error) {
 	return r.sf, r.err
 }
 
-func getAirwayCommandBuffers(airways []sct2.Airway) (CommandBuffer, []Label) {
+func getAirwayDrawables(airways []sct2.Airway) ([]StaticDrawable, []Label) {
 	// Airways are tricky since the sector file will have the same segment
 	// multiple times when multiple airways are coincident. We'd like to
 	// have a single label for each such segment that includes all of the
@@ -731,8 +940,8 @@ func getAirwayCommandBuffers(airways []sct2.Airway) (CommandBuffer, []Label) {
 		}
 	}
 
-	// Now get working on the command buffer.
-	lines := LinesDrawBuilder{}
+	// Now get working on the lines.
+	var lines [][2]Point2LL
 	var labels []Label
 	for seg, l := range m {
 		// Join the airway names with slashes and draw them at the midpoint
@@ -742,13 +951,10 @@ func getAirwayCommandBuffers(airways []sct2.Airway) (CommandBuffer, []Label) {
 			Longitude: (seg.P[0].Longitude + seg.P[1].Longitude) / 2}
 		labels = append(labels, Label{name: label, p: Point2LLFromSct2(mid), color: RGB{}})
 
-		lines.AddLine(Point2LLFromSct2(seg.P[0]), Point2LLFromSct2(seg.P[1]))
+		lines = append(lines, [2]Point2LL{Point2LLFromSct2(seg.P[0]), Point2LLFromSct2(seg.P[1])})
 	}
 
-	cb := CommandBuffer{}
-	lines.GenerateCommands(&cb)
-
-	return cb, labels
+	return tiledLines(lines), labels
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -827,7 +1033,83 @@ func parsePositionFile(filename string) (map[string][]Position, error) {
 
 // Locate returns the location of a (static) named thing, if we've heard of it.
 func (db *StaticDatabase) Locate(name string) (Point2LL, bool) {
-	name = strings.ToUpper(name)
+	id, _ := db.LookupLocationId(name)
+	return db.Location(id)
+}
+
+// Maximum number of names that are interned before the locations are
+// reset.  Only names that resolve are interned, but the FAA database
+// holds tens of thousands of navaids, fixes, and airports, and names
+// are interned as given, so each upper/lowercase variant gets its own
+// entry.  Over a long session, the names in flight plans and typed by the
+// user could otherwise grow the table to much more than is in use.
+const maxInternedLocations = 16384
+
+// LookupLocationId returns the LocationId for the given name, resolving it
+// the first time the name is seen, as well as the current location
+// generation.  The id remains valid as long as the generation is the same
+// as the one returned by LocationGeneration.  InvalidLocationId is
+// returned if the name is not known; such names aren't interned, since
+// typos and the like would otherwise accumulate without bound.
+func (db *StaticDatabase) LookupLocationId(name string) (LocationId, int) {
+	db.locationMutex.Lock()
+	defer db.locationMutex.Unlock()
+
+	if id, ok := db.locationIds[name]; ok {
+		return id, db.locationGeneration
+	}
+
+	p, ok := db.lookupLocation(strings.ToUpper(name))
+	if !ok {
+		return InvalidLocationId, db.locationGeneration
+	}
+
+	if len(db.locations) >= maxInternedLocations {
+		db.locationIds, db.locations = nil, nil
+		db.locationGeneration++
+	}
+	if db.locationIds == nil {
+		db.locationIds = make(map[string]LocationId)
+	}
+	id := LocationId(len(db.locations))
+	db.locations = append(db.locations, p)
+	db.locationIds[name] = id
+	return id, db.locationGeneration
+}
+
+// LocationGeneration returns the current location generation; LocationIds
+// returned by LookupLocationId with an earlier generation should no longer
+// be used.
+func (db *StaticDatabase) LocationGeneration() int {
+	db.locationMutex.Lock()
+	defer db.locationMutex.Unlock()
+	return db.locationGeneration
+}
+
+// Location returns the location for a LocationId returned by
+// LookupLocationId.
+func (db *StaticDatabase) Location(id LocationId) (Point2LL, bool) {
+	db.locationMutex.Lock()
+	defer db.locationMutex.Unlock()
+
+	if id < 0 || int(id) >= len(db.locations) {
+		return Point2LL{}, false
+	}
+	return db.locations[id], true
+}
+
+// resetLocations discards all of the resolved locations; it must be
+// called whenever the sources of locations change.
+func (db *StaticDatabase) resetLocations() {
+	db.locationMutex.Lock()
+	defer db.locationMutex.Unlock()
+
+	db.locationIds = nil
+	db.locations = nil
+	db.locationGeneration++
+}
+
+func (db *StaticDatabase) lookupLocation(name string) (Point2LL, bool) {
 	// We'll start with the sector file and then move on to the FAA
 	// database if we don't find it.
 	if pos, ok := db.VORs[name]; ok {
@@ -838,11 +1120,11 @@ func (db *StaticDatabase) Locate(name string) (Point2LL, bool) {
 		return pos, ok
 	} else if pos, ok := db.airports[name]; ok {
 		return pos, ok
-	} else if n, ok := db.FAA.navaids[name]; ok {
+	} else if n, ok := db.FAA.LookupNavaid(name); ok {
 		return n.Location, ok
-	} else if f, ok := db.FAA.fixes[name]; ok {
+	} else if f, ok := db.FAA.LookupFix(name); ok {
 		return f.Location, ok
-	} else if ap, ok := db.FAA.airports[name]; ok {
+	} else if ap, ok := db.FAA.LookupAirport(name); ok {
 		return ap.Location, ok
 	} else {
 		return Point2LL{}, false
@@ -867,8 +1149,10 @@ func (db *StaticDatabase) SetColorScheme(cs *ColorScheme) {
 // been updated; it takes care of updating all of the RGB buffers in the
 // assorted rendering command buffers to reflect the change.
 func (db *StaticDatabase) NamedColorChanged(name string, rgb RGB) {
-	update := func(c ColorBufferIndex, slice []float32, name string, rgb RGB) {
-		c.Visit(name, func(i int) {
+	update := func(sd *StaticDrawable, name string, rgb RGB) {
+		slice := sd.rgbSlice
+		updated := false
+		sd.colorBufferIndex.Visit(name, func(i int) {
 			idx := 6 * i
 			slice[idx] = rgb.R
 			slice[idx+1] = rgb.G
@@ -876,23 +1160,28 @@ func (db *StaticDatabase) NamedColorChanged(name string, rgb RGB) {
 			slice[idx+3] = rgb.R
 			slice[idx+4] = rgb.G
 			slice[idx+5] = rgb.B
+			updated = true
 		})
+		if updated {
+			// The renderer's copy of the colors is now stale.
+			sd.cb.InvalidateStatic()
+		}
 	}
 
 	switch name {
 	case "Geo":
-		for _, geo := range db.geos {
-			update(geo.colorBufferIndex, geo.rgbSlice, "Geo", rgb)
+		for i := range db.geos {
+			update(&db.geos[i], "Geo", rgb)
 		}
 
 	case "SID":
-		for _, sid := range db.SIDs {
-			update(sid.colorBufferIndex, sid.rgbSlice, "SID", rgb)
+		for i := range db.SIDs {
+			update(&db.SIDs[i], "SID", rgb)
 		}
 
 	case "STAR":
-		for _, star := range db.STARs {
-			update(star.colorBufferIndex, star.rgbSlice, "STAR", rgb)
+		for i := range db.STARs {
+			update(&db.STARs[i], "STAR", rgb)
 		}
 
 	default:
@@ -900,14 +1189,14 @@ func (db *StaticDatabase) NamedColorChanged(name string, rgb RGB) {
 			db.labels[i].color = rgb
 		})
 
-		for _, geo := range db.geos {
-			update(geo.colorBufferIndex, geo.rgbSlice, name, rgb)
+		for i := range db.geos {
+			update(&db.geos[i], name, rgb)
 		}
-		for _, sid := range db.SIDs {
-			update(sid.colorBufferIndex, sid.rgbSlice, name, rgb)
+		for i := range db.SIDs {
+			update(&db.SIDs[i], name, rgb)
 		}
-		for _, star := range db.STARs {
-			update(star.colorBufferIndex, star.rgbSlice, name, rgb)
+		for i := range db.STARs {
+			update(&db.STARs[i], name, rgb)
 		}
 	}
 }
@@ -961,6 +1250,10 @@ type StaticDrawConfig struct {
 	// sessions.
 	vorsComboState, ndbsComboState      *ComboBoxState
 	fixesComboState, airportsComboState *ComboBoxState
+
+	// Reused across calls to Draw to hold the indices of the visible
+	// StaticDrawables.
+	visible []int32
 }
 
 func NewStaticDrawConfig() *StaticDrawConfig {
@@ -1009,6 +1302,9 @@ func (s *StaticDrawConfig) Duplicate() *StaticDrawConfig {
 	dupe.ndbsComboState = NewComboBoxState(1)
 	dupe.fixesComboState = NewComboBoxState(1)
 	dupe.airportsComboState = NewComboBoxState(1)
+	// Panes may be drawn concurrently, so each needs its own scratch
+	// storage for culling.
+	dupe.visible = nil
 
 	return dupe
 }
@@ -1306,90 +1602,82 @@ func (s *StaticDrawConfig) Draw(ctx *PaneContext, labelFont *Font, color *RGB,
 		cb.SetRGB(*color)
 	}
 
+	// Returns the indices of the StaticDrawables in the given index that
+	// are potentially visible.
+	visible := func(index *StaticDrawableIndex) []int32 {
+		s.visible = index.Overlapping(viewBounds, s.visible[:0])
+		return s.visible
+	}
+
 	if s.DrawEverything || s.DrawRunways {
-		// Runways are easy; there's no culling and a pregenerated command
-		// buffer already available.
+		// Runways are easy; their tiles have pregenerated command
+		// buffers ready to go.
 		cb.SetRGB(filterColor(ctx.cs.Runway))
-		cb.Call(database.runwayCommandBuffer)
+		for _, i := range visible(database.runwayIndex) {
+			cb.Call(database.runwayTiles[i].cb)
+		}
 	}
 
 	if s.DrawEverything || s.DrawRegions {
-		for _, region := range database.regions {
-			// Since regions are more work to draw (filled triangles!), we
-			// cull the ones that aren't visible.  For the visible ones,
-			// it's then just a matter of setting the right caller and
-			// calling out to its preexisting command buffer.
-			if Overlaps(region.bounds, viewBounds) {
-				if region.name == "" {
-					cb.SetRGB(filterColor(ctx.cs.Region))
-				} else if rgb, ok := ctx.cs.DefinedColors[region.name]; ok {
-					cb.SetRGB(filterColor(*rgb))
-				} else if rgb, ok := database.sectorFileColors[region.name]; ok {
-					cb.SetRGB(filterColor(rgb))
-				} else {
-					lg.Errorf("%s: defined color not found for region", region.name)
-					cb.SetRGB(filterColor(RGB{0.5, 0.5, 0.5}))
-				}
-				cb.Call(region.cb)
+		for _, i := range visible(database.regionIndex) {
+			// For the visible regions, it's just a matter of setting the
+			// right color and calling out to the preexisting command
+			// buffer.
+			region := &database.regions[i]
+			if region.name == "" {
+				cb.SetRGB(filterColor(ctx.cs.Region))
+			} else if rgb, ok := ctx.cs.DefinedColors[region.name]; ok {
+				cb.SetRGB(filterColor(*rgb))
+			} else if rgb, ok := database.sectorFileColors[region.name]; ok {
+				cb.SetRGB(filterColor(rgb))
+			} else {
+				lg.Errorf("%s: defined color not found for region", region.name)
+				cb.SetRGB(filterColor(RGB{0.5, 0.5, 0.5}))
 			}
+			cb.Call(region.cb)
 		}
 	}
 
 	// ARTCCs
-	drawARTCCLines := func(artcc []StaticDrawable, drawSet map[string]interface{}) {
-		for _, artcc := range artcc {
-			if _, draw := drawSet[artcc.name]; (draw || s.DrawEverything) && Overlaps(artcc.bounds, viewBounds) {
-				cb.Call(artcc.cb)
+	// ARTCCs, SIDs, STARs, and Geos. These are all culled using their
+	// spatial index before calling out to pregenerated command buffers
+	// for the ones that have been selected to be drawn.
+	drawSelected := func(sds []StaticDrawable, index *StaticDrawableIndex, drawSet map[string]interface{}) {
+		if len(drawSet) == 0 && !s.DrawEverything {
+			return
+		}
+		for _, i := range visible(index) {
+			if _, draw := drawSet[sds[i].name]; draw || s.DrawEverything {
+				cb.Call(sds[i].cb)
 			}
 		}
 	}
 	cb.SetRGB(filterColor(ctx.cs.ARTCC))
-	drawARTCCLines(database.ARTCC, s.ARTCCDrawSet)
-	drawARTCCLines(database.ARTCCLow, s.ARTCCLowDrawSet)
-	drawARTCCLines(database.ARTCCHigh, s.ARTCCHighDrawSet)
+	drawSelected(database.ARTCC, database.ARTCCIndex, s.ARTCCDrawSet)
+	drawSelected(database.ARTCCLow, database.ARTCCLowIndex, s.ARTCCLowDrawSet)
+	drawSelected(database.ARTCCHigh, database.ARTCCHighIndex, s.ARTCCHighDrawSet)
 
-	// SIDs, STARs, and Geos. These all have simple bounds checks for
-	// culling before calling out to pregenerated command buffers.
-	sids := database.SIDs
-	if color != nil {
-		sids = database.SIDsNoColor
-	}
-	for _, sid := range sids {
-		_, draw := s.SIDDrawSet[sid.name]
-		if (s.DrawEverything || draw) && Overlaps(sid.bounds, viewBounds) {
-			cb.Call(sid.cb)
-		}
-	}
-	stars := database.STARs
+	sids, stars, geos := database.SIDs, database.STARs, database.geos
 	if color != nil {
-		stars = database.STARsNoColor
-	}
-	for _, star := range stars {
-		_, draw := s.STARDrawSet[star.name]
-		if (s.DrawEverything || draw) && Overlaps(star.bounds, viewBounds) {
-			cb.Call(star.cb)
-		}
-	}
-	geos := database.geos
-	if color != nil {
-		geos = database.geosNoColor
-	}
-	for _, geo := range geos {
-		_, draw := s.GeoDrawSet[geo.name]
-		if (s.DrawEverything || draw) && Overlaps(geo.bounds, viewBounds) {
-			cb.Call(geo.cb)
-		}
+		sids, stars, geos = database.SIDsNoColor, database.STARsNoColor, database.geosNoColor
 	}
+	drawSelected(sids, database.SIDIndex, s.SIDDrawSet)
+	drawSelected(stars, database.STARIndex, s.STARDrawSet)
+	drawSelected(geos, database.geoIndex, s.GeoDrawSet)
 
 	// Airways. For now just draw the lines, if requested. Labels will come
 	// shortly.
 	if s.DrawEverything || s.DrawLowAirways {
 		cb.SetRGB(filterColor(ctx.cs.LowAirway))
-		cb.Call(database.lowAirwayCommandBuffer)
+		for _, i := range visible(database.lowAirwayIndex) {
+			cb.Call(database.lowAirwayTiles[i].cb)
+		}
 	}
 	if s.DrawEverything || s.DrawHighAirways {
 		cb.SetRGB(filterColor(ctx.cs.HighAirway))
-		cb.Call(database.highAirwayCommandBuffer)
+		for _, i := range visible(database.highAirwayIndex) {
+			cb.Call(database.highAirwayTiles[i].cb)
+		}
 	}
 
 	// Now switch to window coordinates for drawing text, VORs, NDBs, fixes, and airports
@@ -7,45 +7,175 @@ package main
 import (
 	"fmt"
 	"runtime"
-	"time"
 )
 
 type EventSubscriberId int
 
-var (
-	nextSubscriberId EventSubscriberId
-	lastCompact      time.Time
-)
+var nextSubscriberId EventSubscriberId
 
 // Reserve 0 as an invalid id so that zero-initialization of objects that
 // store EventSubscriberIds works well.
 const InvalidEventSubscriberId = 0
 
+// EventType identifies the type of an event posted to an EventStream;
+// subscribers can use EventTypes to specify which events they would like
+// to receive.
+type EventType int
+
+const (
+	// UntypedEvent is used for events that aren't one of the types
+	// defined below; they are only delivered to subscribers that didn't
+	// specify any event types when subscribing.
+	UntypedEvent EventType = iota
+	SelectedAircraftEventType
+	AddedAircraftEventType
+	ModifiedAircraftEventType
+	RemovedAircraftEventType
+	AddedControllerEventType
+	ModifiedControllerEventType
+	RemovedControllerEventType
+	AddedPilotEventType
+	RemovedPilotEventType
+	ReceivedMETAREventType
+	ReceivedATISEventType
+	PushedFlightStripEventType
+	PointOutEventType
+	AcceptedHandoffEventType
+	OfferedHandoffEventType
+	CanceledHandoffEventType
+	RejectedHandoffEventType
+	TextMessageEventType
+	NumEventTypes
+)
+
+// eventTypeMask is a bitmask over EventTypes.
+type eventTypeMask uint32
+
+const allEventTypesMask = eventTypeMask(1<<NumEventTypes - 1)
+
+func (m eventTypeMask) Has(t EventType) bool {
+	return m&(1<<t) != 0
+}
+
+// getEventType returns the EventType corresponding to the given event.
+func getEventType(event interface{}) EventType {
+	switch event.(type) {
+	case *SelectedAircraftEvent:
+		return SelectedAircraftEventType
+	case *AddedAircraftEvent:
+		return AddedAircraftEventType
+	case *ModifiedAircraftEvent:
+		return ModifiedAircraftEventType
+	case *RemovedAircraftEvent:
+		return RemovedAircraftEventType
+	case *AddedControllerEvent:
+		return AddedControllerEventType
+	case *ModifiedControllerEvent:
+		return ModifiedControllerEventType
+	case *RemovedControllerEvent:
+		return RemovedControllerEventType
+	case *AddedPilotEvent:
+		return AddedPilotEventType
+	case *RemovedPilotEvent:
+		return RemovedPilotEventType
+	case *ReceivedMETAREvent:
+		return ReceivedMETAREventType
+	case *ReceivedATISEvent:
+		return ReceivedATISEventType
+	case *PushedFlightStripEvent:
+		return PushedFlightStripEventType
+	case *PointOutEvent:
+		return PointOutEventType
+	case *AcceptedHandoffEvent:
+		return AcceptedHandoffEventType
+	case *OfferedHandoffEvent:
+		return OfferedHandoffEventType
+	case *CanceledHandoffEvent:
+		return CanceledHandoffEventType
+	case *RejectedHandoffEvent:
+		return RejectedHandoffEventType
+	case *TextMessageEvent:
+		return TextMessageEventType
+	default:
+		return UntypedEvent
+	}
+}
+
+// DefaultEventStreamCapacity is the number of events that an EventStream
+// holds before it starts overwriting the oldest ones.  Subscribers
+// generally consume their events every frame, so this only fills up if
+// a subscriber stops calling Get.
+const DefaultEventStreamCapacity = 8192
+
 // EventStream provides a basic pub/sub event interface that allows any
 // part of the system to post an event to the stream and other parts to
 // subscribe and receive messages from the stream. It is the backbone for
 // communicating events, world updates, and user actions across the various
 // parts of the system.
+//
+// Events are stored in a fixed-size ring buffer so that memory use is
+// bounded; a subscriber that falls more than the buffer's capacity behind
+// loses the oldest events, which is reported when it next calls Get.
 type EventStream struct {
-	stream      []interface{}
+	// entries is the ring buffer; its length is always a power of two.
+	entries []eventEntry
+	// head is the total number of events posted to the stream; the most
+	// recent event is at entries[(head-1)&(len(entries)-1)].
+	head int64
+	// wanted is the union of the event types that the subscribers would
+	// like to receive; events of other types are discarded at Post time.
+	wanted      eventTypeMask
 	subscribers map[EventSubscriberId]*EventSubscriber
+
+	// When coalescing is enabled, ModifiedAircraftEvents aren't added to
+	// the stream immediately but are merged into a single pending event
+	// per aircraft that is posted when EndCoalescing is called.
+	coalescing      bool
+	pendingModified []*ModifiedAircraftEvent
+	pendingIndex    map[*Aircraft]int
+}
+
+type eventEntry struct {
+	eventType EventType
+	event     interface{}
 }
 
 type EventSubscriber struct {
-	// offset is offset in the EventStream stream array up to which the
+	// offset is the position in the EventStream up to which the
 	// subscriber has consumed events so far.
-	offset int
+	offset int64
+	// mask records the types of events that the subscriber will be given.
+	mask eventTypeMask
+	// overflows counts the number of events the subscriber missed
+	// because it fell too far behind.
+	overflows int64
+	// events holds the events returned by Get; it is reused across calls
+	// to avoid allocating each time.
+	events []interface{}
 	source string
 }
 
 func NewEventStream() *EventStream {
-	return &EventStream{subscribers: make(map[EventSubscriberId]*EventSubscriber)}
+	return newEventStreamWithCapacity(DefaultEventStreamCapacity)
+}
+
+func newEventStreamWithCapacity(capacity int) *EventStream {
+	n := 1
+	for n < capacity {
+		n *= 2
+	}
+	return &EventStream{
+		entries:     make([]eventEntry, n),
+		subscribers: make(map[EventSubscriberId]*EventSubscriber),
+	}
 }
 
 // Subscribe registers a new subscriber to the stream and returns an
 // EventSubscriberId for the subscriber that can then be passed to other
-// EventStream methods.
-func (e *EventStream) Subscribe() EventSubscriberId {
+// EventStream methods. If one or more EventTypes are provided, Get only
+// returns events of those types to the subscriber; otherwise all events
+// are returned.
+func (e *EventStream) Subscribe(types ...EventType) EventSubscriberId {
 	nextSubscriberId++ // start handing them out at 1
 	id := nextSubscriberId
 
@@ -54,9 +184,19 @@ func (e *EventStream) Subscribe() EventSubscriberId {
 	_, fn, line, _ := runtime.Caller(1)
 	source := fmt.Sprintf("%s:%d", fn, line)
 
+	mask := allEventTypesMask
+	if len(types) > 0 {
+		mask = 0
+		for _, t := range types {
+			mask |= 1 << t
+		}
+	}
+
 	e.subscribers[id] = &EventSubscriber{
-		offset: len(e.stream),
+		offset: e.head,
+		mask:   mask,
 		source: source}
+	e.updateWanted()
 	return id
 }
 
@@ -67,38 +207,105 @@ func (e *EventStream) Unsubscribe(id EventSubscriberId) {
 		lg.ErrorfUp1("Attempted to unsubscribe invalid id: %d", id)
 	}
 	delete(e.subscribers, id)
+	e.updateWanted()
+}
+
+func (e *EventStream) updateWanted() {
+	e.wanted = 0
+	for _, sub := range e.subscribers {
+		e.wanted |= sub.mask
+	}
 }
 
 // Post adds an event to the event stream. The type used to encode the
 // event is arbitrary; it's up to the EventStream users to establish
 // conventions.
 func (e *EventStream) Post(event interface{}) {
-	if false && *devmode {
-		if s, ok := event.(interface{ String() string }); ok {
-			lg.PrintfUp1("Post %s; %d subscribers stream length %d, cap %d",
-				s.String(), len(e.subscribers), len(e.stream), cap(e.stream))
-		} else {
-			lg.PrintfUp1("Post %s; %d subscribers stream length %d, cap %d",
-				s, len(e.subscribers), len(e.stream), cap(e.stream))
+	t := getEventType(event)
+
+	if e.coalescing {
+		switch v := event.(type) {
+		case *ModifiedAircraftEvent:
+			if idx, ok := e.pendingIndex[v.ac]; ok {
+				e.pendingModified[idx].changes |= v.changes
+			} else {
+				e.pendingIndex[v.ac] = len(e.pendingModified)
+				// Make a copy so that we can update its changes later
+				// without modifying the caller's event.
+				ev := *v
+				e.pendingModified = append(e.pendingModified, &ev)
+			}
+			return
+
+		case *RemovedAircraftEvent:
+			// Don't report modifications after the aircraft is gone.
+			if idx, ok := e.pendingIndex[v.ac]; ok {
+				e.pendingModified[idx] = nil
+				delete(e.pendingIndex, v.ac)
+			}
 		}
 	}
 
 	// Ignore the event if no one's paying attention.
-	if len(e.subscribers) > 0 {
-		if len(e.stream)+1 == cap(e.stream) && *devmode && lg != nil {
-			// Dump the state of things if the array's about to grow; in
-			// general we expect it to pretty quickly reach steady state
-			// with just a handful of entries.
-			lg.Printf("%s", e.Dump())
+	if e.wanted.Has(t) {
+		e.add(t, event)
+	}
+}
+
+func (e *EventStream) add(t EventType, event interface{}) {
+	e.entries[e.head&int64(len(e.entries)-1)] = eventEntry{eventType: t, event: event}
+	e.head++
+}
+
+// BeginCoalescing starts collecting ModifiedAircraftEvents rather than
+// posting them directly.  Until EndCoalescing is called, multiple
+// modifications of the same aircraft are merged into a single event whose
+// changes field records the union of the changes.  This is useful when
+// processing a batch of updates, as it saves subscribers from repeatedly
+// doing the same work for an aircraft.
+func (e *EventStream) BeginCoalescing() {
+	if e.coalescing {
+		lg.ErrorfUp1("BeginCoalescing called while already coalescing")
+		return
+	}
+	e.coalescing = true
+	if e.pendingIndex == nil {
+		e.pendingIndex = make(map[*Aircraft]int)
+	}
+}
+
+// EndCoalescing posts the ModifiedAircraftEvents collected since
+// BeginCoalescing was called, one per modified aircraft, in the order in
+// which each aircraft was first modified.
+func (e *EventStream) EndCoalescing() {
+	if !e.coalescing {
+		lg.ErrorfUp1("EndCoalescing called without BeginCoalescing")
+		return
+	}
+	e.coalescing = false
+
+	if e.wanted.Has(ModifiedAircraftEventType) {
+		for _, ev := range e.pendingModified {
+			if ev != nil {
+				e.add(ModifiedAircraftEventType, ev)
+			}
 		}
+	}
 
-		e.stream = append(e.stream, event)
+	for i := range e.pendingModified {
+		e.pendingModified[i] = nil
+	}
+	e.pendingModified = e.pendingModified[:0]
+	for ac := range e.pendingIndex {
+		delete(e.pendingIndex, ac)
 	}
 }
 
 // Get returns all of the events from the stream since the last time Get
-// was called with the given id.  Note that events before an id was created
-// with Subscribe are never reported for that id.
+// was called with the given id, limited to the event types specified when
+// the subscriber was registered.  Note that events before an id was
+// created with Subscribe are never reported for that id.  The returned
+// slice is only valid until the next call to Get with the same id.
 func (e *EventStream) Get(id EventSubscriberId) []interface{} {
 	sub, ok := e.subscribers[id]
 	if !ok {
@@ -106,53 +313,70 @@ func (e *EventStream) Get(id EventSubscriberId) []interface{} {
 		return nil
 	}
 
-	s := e.stream[sub.offset:]
-	sub.offset = len(e.stream)
-
-	if time.Since(lastCompact) > 1*time.Second {
-		e.compact()
-		lastCompact = time.Now()
+	// If the subscriber has fallen behind so much that events it hasn't
+	// seen have been overwritten, skip ahead to the oldest one that's
+	// still available.
+	if oldest := e.head - int64(len(e.entries)); sub.offset < oldest {
+		n := oldest - sub.offset
+		if sub.overflows == 0 && lg != nil {
+			lg.Printf("%s: subscriber fell behind; %d events overwritten", sub.source, n)
+		}
+		sub.overflows += n
+		sub.offset = oldest
 	}
 
-	return s
-}
-
-// compact reclaims storage for events that all subscribers have seen; it
-// is called periodically so that EventStream memory usage doesn't grow
-// without bound.
-func (e *EventStream) compact() {
-	minOffset := len(e.stream)
-	for _, sub := range e.subscribers {
-		if sub.offset < minOffset {
-			minOffset = sub.offset
+	sub.events = sub.events[:0]
+	mask := int64(len(e.entries) - 1)
+	for ; sub.offset < e.head; sub.offset++ {
+		if entry := &e.entries[sub.offset&mask]; sub.mask.Has(entry.eventType) {
+			sub.events = append(sub.events, entry.event)
 		}
 	}
 
-	if minOffset > cap(e.stream)/2 {
-		n := len(e.stream) - minOffset
-
-		if lg != nil {
-			lg.Printf("Compacting event stream from %d to %d elements", len(e.stream), n)
-		}
+	return sub.events
+}
 
-		copy(e.stream, e.stream[minOffset:])
-		e.stream = e.stream[:n]
+// Pending returns true if there are events for the given subscriber that
+// it hasn't yet received from Get.  It doesn't consume the events.
+func (e *EventStream) Pending(id EventSubscriberId) bool {
+	sub, ok := e.subscribers[id]
+	if !ok {
+		lg.ErrorfUp1("Attempted to check pending with invalid id: %d", id)
+		return false
+	}
 
-		for _, sub := range e.subscribers {
-			sub.offset -= minOffset
+	offset := sub.offset
+	if oldest := e.head - int64(len(e.entries)); offset < oldest {
+		// Events were lost, which Get will report; either way there's
+		// something new.
+		return true
+	}
+	mask := int64(len(e.entries) - 1)
+	for ; offset < e.head; offset++ {
+		if sub.mask.Has(e.entries[offset&mask].eventType) {
+			return true
 		}
 	}
+	return false
+}
+
+// Posted returns the total number of events that have been added to the
+// stream; it can be compared between calls to see if anything new has
+// been posted.
+func (e *EventStream) Posted() int64 {
+	return e.head
 }
 
 // Dump prints out information about the internals of the event stream that
 // may be useful for debugging.
 func (e *EventStream) Dump() string {
-	s := fmt.Sprintf("stream: len %d cap %d", len(e.stream), cap(e.stream))
-	if len(e.stream) > 0 {
-		s += fmt.Sprintf("\n  last elt %v", e.stream[len(e.stream)-1])
+	s := fmt.Sprintf("stream: head %d cap %d", e.head, len(e.entries))
+	if e.head > 0 {
+		s += fmt.Sprintf("\n  last elt %v", e.entries[(e.head-1)&int64(len(e.entries)-1)].event)
 	}
 	for i, sub := range e.subscribers {
-		s += fmt.Sprintf(" sub %d: %+v", i, sub)
+		s += fmt.Sprintf(" sub %d: offset %d mask %x overflows %d source %s", i, sub.offset,
+			sub.mask, sub.overflows, sub.source)
 	}
 	return s
 }
@@ -175,8 +399,29 @@ func (e *AddedAircraftEvent) String() string {
 	return "AddedAircraftEvent: " + e.ac.Callsign
 }
 
+// AircraftChanges is a bitmask that records which aspects of an Aircraft
+// were changed for a ModifiedAircraftEvent.
+type AircraftChanges uint8
+
+const (
+	AircraftTrackChanged AircraftChanges = 1 << iota
+	AircraftFlightPlanChanged
+	AircraftScratchpadChanged
+	AircraftSquawkChanged
+	// AircraftOtherChanged covers everything else: the tracking
+	// controller, handoffs, temporary altitude, voice type, ...
+	AircraftOtherChanged
+)
+
 type ModifiedAircraftEvent struct {
-	ac *Aircraft
+	ac      *Aircraft
+	changes AircraftChanges
+}
+
+// Changed returns true if any of the specified aspects of the aircraft
+// were modified.
+func (e *ModifiedAircraftEvent) Changed(c AircraftChanges) bool {
+	return e.changes&c != 0
 }
 
 func (e *ModifiedAircraftEvent) String() string {
@@ -39,8 +39,8 @@ func TestEventStream(t *testing.T) {
 	}
 }
 
-func TestEventStreamCompact(t *testing.T) {
-	es := NewEventStream()
+func TestEventStreamRing(t *testing.T) {
+	es := newEventStreamWithCapacity(1024)
 
 	// multiple consumers, at different offsets
 	id := [4]EventSubscriberId{es.Subscribe(), es.Subscribe(), es.Subscribe(), es.Subscribe()}
@@ -66,6 +66,11 @@ func TestEventStreamCompact(t *testing.T) {
 			if rand.Float32() > prob || (iter > 0 && c == 1) /* unsubscribed */ {
 				continue
 			}
+			// If the consumer fell too far behind, it should pick up
+			// with the oldest value still in the ring.
+			if i-idx[c] > len(es.entries) {
+				idx[c] = i - len(es.entries)
+			}
 			s := es.Get(id[c])
 			for _, sv := range s {
 				if idx[c] != sv {
@@ -73,13 +78,132 @@ func TestEventStreamCompact(t *testing.T) {
 				}
 				idx[c]++
 			}
+			if idx[c] != i {
+				t.Errorf("expected to have consumed up to %d; got %d for consumer %d", i, idx[c], c)
+			}
 		}
 
-		es.compact()
 		iter++
 	}
 
-	if cap(es.stream) > i/2 {
-		t.Errorf("is compaction not happening? len %d cap %d", len(es.stream), cap(es.stream))
+	if len(es.entries) != 1024 {
+		t.Errorf("ring buffer size changed: %d", len(es.entries))
+	}
+}
+
+func TestEventStreamFilter(t *testing.T) {
+	es := NewEventStream()
+
+	all := es.Subscribe()
+	mod := es.Subscribe(ModifiedAircraftEventType)
+	handoff := es.Subscribe(AcceptedHandoffEventType, OfferedHandoffEventType)
+
+	ac := &Aircraft{Callsign: "AAL123"}
+	es.Post(&ModifiedAircraftEvent{ac: ac})
+	es.Post(&OfferedHandoffEvent{controller: "JFK_APP", ac: ac})
+	es.Post(1)
+	es.Post(&ModifiedAircraftEvent{ac: ac})
+	es.Post(&AcceptedHandoffEvent{controller: "JFK_APP", ac: ac})
+
+	if n := len(es.Get(all)); n != 5 {
+		t.Errorf("expected 5 events for unfiltered subscriber, got %d", n)
+	}
+	s := es.Get(mod)
+	if len(s) != 2 {
+		t.Errorf("expected 2 events for modified subscriber, got %d", len(s))
+	}
+	for _, ev := range s {
+		if _, ok := ev.(*ModifiedAircraftEvent); !ok {
+			t.Errorf("unexpected event %v for modified subscriber", ev)
+		}
+	}
+	s = es.Get(handoff)
+	if len(s) != 2 {
+		t.Errorf("expected 2 events for handoff subscriber, got %d", len(s))
+	} else {
+		if _, ok := s[0].(*OfferedHandoffEvent); !ok {
+			t.Errorf("expected OfferedHandoffEvent, got %v", s[0])
+		}
+		if _, ok := s[1].(*AcceptedHandoffEvent); !ok {
+			t.Errorf("expected AcceptedHandoffEvent, got %v", s[1])
+		}
+	}
+
+	// Events that no subscriber wants shouldn't be stored.
+	es.Unsubscribe(all)
+	head := es.head
+	es.Post(&SelectedAircraftEvent{ac: ac})
+	es.Post(2)
+	if es.head != head {
+		t.Errorf("stored events that no subscriber wants")
+	}
+}
+
+func TestEventStreamPending(t *testing.T) {
+	es := NewEventStream()
+
+	mod := es.Subscribe(ModifiedAircraftEventType)
+	handoff := es.Subscribe(AcceptedHandoffEventType)
+	if es.Pending(mod) || es.Pending(handoff) {
+		t.Errorf("events pending in empty stream")
+	}
+
+	ac := &Aircraft{Callsign: "AAL123"}
+	es.Post(&ModifiedAircraftEvent{ac: ac})
+	if !es.Pending(mod) {
+		t.Errorf("expected pending event for modified subscriber")
+	}
+	if es.Pending(handoff) {
+		t.Errorf("unexpected pending event for handoff subscriber")
+	}
+	// Pending shouldn't consume the event.
+	if n := len(es.Get(mod)); n != 1 {
+		t.Errorf("expected 1 event for modified subscriber, got %d", n)
+	}
+	if es.Pending(mod) {
+		t.Errorf("event still pending after Get")
+	}
+}
+
+func TestEventStreamCoalesce(t *testing.T) {
+	es := NewEventStream()
+	id := es.Subscribe(AddedAircraftEventType, ModifiedAircraftEventType, RemovedAircraftEventType)
+
+	a, b, c := &Aircraft{Callsign: "AAL1"}, &Aircraft{Callsign: "UAL2"}, &Aircraft{Callsign: "DAL3"}
+
+	es.BeginCoalescing()
+	es.Post(&ModifiedAircraftEvent{ac: a, changes: AircraftTrackChanged})
+	es.Post(&ModifiedAircraftEvent{ac: b, changes: AircraftScratchpadChanged})
+	es.Post(&ModifiedAircraftEvent{ac: c, changes: AircraftTrackChanged})
+	es.Post(&ModifiedAircraftEvent{ac: a, changes: AircraftSquawkChanged})
+	es.Post(&ModifiedAircraftEvent{ac: a, changes: AircraftTrackChanged})
+	es.Post(&RemovedAircraftEvent{ac: c})
+
+	if len(es.Get(id)) != 1 {
+		t.Errorf("expected only the removed event before coalescing ended")
+	}
+	es.EndCoalescing()
+
+	s := es.Get(id)
+	if len(s) != 2 {
+		t.Fatalf("expected 2 coalesced events, got %d", len(s))
+	}
+	expect := func(ev interface{}, ac *Aircraft, changes AircraftChanges) {
+		if m, ok := ev.(*ModifiedAircraftEvent); !ok {
+			t.Errorf("expected ModifiedAircraftEvent, got %v", ev)
+		} else if m.ac != ac {
+			t.Errorf("expected aircraft %s, got %s", ac.Callsign, m.ac.Callsign)
+		} else if m.changes != changes {
+			t.Errorf("%s: expected changes %x, got %x", ac.Callsign, changes, m.changes)
+		}
+	}
+	expect(s[0], a, AircraftTrackChanged|AircraftSquawkChanged)
+	expect(s[1], b, AircraftScratchpadChanged)
+
+	// Once coalescing has ended, events are posted directly again.
+	es.Post(&ModifiedAircraftEvent{ac: a, changes: AircraftTrackChanged})
+	es.Post(&ModifiedAircraftEvent{ac: a, changes: AircraftTrackChanged})
+	if n := len(es.Get(id)); n != 2 {
+		t.Errorf("expected 2 events, got %d", n)
 	}
 }
@@ -0,0 +1,468 @@
+// faa-snapshot.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+// This file implements a compact binary snapshot of the built-in FAA (et
+// al.) databases.  Decompressing and parsing the CSV files they are
+// distributed as is the slowest part of starting up, so the first time a
+// build of vice runs, it parses them as before but then writes a snapshot
+// to the user's cache directory; subsequent runs read the snapshot and
+// use it directly, without any parsing.
+//
+// A snapshot consists of a header, a string table, and then a table of
+// fixed-size records for each database.  Records are sorted by their
+// key so that lookups are binary searches, and all of the strings in a
+// record are stored as (offset, length) pairs into the string table, so
+// that the strings returned by lookups are substrings of it and don't
+// require allocations.  All values are little-endian.
+//
+//   magic               8 bytes
+//   source hash         uint32 (of the embedded databases)
+//   string table size   uint32
+//   string table
+//   for each table: record count (uint32), records
+
+package main
+
+import (
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"hash/crc32"
+	"math"
+	"os"
+	"path"
+	"path/filepath"
+	"sort"
+	"strings"
+	"sync"
+)
+
+// faaSnapshotMagic is at the start of all snapshot files; the final byte
+// is the format version, which must be updated whenever the layout of the
+// snapshot (including any of the record layouts below) changes.
+var faaSnapshotMagic = []byte{'V', 'I', 'C', 'E', 'F', 'A', 'A', 1}
+
+var ErrCorruptFAASnapshot = errors.New("corrupt FAA database snapshot")
+
+// faaRecordLayout describes the records in a table: each starts with
+// some number of strings, the first nkey of which are its key, followed
+// by some number of 32-bit values.
+type faaRecordLayout struct {
+	nstrings, nkey, nwords int
+}
+
+func (l faaRecordLayout) size() int {
+	return 8*l.nstrings + 4*l.nwords
+}
+
+var (
+	// Id, Type, Name; longitude, latitude
+	navaidLayout = faaRecordLayout{nstrings: 3, nkey: 1, nwords: 2}
+	// Id, Name; elevation, longitude, latitude
+	airportLayout = faaRecordLayout{nstrings: 2, nkey: 1, nwords: 3}
+	// Id; longitude, latitude
+	fixLayout = faaRecordLayout{nstrings: 1, nkey: 1, nwords: 2}
+	// ThreeLetter, Company, Country, Telephony
+	callsignLayout = faaRecordLayout{nstrings: 4, nkey: 1}
+	// Depart, Arrive, Route, Hours[0..2], Type, Area, Altitude, Aircraft,
+	// Direction, Seq, DepCenter, ArriveCenter
+	prdLayout = faaRecordLayout{nstrings: 14, nkey: 2}
+
+	// The order in which the tables are stored in the snapshot.
+	faaSnapshotLayouts = []faaRecordLayout{navaidLayout, airportLayout, fixLayout, callsignLayout, prdLayout}
+)
+
+// faaTable provides access to a sorted table of records in a snapshot.
+type faaTable struct {
+	layout  faaRecordLayout
+	n       int
+	records []byte
+	strings string
+}
+
+func (t *faaTable) record(i int) []byte {
+	sz := t.layout.size()
+	return t.records[i*sz : (i+1)*sz]
+}
+
+func (t *faaTable) str(i, field int) string {
+	r := t.record(i)[8*field:]
+	offset, n := binary.LittleEndian.Uint32(r), binary.LittleEndian.Uint32(r[4:])
+	return t.strings[offset : offset+n]
+}
+
+func (t *faaTable) word(i, field int) uint32 {
+	return binary.LittleEndian.Uint32(t.record(i)[8*t.layout.nstrings+4*field:])
+}
+
+func (t *faaTable) point(i, field int) Point2LL {
+	return Point2LL{math.Float32frombits(t.word(i, field)), math.Float32frombits(t.word(i, field+1))}
+}
+
+// compare compares the key of the i'th record to the given key.
+func (t *faaTable) compare(i int, key ...string) int {
+	for f, k := range key {
+		if c := strings.Compare(t.str(i, f), k); c != 0 {
+			return c
+		}
+	}
+	return 0
+}
+
+// find returns the range of records that have the given key.
+func (t *faaTable) find(key ...string) (int, int) {
+	start := sort.Search(t.n, func(i int) bool { return t.compare(i, key...) >= 0 })
+	end := start
+	for end < t.n && t.compare(end, key...) == 0 {
+		end++
+	}
+	return start, end
+}
+
+// FAADatabase provides lookups in the built-in FAA (et al.) databases.
+type FAADatabase struct {
+	// The raw snapshot
+	snapshot []byte
+
+	navaids, airports, fixes, callsigns, prd faaTable
+}
+
+func (db *FAADatabase) LookupNavaid(id string) (Navaid, bool) {
+	t := &db.navaids
+	if i, end := t.find(id); i < end {
+		return Navaid{Id: t.str(i, 0), Type: t.str(i, 1), Name: t.str(i, 2), Location: t.point(i, 0)}, true
+	}
+	return Navaid{}, false
+}
+
+func (db *FAADatabase) LookupAirport(id string) (Airport, bool) {
+	t := &db.airports
+	if i, end := t.find(id); i < end {
+		return Airport{Id: t.str(i, 0), Name: t.str(i, 1), Elevation: int(int32(t.word(i, 0))),
+			Location: t.point(i, 1)}, true
+	}
+	return Airport{}, false
+}
+
+func (db *FAADatabase) LookupFix(id string) (Fix, bool) {
+	t := &db.fixes
+	if i, end := t.find(id); i < end {
+		return Fix{Id: t.str(i, 0), Location: t.point(i, 0)}, true
+	}
+	return Fix{}, false
+}
+
+// LookupCallsign returns information about the airline with the given
+// three-letter identifier.
+func (db *FAADatabase) LookupCallsign(threeLetter string) (Callsign, bool) {
+	t := &db.callsigns
+	if i, end := t.find(threeLetter); i < end {
+		return Callsign{ThreeLetter: t.str(i, 0), Company: t.str(i, 1), Country: t.str(i, 2),
+			Telephony: t.str(i, 3)}, true
+	}
+	return Callsign{}, false
+}
+
+// LookupPRD returns the preferred routes between the given airports, if
+// there are any.
+func (db *FAADatabase) LookupPRD(depart, arrive string) ([]PRDEntry, bool) {
+	t := &db.prd
+	start, end := t.find(depart, arrive)
+	if start == end {
+		return nil, false
+	}
+
+	entries := make([]PRDEntry, 0, end-start)
+	for i := start; i < end; i++ {
+		entries = append(entries, PRDEntry{
+			Depart:       t.str(i, 0),
+			Arrive:       t.str(i, 1),
+			Route:        t.str(i, 2),
+			Hours:        [3]string{t.str(i, 3), t.str(i, 4), t.str(i, 5)},
+			Type:         t.str(i, 6),
+			Area:         t.str(i, 7),
+			Altitude:     t.str(i, 8),
+			Aircraft:     t.str(i, 9),
+			Direction:    t.str(i, 10),
+			Seq:          t.str(i, 11),
+			DepCenter:    t.str(i, 12),
+			ArriveCenter: t.str(i, 13)})
+	}
+	return entries, true
+}
+
+// NewFAADatabaseFromSnapshot returns an FAADatabase that uses the
+// provided snapshot, which must have been made from the databases with
+// the given source hash.
+func NewFAADatabaseFromSnapshot(snapshot []byte, sourceHash uint32) (*FAADatabase, error) {
+	b := snapshot
+	if len(b) < len(faaSnapshotMagic)+8 {
+		return nil, ErrCorruptFAASnapshot
+	}
+	if !bytes.Equal(b[:len(faaSnapshotMagic)], faaSnapshotMagic) {
+		return nil, errors.New("FAA database snapshot has the wrong version")
+	}
+	b = b[len(faaSnapshotMagic):]
+	if binary.LittleEndian.Uint32(b) != sourceHash {
+		return nil, errors.New("FAA database snapshot is out of date")
+	}
+
+	nstrings := binary.LittleEndian.Uint32(b[4:])
+	b = b[8:]
+	if uint64(nstrings) > uint64(len(b)) {
+		return nil, ErrCorruptFAASnapshot
+	}
+	// Make a single string for the string table that all of the strings
+	// are then sliced from.
+	stringTable := string(b[:nstrings])
+	b = b[nstrings:]
+
+	db := &FAADatabase{snapshot: snapshot}
+	tables := []*faaTable{&db.navaids, &db.airports, &db.fixes, &db.callsigns, &db.prd}
+	for i, t := range tables {
+		if len(b) < 4 {
+			return nil, ErrCorruptFAASnapshot
+		}
+		t.layout = faaSnapshotLayouts[i]
+		t.strings = stringTable
+		t.n = int(binary.LittleEndian.Uint32(b))
+		b = b[4:]
+
+		sz := uint64(t.n) * uint64(t.layout.size())
+		if sz > uint64(len(b)) {
+			return nil, ErrCorruptFAASnapshot
+		}
+		t.records = b[:sz]
+		b = b[sz:]
+
+		// Make sure that all of the strings are valid so that lookups
+		// don't need to worry about it.
+		for r := 0; r < t.n; r++ {
+			rec := t.record(r)
+			for f := 0; f < t.layout.nstrings; f++ {
+				offset := uint64(binary.LittleEndian.Uint32(rec[8*f:]))
+				n := uint64(binary.LittleEndian.Uint32(rec[8*f+4:]))
+				if offset+n > uint64(nstrings) {
+					return nil, ErrCorruptFAASnapshot
+				}
+			}
+		}
+	}
+	if len(b) != 0 {
+		return nil, ErrCorruptFAASnapshot
+	}
+
+	return db, nil
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Creating snapshots
+
+// faaSnapshotBuilder accumulates the string table and records of the
+// tables for a snapshot.
+type faaSnapshotBuilder struct {
+	strings       bytes.Buffer
+	stringOffsets map[string]uint32
+	tables        bytes.Buffer
+}
+
+// faaRecord is a record before encoding.
+type faaRecord struct {
+	strings []string
+	words   []uint32
+}
+
+func (b *faaSnapshotBuilder) addString(s string) uint32 {
+	if offset, ok := b.stringOffsets[s]; ok {
+		return offset
+	}
+	offset := uint32(b.strings.Len())
+	b.strings.WriteString(s)
+	b.stringOffsets[s] = offset
+	return offset
+}
+
+// addTable encodes the given records, which must match the given
+// layout.  Their order is preserved for records with the same key.
+func (b *faaSnapshotBuilder) addTable(layout faaRecordLayout, records []faaRecord) {
+	sort.SliceStable(records, func(i, j int) bool {
+		for f := 0; f < layout.nkey; f++ {
+			if records[i].strings[f] != records[j].strings[f] {
+				return records[i].strings[f] < records[j].strings[f]
+			}
+		}
+		return false
+	})
+
+	var buf [8]byte
+	binary.LittleEndian.PutUint32(buf[:], uint32(len(records)))
+	b.tables.Write(buf[:4])
+
+	for _, r := range records {
+		for _, s := range r.strings {
+			binary.LittleEndian.PutUint32(buf[:], b.addString(s))
+			binary.LittleEndian.PutUint32(buf[4:], uint32(len(s)))
+			b.tables.Write(buf[:8])
+		}
+		for _, w := range r.words {
+			binary.LittleEndian.PutUint32(buf[:], w)
+			b.tables.Write(buf[:4])
+		}
+	}
+}
+
+func pointWords(p Point2LL) []uint32 {
+	return []uint32{math.Float32bits(p[0]), math.Float32bits(p[1])}
+}
+
+// makeFAASnapshot encodes a snapshot of the provided databases.
+func makeFAASnapshot(sourceHash uint32, navaids map[string]Navaid, airports map[string]Airport,
+	fixes map[string]Fix, callsigns map[string]Callsign, prd map[AirportPair][]PRDEntry) []byte {
+	b := &faaSnapshotBuilder{stringOffsets: make(map[string]uint32)}
+
+	var records []faaRecord
+	for _, n := range navaids {
+		records = append(records, faaRecord{strings: []string{n.Id, n.Type, n.Name}, words: pointWords(n.Location)})
+	}
+	b.addTable(navaidLayout, records)
+
+	records = nil
+	for _, ap := range airports {
+		records = append(records, faaRecord{strings: []string{ap.Id, ap.Name},
+			words: append([]uint32{uint32(int32(ap.Elevation))}, pointWords(ap.Location)...)})
+	}
+	b.addTable(airportLayout, records)
+
+	records = nil
+	for _, f := range fixes {
+		records = append(records, faaRecord{strings: []string{f.Id}, words: pointWords(f.Location)})
+	}
+	b.addTable(fixLayout, records)
+
+	records = nil
+	for _, cs := range callsigns {
+		records = append(records, faaRecord{strings: []string{cs.ThreeLetter, cs.Company, cs.Country, cs.Telephony}})
+	}
+	b.addTable(callsignLayout, records)
+
+	// Go through the PRD airport pairs in sorted order; the stable sort
+	// in addTable then preserves the order of the entries for each pair.
+	records = nil
+	pairs := SortedMapKeysPred(prd, func(a *AirportPair, b *AirportPair) bool {
+		return a.depart < b.depart || (a.depart == b.depart && a.arrive < b.arrive)
+	})
+	for _, pair := range pairs {
+		for _, e := range prd[pair] {
+			records = append(records, faaRecord{strings: []string{e.Depart, e.Arrive, e.Route,
+				e.Hours[0], e.Hours[1], e.Hours[2], e.Type, e.Area, e.Altitude, e.Aircraft,
+				e.Direction, e.Seq, e.DepCenter, e.ArriveCenter}})
+		}
+	}
+	b.addTable(prdLayout, records)
+
+	var snapshot bytes.Buffer
+	snapshot.Write(faaSnapshotMagic)
+	var buf [4]byte
+	binary.LittleEndian.PutUint32(buf[:], sourceHash)
+	snapshot.Write(buf[:])
+	binary.LittleEndian.PutUint32(buf[:], uint32(b.strings.Len()))
+	snapshot.Write(buf[:])
+	snapshot.Write(b.strings.Bytes())
+	snapshot.Write(b.tables.Bytes())
+
+	return snapshot.Bytes()
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Initialization
+
+// faaSourceHash returns a hash of all of the embedded databases, so that
+// a snapshot made from different ones isn't used.
+func faaSourceHash() uint32 {
+	var crc uint32
+	var buf [64 * 1024]byte
+	for _, s := range []string{navBaseRaw, airportsRaw, fixesRaw, callsignsRaw, virtualCallsignsRaw,
+		prdRaw, globalAirportsRaw} {
+		// Go through a buffer rather than converting each one to a
+		// []byte, which would make a copy of the entire thing.
+		for len(s) > 0 {
+			n := copy(buf[:], s)
+			crc = crc32.Update(crc, crc32.IEEETable, buf[:n])
+			s = s[n:]
+		}
+	}
+	return crc
+}
+
+// InitializeFAADatabase returns the built-in databases, loading them from
+// a snapshot if one is available and otherwise parsing them and saving a
+// snapshot for next time.
+func InitializeFAADatabase() *FAADatabase {
+	sourceHash := faaSourceHash()
+
+	fn, err := cacheFilePath(fmt.Sprintf("faa-%08x.db", sourceHash))
+	if err != nil {
+		lg.Errorf("Unable to find user cache dir: %v", err)
+	} else if snapshot, err := os.ReadFile(fn); err == nil {
+		if db, err := NewFAADatabaseFromSnapshot(snapshot, sourceHash); err == nil {
+			lg.Printf("%s: loaded FAA database snapshot", fn)
+			return db
+		} else {
+			lg.Errorf("%s: %v", fn, err)
+		}
+	} else if !errors.Is(err, os.ErrNotExist) {
+		lg.Errorf("%s: %v", fn, err)
+	}
+
+	var navaids map[string]Navaid
+	var airports map[string]Airport
+	var fixes map[string]Fix
+	var prd map[AirportPair][]PRDEntry
+	var callsigns map[string]Callsign
+
+	var wg sync.WaitGroup
+	wg.Add(1)
+	go func() { navaids = parseNavaids(); wg.Done() }()
+	wg.Add(1)
+	go func() { airports = parseAirports(); wg.Done() }()
+	wg.Add(1)
+	go func() { fixes = parseFixes(); wg.Done() }()
+	wg.Add(1)
+	go func() { prd = parsePRD(); wg.Done() }()
+	wg.Add(1)
+	go func() { callsigns = parseCallsigns(); wg.Done() }()
+	wg.Wait()
+
+	snapshot := makeFAASnapshot(sourceHash, navaids, airports, fixes, callsigns, prd)
+	db, err := NewFAADatabaseFromSnapshot(snapshot, sourceHash)
+	if err != nil {
+		// This shouldn't happen...
+		panic(fmt.Sprintf("unable to decode FAA database snapshot: %v", err))
+	}
+
+	if fn != "" {
+		if err := writeFAASnapshot(fn, snapshot); err != nil {
+			lg.Errorf("%s: unable to write FAA database snapshot: %v", fn, err)
+		} else {
+			lg.Printf("%s: wrote FAA database snapshot", fn)
+		}
+	}
+
+	return db
+}
+
+// writeFAASnapshot writes the snapshot to the given file, removing any
+// snapshots from previous versions of the databases.
+func writeFAASnapshot(fn string, snapshot []byte) error {
+	if old, err := filepath.Glob(path.Join(path.Dir(fn), "faa-*.db")); err == nil {
+		for _, o := range old {
+			if o != fn {
+				os.Remove(o)
+			}
+		}
+	}
+
+	return writeFileAtomically(fn, snapshot)
+}
@@ -0,0 +1,86 @@
+// faa-snapshot_test.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+package main
+
+import (
+	"reflect"
+	"testing"
+)
+
+func TestFAASnapshotRoundTrip(t *testing.T) {
+	navaids := map[string]Navaid{
+		"JFK": Navaid{Id: "JFK", Type: "VOR/DME", Name: "KENNEDY", Location: Point2LL{-73.803, 40.633}},
+		"CRI": Navaid{Id: "CRI", Type: "VOR/DME", Name: "CANARSIE", Location: Point2LL{-73.913, 40.612}},
+	}
+	airports := map[string]Airport{
+		"KJFK": Airport{Id: "KJFK", Name: "JOHN F KENNEDY INTL", Elevation: 13, Location: Point2LL{-73.778, 40.639}},
+		"KDCA": Airport{Id: "KDCA", Name: "RONALD REAGAN WASHINGTON NATL", Elevation: -3,
+			Location: Point2LL{-77.037, 38.851}},
+	}
+	fixes := map[string]Fix{
+		"MERIT": Fix{Id: "MERIT", Location: Point2LL{-73.121, 41.381}},
+		"CAMRN": Fix{Id: "CAMRN", Location: Point2LL{-73.861, 40.017}},
+	}
+	callsigns := map[string]Callsign{
+		"AAL": Callsign{ThreeLetter: "AAL", Company: "AMERICAN AIRLINES INC.", Country: "UNITED STATES",
+			Telephony: "AMERICAN"},
+	}
+	prd := map[AirportPair][]PRDEntry{
+		AirportPair{"JFK", "DCA"}: []PRDEntry{
+			PRDEntry{Depart: "JFK", Arrive: "DCA", Route: "JFK RBV J230 BYRDD", Seq: "1"},
+			PRDEntry{Depart: "JFK", Arrive: "DCA", Route: "JFK DIXIE V1 ATR", Seq: "2",
+				Hours: [3]string{"0600-2200", "", ""}},
+		},
+	}
+
+	snapshot := makeFAASnapshot(1234, navaids, airports, fixes, callsigns, prd)
+	db, err := NewFAADatabaseFromSnapshot(snapshot, 1234)
+	if err != nil {
+		t.Fatalf("NewFAADatabaseFromSnapshot: %v", err)
+	}
+
+	for id, n := range navaids {
+		if got, ok := db.LookupNavaid(id); !ok || got != n {
+			t.Errorf("navaid %s: got %+v, %v; expected %+v", id, got, ok, n)
+		}
+	}
+	for id, ap := range airports {
+		if got, ok := db.LookupAirport(id); !ok || got != ap {
+			t.Errorf("airport %s: got %+v, %v; expected %+v", id, got, ok, ap)
+		}
+	}
+	for id, f := range fixes {
+		if got, ok := db.LookupFix(id); !ok || got != f {
+			t.Errorf("fix %s: got %+v, %v; expected %+v", id, got, ok, f)
+		}
+	}
+	for id, cs := range callsigns {
+		if got, ok := db.LookupCallsign(id); !ok || got != cs {
+			t.Errorf("callsign %s: got %+v, %v; expected %+v", id, got, ok, cs)
+		}
+	}
+	if got, ok := db.LookupPRD("JFK", "DCA"); !ok || !reflect.DeepEqual(got, prd[AirportPair{"JFK", "DCA"}]) {
+		t.Errorf("PRD JFK-DCA: got %+v, %v; expected %+v", got, ok, prd[AirportPair{"JFK", "DCA"}])
+	}
+
+	if _, ok := db.LookupNavaid("XXX"); ok {
+		t.Errorf("unexpectedly found navaid XXX")
+	}
+	if _, ok := db.LookupFix("AAAAA"); ok {
+		t.Errorf("unexpectedly found fix AAAAA")
+	}
+	if _, ok := db.LookupPRD("DCA", "JFK"); ok {
+		t.Errorf("unexpectedly found PRD DCA-JFK")
+	}
+
+	if _, err := NewFAADatabaseFromSnapshot(snapshot, 4321); err == nil {
+		t.Errorf("expected an error for a mismatched source hash")
+	}
+	for _, n := range []int{0, 10, len(snapshot) / 2, len(snapshot) - 1} {
+		if _, err := NewFAADatabaseFromSnapshot(snapshot[:n], 1234); err == nil {
+			t.Errorf("expected an error for a snapshot truncated to %d bytes", n)
+		}
+	}
+}
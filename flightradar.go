@@ -22,10 +22,33 @@ import (
 // control real-world aircraft from vice...
 
 type FlightRadarServer struct {
-	aircraft    map[string]*Aircraft
-	lastRequest time.Time
+	aircraft map[string]*Aircraft
+
+	// flightradar24 is polled in a separate goroutine so that the main
+	// thread never waits on the network.  The main thread periodically
+	// sends it the center of the region to poll via centerChan and
+	// receives the changes to the aircraft via updateChan; done is closed
+	// to stop polling.
+	centerChan       chan Point2LL
+	updateChan       chan flightRadarUpdate
+	done             chan interface{}
+	lastCenterUpdate time.Time
 }
 
+// flightRadarUpdate describes the changes to the aircraft found by a single
+// poll of flightradar24.
+type flightRadarUpdate struct {
+	added, modified []FlightRadarResponse
+	removed         []string // callsigns
+}
+
+// Don't poke flight rader more frequently than every 5s
+const flightRadarPollInterval = 5 * time.Second
+
+// Aircraft are removed if they haven't been reported for this long; it
+// matches the maxage parameter used in requests.
+const flightRadarMaxAge = 30 * time.Second
+
 // via https://github.com/Sequal32/vrclivetraffic/blob/master/src/flightradar.rs
 type FlightRadarResponse struct {
 	mode_s_code  string
@@ -154,8 +177,13 @@ func (fr *FlightRadarServer) GetWindowTitle() string { return "FlightRadar" }
 func (fr *FlightRadarServer) Connected() bool        { return fr.aircraft != nil }
 
 func (fr *FlightRadarServer) Disconnect() {
+	if fr.done != nil {
+		close(fr.done)
+		fr.done = nil
+	}
 	for _, ac := range fr.aircraft {
 		eventStream.Post(&RemovedAircraftEvent{ac: ac})
+		ac.Tracks.Release()
 	}
 	fr.aircraft = nil
 }
@@ -164,15 +192,31 @@ func (fr *FlightRadarServer) Callsign() string       { return "(none)" }
 func (fr *FlightRadarServer) CurrentTime() time.Time { return time.Now() }
 
 func (fr *FlightRadarServer) GetUpdates() {
-	// Don't poke flight rader more frequently than every 5s
-	if fr.aircraft == nil || time.Since(fr.lastRequest) < 5*time.Second {
+	if fr.aircraft == nil {
 		return
 	}
 
-	// 50nm radius, fixed. (It doesn't seem worth making this
-	// configurable...)
-	radius := float32(50)
+	if time.Since(fr.lastCenterUpdate) >= flightRadarPollInterval {
+		fr.lastCenterUpdate = time.Now()
+		select {
+		case fr.centerChan <- fr.center():
+		default:
+			// The poller hasn't picked up the last one yet.
+		}
+	}
+
+	for {
+		select {
+		case u := <-fr.updateChan:
+			fr.applyUpdate(u)
+		default:
+			return
+		}
+	}
+}
 
+// center returns the center of the region to request aircraft for.
+func (fr *FlightRadarServer) center() Point2LL {
 	center, ok := database.Locate(positionConfig.PrimaryRadarCenter)
 	if !ok {
 		// Try to find a center for the flight radar query by taking the
@@ -184,6 +228,136 @@ func (fr *FlightRadarServer) GetUpdates() {
 			}
 		})
 	}
+	return center
+}
+
+// applyUpdate updates the aircraft according to the changes found by
+// the poller and posts the corresponding events.
+func (fr *FlightRadarServer) applyUpdate(u flightRadarUpdate) {
+	now := time.Now()
+	// update returns the aspects of the aircraft that were changed.
+	update := func(ac *Aircraft, f *FlightRadarResponse) AircraftChanges {
+		changes := AircraftTrackChanged
+		squawk, err := ParseSquawk(f.squawkCode)
+		if err != nil {
+			lg.Errorf("Error parsing squawk \"%s\": %v", f.squawkCode, err)
+		}
+		if squawk != ac.Squawk {
+			changes |= AircraftSquawkChanged
+		}
+		ac.Squawk = squawk
+		ac.AddTrack(RadarTrack{
+			Position:    Point2LL{f.longitude, f.latitude},
+			Altitude:    f.altitude,
+			Groundspeed: f.speed,
+			Time:        now})
+		return changes
+	}
+
+	for i := range u.added {
+		f := &u.added[i]
+		if _, ok := fr.aircraft[f.callsign]; ok {
+			continue
+		}
+
+		ac := &Aircraft{Callsign: f.callsign}
+		ac.FlightPlan = &FlightPlan{}
+		ac.FlightPlan.DepartureAirport = f.origin
+		ac.FlightPlan.ArrivalAirport = f.destination
+		ac.FlightPlan.AircraftType = f.model
+		ac.Mode = Charlie
+		update(ac, f)
+		fr.aircraft[f.callsign] = ac
+		eventStream.Post(&AddedAircraftEvent{ac: ac})
+	}
+	for i := range u.modified {
+		f := &u.modified[i]
+		if ac, ok := fr.aircraft[f.callsign]; ok {
+			eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: update(ac, f)})
+		}
+	}
+	for _, callsign := range u.removed {
+		if ac, ok := fr.aircraft[callsign]; ok {
+			delete(fr.aircraft, callsign)
+			eventStream.Post(&RemovedAircraftEvent{ac: ac})
+			ac.Tracks.Release()
+		}
+	}
+}
+
+// pollFlightRadar runs asynchronously in a goroutine, polling
+// flightradar24 for the aircraft around the most recent center received
+// from centerChan and sending the changes since the previous poll on
+// updateChan.  It returns when done is closed.
+func pollFlightRadar(centerChan chan Point2LL, updateChan chan flightRadarUpdate, done chan interface{}) {
+	// Reuse connections across requests.
+	client := &http.Client{Timeout: 30 * time.Second}
+
+	// The most recent report for each aircraft and when it was received.
+	type reported struct {
+		f    FlightRadarResponse
+		time time.Time
+	}
+	aircraft := make(map[string]reported)
+
+	var center Point2LL
+	select {
+	case center = <-centerChan:
+	case <-done:
+		return
+	}
+
+	for {
+		// Pick up the latest center, if it has changed.
+		select {
+		case center = <-centerChan:
+		default:
+		}
+
+		start := time.Now()
+		if responses, err := fetchFlightRadar(client, center); err != nil {
+			lg.Errorf("%v", err)
+		} else {
+			var u flightRadarUpdate
+			for _, f := range responses {
+				if prev, ok := aircraft[f.callsign]; !ok {
+					u.added = append(u.added, f)
+				} else if prev.f != f {
+					u.modified = append(u.modified, f)
+				}
+				aircraft[f.callsign] = reported{f: f, time: start}
+			}
+			for callsign, r := range aircraft {
+				if start.Sub(r.time) > flightRadarMaxAge {
+					u.removed = append(u.removed, callsign)
+					delete(aircraft, callsign)
+				}
+			}
+
+			if len(u.added) > 0 || len(u.modified) > 0 || len(u.removed) > 0 {
+				select {
+				case updateChan <- u:
+					wakeMainLoop()
+				case <-done:
+					return
+				}
+			}
+		}
+
+		select {
+		case <-time.After(time.Until(start.Add(flightRadarPollInterval))):
+		case <-done:
+			return
+		}
+	}
+}
+
+// fetchFlightRadar requests the aircraft within 50nm of the given center
+// from flightradar24, decoding the response as it is received.
+func fetchFlightRadar(client *http.Client, center Point2LL) ([]FlightRadarResponse, error) {
+	// 50nm radius, fixed. (It doesn't seem worth making this
+	// configurable...)
+	radius := float32(50)
 
 	request := fmt.Sprintf("https://data-live.flightradar24.com/zones/fcgi/feed.js?bounds=%.2f,%.2f,%.2f,%.2f&faa=1&satellite=1&vehicles=1&mlat=1&flarm=1&adsb=1&gnd=1&air=1&estimated=1&maxage=30",
 		center.Latitude()+radius/database.NmPerLatitude,
@@ -191,100 +365,104 @@ func (fr *FlightRadarServer) GetUpdates() {
 		center.Longitude()-radius/database.NmPerLongitude,
 		center.Longitude()+radius/database.NmPerLongitude)
 
-	fr.lastRequest = time.Now()
-	response, err := http.Get(request)
+	response, err := client.Get(request)
 	if err != nil {
-		lg.Errorf("Error with flightradar GET: %v", err)
-		return
+		return nil, fmt.Errorf("Error with flightradar GET: %v", err)
 	}
 	defer response.Body.Close()
 
-	var text []byte
-	if text, err = io.ReadAll(response.Body); err != nil {
-		lg.Errorf("Error reading flightradar response: %v", err)
-		return
-	}
+	responses, err := decodeFlightRadar(response.Body)
+	// Consume anything that's left so that the connection can be reused.
+	io.Copy(io.Discard, response.Body)
 
-	// Slurp up the response as a general set of key/value pairs without
-	// trying to impose any more structure just yet.
-	var entries map[string]interface{}
-	if err := json.Unmarshal(text, &entries); err != nil {
-		lg.Errorf("Error unmarshaling flightradar response: %v", err)
+	return responses, err
+}
+
+// decodeFlightRadar decodes a flightradar24 feed response.  The response
+// is a JSON object that includes a variety of housekeeping values along
+// with an array of values for each aircraft; entries are decoded one at
+// a time as they are read.
+func decodeFlightRadar(r io.Reader) ([]FlightRadarResponse, error) {
+	dec := json.NewDecoder(r)
+	if tok, err := dec.Token(); err != nil {
+		return nil, fmt.Errorf("Error reading flightradar response: %v", err)
+	} else if tok != json.Delim('{') {
+		return nil, fmt.Errorf("Unexpected flightradar response: %v", tok)
 	}
 
-	for _, v := range entries {
+	var responses []FlightRadarResponse
+	for dec.More() {
+		// Skip the key.
+		if _, err := dec.Token(); err != nil {
+			return nil, fmt.Errorf("Error reading flightradar response: %v", err)
+		}
+
+		var v interface{}
+		if err := dec.Decode(&v); err != nil {
+			return nil, fmt.Errorf("Error unmarshaling flightradar response: %v", err)
+		}
+
 		// Is it an array of things? If so, it's an aircraft position
 		// update. (There's sundry other housekeeping in the response that
 		// we're not interested in and will ignore.)
-		if array, ok := v.([]interface{}); ok {
-			i := 0
-
-			// A few helper functions to decode elements of the array, with
-			// the assumption that they have various types. Note that they
-			// capture the local variable "i" and increment it after
-			// consuming a value.
-			getstring := func() string {
-				var s string
-				var ok bool
-				if s, ok = array[i].(string); !ok {
-					lg.Errorf("%d expected string, got %T: %+v", i, array[i], array[i])
-				}
-				i++
-				return s
-			}
-			getfloat64 := func() float64 {
-				var v float64
-				var ok bool
-				if v, ok = array[i].(float64); !ok {
-					lg.Errorf("%d expected float64, got %T: %+v", i, array[i], array[i])
-				}
-				i++
-				return v
+		array, ok := v.([]interface{})
+		if !ok {
+			continue
+		}
+		if len(array) < 19 {
+			lg.Errorf("Unexpected flightradar aircraft entry: %+v", array)
+			continue
+		}
+
+		i := 0
+
+		// A few helper functions to decode elements of the array, with
+		// the assumption that they have various types. Note that they
+		// capture the local variable "i" and increment it after
+		// consuming a value.
+		getstring := func() string {
+			var s string
+			var ok bool
+			if s, ok = array[i].(string); !ok {
+				lg.Errorf("%d expected string, got %T: %+v", i, array[i], array[i])
 			}
-			getint := func() int { return int(getfloat64()) }
-			getfloat32 := func() float32 { return float32(getfloat64()) }
-			getuint64 := func() uint64 { return uint64(getfloat64()) }
-
-			// #yolo to fill in a FlightRadarResponse from the array of entries.
-			f := FlightRadarResponse{getstring(), getfloat32(), getfloat32(),
-				getint(), getint(), getint(), getstring(), getstring(), getstring(),
-				getstring(), getuint64(), getstring(), getstring(), getstring(),
-				getint(), getint(), getstring(), getint(), getstring()}
-
-			// Convert the FlightRadarResponse into a RadarTrack that we
-			// can pass along to the client.
-			if f.callsign != "" {
-				squawk, err := ParseSquawk(f.squawkCode)
-				if err != nil {
-					lg.Errorf("Error parsing squawk \"%s\": %v", f.squawkCode, err)
-				}
-				pos := RadarTrack{
-					Position:    Point2LL{f.longitude, f.latitude},
-					Altitude:    f.altitude,
-					Groundspeed: f.speed,
-					Time:        time.Now()}
-
-				var ac *Aircraft
-				var ok bool
-				if ac, ok = fr.aircraft[f.callsign]; !ok {
-					ac = &Aircraft{Callsign: f.callsign}
-					ac.FlightPlan = &FlightPlan{}
-					ac.FlightPlan.DepartureAirport = f.origin
-					ac.FlightPlan.ArrivalAirport = f.destination
-					ac.FlightPlan.AircraftType = f.model
-					fr.aircraft[f.callsign] = ac
-					ac.Mode = Charlie
-					eventStream.Post(&AddedAircraftEvent{ac: ac})
-				} else {
-					eventStream.Post(&ModifiedAircraftEvent{ac: ac})
-				}
-				ac.Squawk = squawk
-				ac.AddTrack(pos)
+			i++
+			return s
+		}
+		getfloat64 := func() float64 {
+			var v float64
+			var ok bool
+			if v, ok = array[i].(float64); !ok {
+				lg.Errorf("%d expected float64, got %T: %+v", i, array[i], array[i])
 			}
+			i++
+			return v
+		}
+		getint := func() int { return int(getfloat64()) }
+		getfloat32 := func() float32 { return float32(getfloat64()) }
+		getuint64 := func() uint64 { return uint64(getfloat64()) }
+
+		// #yolo to fill in a FlightRadarResponse from the array of entries.
+		f := FlightRadarResponse{getstring(), getfloat32(), getfloat32(),
+			getint(), getint(), getint(), getstring(), getstring(), getstring(),
+			getstring(), getuint64(), getstring(), getstring(), getstring(),
+			getint(), getint(), getstring(), getint(), getstring()}
+
+		if f.callsign != "" {
+			responses = append(responses, f)
 		}
 	}
+
+	return responses, nil
 }
 
 func NewFlightRadarServer() *FlightRadarServer {
-	return &FlightRadarServer{aircraft: make(map[string]*Aircraft)}
+	fr := &FlightRadarServer{
+		aircraft:   make(map[string]*Aircraft),
+		centerChan: make(chan Point2LL, 1),
+		updateChan: make(chan flightRadarUpdate, 4),
+		done:       make(chan interface{}),
+	}
+	go pollFlightRadar(fr.centerChan, fr.updateChan, fr.done)
+	return fr
 }
@@ -11,6 +11,7 @@ import (
 	"math"
 	"runtime"
 	"sort"
+	"sync"
 	"unicode/utf8"
 	"unsafe"
 
@@ -133,11 +134,42 @@ type Font struct {
 	// The remaining glyphs (generally, the used FontAwesome icons, are
 	// stored in a map.
 	glyphs map[rune]*Glyph
+	// Glyphs are created lazily, possibly while Panes are being drawn
+	// concurrently, so access to lowGlyphs and glyphs is serialized.
+	glyphsMutex sync.Mutex
 	// Font size
 	size  int
 	mono  bool
 	ifont imgui.Font
 	id    FontIdentifier
+
+	// Fonts are only added to imgui's font atlas after they are first
+	// requested via GetFont; until then, the default font's glyphs are
+	// used in their place.
+	loaded  bool
+	ttfZstd string
+	// The size to rasterize the font at; size is its truncation.
+	rasterSize float32
+}
+
+// fontAtlas records the state of the font atlas, which holds all of the
+// fonts that have been loaded so far.
+var fontAtlas struct {
+	// The Font Awesome fonts are merged into each font that is loaded.
+	faTTF, fabrTTF                   []byte
+	faGlyphRange, faBrandsGlyphRange imgui.GlyphRanges
+
+	textureID uint32
+
+	// Fonts that have been requested but not yet loaded.  GetFont may be
+	// called while Panes are being drawn concurrently, hence the mutex.
+	pendingMutex sync.Mutex
+	pending      map[*Font]interface{}
+
+	// Generation is incremented each time the atlas is rebuilt, which
+	// changes the glyphs' texture coordinates; anything that holds on to
+	// drawing commands for text must regenerate them when it changes.
+	generation int
 }
 
 // While the following could be found via the imgui.FontGlyph interface, cgo calls into C++ code are
@@ -169,8 +201,16 @@ func (f *Font) createGlyph(ch rune) *Glyph {
 		AdvanceX: ig.AdvanceX(), Visible: ig.Visible()}
 }
 
-// LookupGlyph returns the Glyph for the specified rune.
+// LookupGlyph returns the Glyph for the specified rune.  It may be called
+// concurrently from multiple goroutines.
 func (f *Font) LookupGlyph(ch rune) *Glyph {
+	if !f.loaded {
+		return GetDefaultFont().LookupGlyph(ch)
+	}
+
+	f.glyphsMutex.Lock()
+	defer f.glyphsMutex.Unlock()
+
 	if int(ch) < len(f.lowGlyphs) {
 		if g := f.lowGlyphs[ch]; g == nil {
 			g = f.createGlyph(ch)
@@ -188,6 +228,14 @@ func (f *Font) LookupGlyph(ch rune) *Glyph {
 	}
 }
 
+// ImguiFont returns the imgui.Font to use for drawing the font with imgui.
+func (f *Font) ImguiFont() imgui.Font {
+	if !f.loaded {
+		return GetDefaultFont().ifont
+	}
+	return f.ifont
+}
+
 // Returns the bound of the specified text in the given font, assuming the
 // given pixel spacing between lines.
 func (font *Font) BoundText(s string, spacing int) (int, int) {
@@ -220,10 +268,15 @@ func ptrToUint16Slice(p unsafe.Pointer) []uint16 {
 	return (*[unrealisticLargePointer / 2]uint16)(p)[:]
 }
 
+// fontSizes gives the sizes at which all of the fonts are available.
+var fontSizes = []int{8, 9, 10, 11, 12, 13, 14, 16, 18, 20, 22, 24}
+
+// fontsInit registers all of the available fonts; only the default font
+// is loaded immediately, and the others are loaded by fontsUpdate once
+// they have first been requested.
 func fontsInit(r Renderer) {
 	lg.Printf("Starting to initialize fonts")
 	fonts = make(map[FontIdentifier]*Font)
-	io := imgui.CurrentIO()
 
 	// Given a map that specifies the icons used in an icon font, returns
 	// an imgui.GlyphRanges that encompasses those icons.  This GlyphRanges
@@ -251,14 +304,14 @@ func fontsInit(r Renderer) {
 	}
 
 	// Decompress and get the glyph ranges for the Font Awesome fonts just once.
-	faTTF := []byte(decompressZstd(fa5SolidTTF))
-	faGlyphRange := glyphRangeForIcons(faUsedIcons)
-	fabrTTF := []byte(decompressZstd(fa5BrandsRegularTTF))
-	faBrandsGlyphRange := glyphRangeForIcons(faBrandsUsedIcons)
+	fontAtlas.faTTF = []byte(decompressZstd(fa5SolidTTF))
+	fontAtlas.faGlyphRange = glyphRangeForIcons(faUsedIcons)
+	fontAtlas.fabrTTF = []byte(decompressZstd(fa5BrandsRegularTTF))
+	fontAtlas.faBrandsGlyphRange = glyphRangeForIcons(faBrandsUsedIcons)
+	fontAtlas.pending = make(map[*Font]interface{})
 
 	add := func(ttfZstd string, mono bool, name string) {
-		ttf := []byte(decompressZstd(ttfZstd))
-		for _, size := range []int{8, 9, 10, 11, 12, 13, 14, 16, 18, 20, 22, 24} {
+		for _, size := range fontSizes {
 			sp := float32(size)
 			if runtime.GOOS == "windows" {
 				// Fix font sizes to account for Windows using 96dpi but
@@ -266,22 +319,15 @@ func fontsInit(r Renderer) {
 				sp *= 96. / 72.
 			}
 
-			ifont := io.Fonts().AddFontFromMemoryTTFV(ttf, sp, imgui.DefaultFontConfig, imgui.EmptyGlyphRanges)
-
-			config := imgui.NewFontConfig()
-			config.SetMergeMode(true)
-			// Scale down the font size by an ad-hoc factor to (generally)
-			// make the icon sizes match the font's character sizes.
-			io.Fonts().AddFontFromMemoryTTFV(faTTF, .8*sp, config, faGlyphRange)
-			io.Fonts().AddFontFromMemoryTTFV(fabrTTF, .8*sp, config, faBrandsGlyphRange)
-
 			id := FontIdentifier{Name: name, Size: size}
 			fonts[id] = &Font{
-				glyphs: make(map[rune]*Glyph),
-				size:   int(sp),
-				mono:   mono,
-				ifont:  ifont,
-				id:     id}
+				glyphs:     make(map[rune]*Glyph),
+				size:       int(sp),
+				mono:       mono,
+				id:         id,
+				ttfZstd:    ttfZstd,
+				rasterSize: sp,
+			}
 		}
 	}
 
@@ -303,14 +349,85 @@ func fontsInit(r Renderer) {
 	add(shareTechMonoRegularTTF, true, "ShareTech Mono Regular")
 	add(ibmEGA8x14, true, "IBM EGA 8x14")
 
-	image := io.Fonts().TextureDataRGBA32()
-	lg.Printf("Fonts texture used %.1f MB", float32(image.Width*image.Height*4)/(1024*1024))
-	fontId := r.CreateRGBA8Texture(image.Width, image.Height, image.Pixels)
-	io.Fonts().SetTextureID(imgui.TextureID(fontId))
+	// The first font added to the atlas is imgui's default; it was
+	// Cousine Regular 8 when all of the fonts were loaded up front, so
+	// keep it that way.  The default font is used in place of fonts that
+	// haven't been loaded yet, so it must always be available.
+	fontsLoad([]*Font{fonts[FontIdentifier{Name: "Cousine Regular", Size: 8}], GetDefaultFont()}, r)
 
 	lg.Printf("Finished initializing fonts")
 }
 
+// fontsUpdate loads any fonts that have been requested since it was last
+// called.  It must be called on the main thread, outside of an imgui
+// frame, since adding fonts requires rebuilding imgui's font atlas.
+func fontsUpdate(r Renderer) {
+	fontAtlas.pendingMutex.Lock()
+	var load []*Font
+	for f := range fontAtlas.pending {
+		load = append(load, f)
+	}
+	fontAtlas.pending = make(map[*Font]interface{})
+	fontAtlas.pendingMutex.Unlock()
+
+	if len(load) > 0 {
+		fontsLoad(load, r)
+	}
+}
+
+// fontsLoad adds the given fonts to the font atlas and then updates its
+// texture.
+func fontsLoad(load []*Font, r Renderer) {
+	io := imgui.CurrentIO()
+
+	ttfs := make(map[string][]byte) // decompress each one just once
+	for _, f := range load {
+		if f.loaded {
+			continue
+		}
+
+		ttf, ok := ttfs[f.ttfZstd]
+		if !ok {
+			ttf = []byte(decompressZstd(f.ttfZstd))
+			ttfs[f.ttfZstd] = ttf
+		}
+
+		sp := f.rasterSize
+		f.ifont = io.Fonts().AddFontFromMemoryTTFV(ttf, sp, imgui.DefaultFontConfig, imgui.EmptyGlyphRanges)
+
+		config := imgui.NewFontConfig()
+		config.SetMergeMode(true)
+		// Scale down the font size by an ad-hoc factor to (generally)
+		// make the icon sizes match the font's character sizes.
+		io.Fonts().AddFontFromMemoryTTFV(fontAtlas.faTTF, .8*sp, config, fontAtlas.faGlyphRange)
+		io.Fonts().AddFontFromMemoryTTFV(fontAtlas.fabrTTF, .8*sp, config, fontAtlas.faBrandsGlyphRange)
+
+		f.loaded = true
+		lg.Printf("Loaded font %s %d", f.id.Name, f.id.Size)
+	}
+
+	// Getting the texture rebuilds the atlas, which changes the texture
+	// coordinates of existing glyphs.
+	image := io.Fonts().TextureDataRGBA32()
+	lg.Printf("Fonts texture used %.1f MB", float32(image.Width*image.Height*4)/(1024*1024))
+	if fontAtlas.textureID == 0 {
+		fontAtlas.textureID = r.CreateRGBA8Texture(image.Width, image.Height, image.Pixels)
+	} else {
+		r.UpdateRGBA8Texture(fontAtlas.textureID, image.Width, image.Height, image.Pixels)
+	}
+	io.Fonts().SetTextureID(imgui.TextureID(fontAtlas.textureID))
+
+	for _, f := range fonts {
+		if f.loaded {
+			f.glyphsMutex.Lock()
+			f.lowGlyphs = [128]*Glyph{}
+			f.glyphs = make(map[rune]*Glyph)
+			f.glyphsMutex.Unlock()
+		}
+	}
+	fontAtlas.generation++
+}
+
 // GetAllFonts returns a FontIdentifier slice that gives identifiers for
 // all of the available fonts, sorted by font name and then within each
 // name, by font size.
@@ -341,7 +458,7 @@ func DrawFontPicker(id *FontIdentifier, label string) (newFont *Font, changed bo
 				lastFontName = font.Name
 				// Use the 14pt version of the font in the combo box.
 				displayFont := GetFont(FontIdentifier{Name: font.Name, Size: 14})
-				imgui.PushFont(displayFont.ifont)
+				imgui.PushFont(displayFont.ImguiFont())
 				if imgui.SelectableV(font.Name, id.Name == font.Name, 0, imgui.Vec2{}) {
 					id.Name = font.Name
 					changed = true
@@ -369,8 +486,16 @@ func DrawFontPicker(id *FontIdentifier, label string) (newFont *Font, changed bo
 	return
 }
 
+// GetFont returns the specified font, or nil if it isn't available.  If
+// it hasn't been loaded yet, it is loaded by the next call to fontsUpdate;
+// until then, it is drawn using the default font.
 func GetFont(id FontIdentifier) *Font {
 	if font, ok := fonts[id]; ok {
+		if !font.loaded {
+			fontAtlas.pendingMutex.Lock()
+			fontAtlas.pending[font] = nil
+			fontAtlas.pendingMutex.Unlock()
+		}
 		return font
 	} else {
 		return nil
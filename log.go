@@ -10,8 +10,10 @@ import (
 	"path"
 	"runtime"
 	"runtime/debug"
+	"strconv"
 	"strings"
 	"sync"
+	"sync/atomic"
 	"time"
 )
 
@@ -26,6 +28,28 @@ type Logger struct {
 	err           *CircularLogBuffer
 	start         time.Time
 	monitors      map[ErrorMonitor]interface{}
+
+	// When asynchronous logging has been enabled via StartAsync, Printf
+	// just records the message's format string, arguments, and where it
+	// came from and then queues it up; a separate goroutine formats it and
+	// adds it to the verbose log.  (Messages with arguments that the
+	// caller may modify later are formatted before they are queued.)
+	// Messages are dropped if the queue is full so that logging never
+	// stalls the caller; dropped counts how many have been dropped that
+	// the log's goroutine hasn't reported yet.
+	queue   chan logRecord
+	dropped int32
+}
+
+// logRecord stores everything needed to format a log message later.  If
+// flushed is non-nil, the record isn't a message; the channel is closed
+// once all previously-queued messages have been processed.
+type logRecord struct {
+	f       string
+	args    []interface{}
+	pc      uintptr
+	offset  time.Duration
+	flushed chan struct{}
 }
 
 // ErrorMonitor is an interface for objects that wish to be made aware of
@@ -119,6 +143,11 @@ func (l *Logger) printf(levels int, f string, args ...interface{}) {
 		return
 	}
 
+	if l.queue != nil {
+		l.enqueue(levels, f, args)
+		return
+	}
+
 	msg := l.format(levels, f, args...)
 	if l.printToStderr {
 		fmt.Fprint(os.Stderr, msg)
@@ -129,6 +158,89 @@ func (l *Logger) printf(levels int, f string, args ...interface{}) {
 	l.verbose.Add(msg)
 }
 
+// StartAsync switches the logger to asynchronous logging of verbose
+// messages, with at most queueLength of them waiting to be processed.
+// Errors are still logged synchronously so that ErrorMonitors hear about
+// them immediately.  StartAsync should be called before the Logger is used
+// by multiple goroutines.
+func (l *Logger) StartAsync(queueLength int) {
+	if l.verbose == nil || l.queue != nil {
+		return
+	}
+
+	l.queue = make(chan logRecord, queueLength)
+	go func() {
+		for r := range l.queue {
+			if r.flushed != nil {
+				close(r.flushed)
+				continue
+			}
+
+			frame, _ := runtime.CallersFrames([]uintptr{r.pc}).Next()
+			msg := formatLogMessage(r.offset, frame.File, frame.Line, r.f, r.args...)
+			// Claim the count of dropped messages so that each one is
+			// only reported once.
+			if dropped := atomic.SwapInt32(&l.dropped, 0); dropped > 0 {
+				msg = fmt.Sprintf("(%d log messages dropped)\n", dropped) + msg
+			}
+			if l.printToStderr {
+				fmt.Fprint(os.Stderr, msg)
+			}
+
+			l.mu.Lock()
+			l.verbose.Add(msg)
+			l.mu.Unlock()
+		}
+	}()
+}
+
+// enqueue queues a message for the log's goroutine, doing as little work
+// as possible in the caller.
+func (l *Logger) enqueue(levels int, f string, args []interface{}) {
+	var pc [1]uintptr
+	runtime.Callers(levels+1, pc[:])
+
+	// Formatting is only deferred to the log's goroutine if all of the
+	// arguments are values that the caller can't change out from under
+	// it; anything else (pointers, maps, slices, structs that hold them,
+	// ...) would otherwise be read concurrently with its owner.
+	if !logArgsAreValues(args) {
+		f, args = "%s", []interface{}{fmt.Sprintf(f, args...)}
+	}
+
+	r := logRecord{f: f, args: args, pc: pc[0], offset: time.Since(l.start)}
+	select {
+	case l.queue <- r:
+	default:
+		atomic.AddInt32(&l.dropped, 1)
+	}
+}
+
+// logArgsAreValues returns true if all of the given arguments are strings,
+// numbers, or bools.
+func logArgsAreValues(args []interface{}) bool {
+	for _, a := range args {
+		switch a.(type) {
+		case string, bool, int, int8, int16, int32, int64, uint, uint8, uint16, uint32, uint64,
+			uintptr, float32, float64, time.Duration:
+		default:
+			return false
+		}
+	}
+	return true
+}
+
+// Flush returns once all of the log messages that have been queued so
+// far have been added to the log.
+func (l *Logger) Flush() {
+	if l.queue == nil {
+		return
+	}
+	flushed := make(chan struct{})
+	l.queue <- logRecord{flushed: flushed}
+	<-flushed
+}
+
 // Errorf adds the given message, specified using Printf-style format
 // string, to the error log.
 func (l *Logger) Errorf(f string, args ...interface{}) {
@@ -177,10 +289,16 @@ func (l *Logger) GetVerboseLog() string {
 	if l.verbose == nil {
 		return ""
 	}
+	l.Flush()
+
+	l.mu.Lock()
+	defer l.mu.Unlock()
 	return l.verbose.String()
 }
 
 func (l *Logger) GetErrorLog() string {
+	l.mu.Lock()
+	defer l.mu.Unlock()
 	return l.err.String()
 }
 
@@ -191,22 +309,29 @@ func (l *Logger) format(levels int, f string, args ...interface{}) string {
 	// Go up the call stack the specified nubmer of levels
 	_, fn, line, _ := runtime.Caller(levels)
 
+	return formatLogMessage(time.Since(l.start), fn, line, f, args...)
+}
+
+// formatLogMessage formats a log message given the time since logging
+// started and the source file and line it was logged from.
+func formatLogMessage(offset time.Duration, fn string, line int, f string, args ...interface{}) string {
+	var b strings.Builder
+
 	// Elapsed time
-	s := fmt.Sprintf("%8.2fs ", time.Since(l.start).Seconds())
+	fmt.Fprintf(&b, "%8.2fs ", offset.Seconds())
 
 	// Source file and line
-	fnline := path.Base(fn) + fmt.Sprintf(":%d", line)
-	s += fmt.Sprintf("%-20s ", fnline)
+	fmt.Fprintf(&b, "%-20s ", path.Base(fn)+":"+strconv.Itoa(line))
 
 	// Add the provided logging message.
-	s += fmt.Sprintf(f, args...)
+	fmt.Fprintf(&b, f, args...)
 
 	// The message shouldn't have a newline at the end but if it does, we
 	// won't gratuitously add another one.
-	if !strings.HasSuffix(s, "\n") {
-		s += "\n"
+	if !strings.HasSuffix(b.String(), "\n") {
+		b.WriteByte('\n')
 	}
-	return s
+	return b.String()
 }
 
 // Stats collects a few statistics related to rendering and time spent in
@@ -218,6 +343,9 @@ type Stats struct {
 	drawPanes time.Duration
 	startTime time.Time
 	redraws   int
+
+	// Only set if there's been a VATSIM network connection.
+	vatsimSend VATSIMSendStats
 }
 
 var startupMallocs uint64
@@ -244,6 +372,9 @@ func (l *Logger) LogStats(stats Stats) {
 
 	lg.Printf("Stats: rendering: %s", stats.render.String())
 	lg.Printf("Stats: UI rendering: %s", stats.renderUI.String())
+	if stats.vatsimSend != (VATSIMSendStats{}) {
+		lg.Printf("Stats: VATSIM send: %s", stats.vatsimSend.String())
+	}
 }
 
 func (l *Logger) SaveLogs() {
@@ -254,6 +385,6 @@ func (l *Logger) SaveLogs() {
 	}
 
 	fn := path.Join(dir, "Vice", "vice.log")
-	s := l.verbose.String() + "\n-----\nErrors:\n" + l.err.String()
+	s := l.GetVerboseLog() + "\n-----\nErrors:\n" + l.GetErrorLog()
 	os.WriteFile(fn, []byte(s), 0600)
 }
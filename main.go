@@ -50,6 +50,7 @@ var (
 	memprofile = flag.String("memprofile", "", "write memory profile to this file")
 	devmode    = flag.Bool("devmode", false, "developer mode")
 	replayFile = flag.String("replay", "", "*.vsess filename for replay")
+	benchmark  = flag.String("benchmark", "", "*.vsess filename to replay without a window, reporting performance")
 )
 
 func init() {
@@ -89,6 +90,7 @@ func main() {
 
 	// Initialize the logging system first and foremost.
 	lg = NewLogger(true, *devmode, 50000)
+	lg.StartAsync(4096)
 
 	if *cpuprofile != "" {
 		if f, err := os.Create(*cpuprofile); err != nil {
@@ -102,6 +104,16 @@ func main() {
 		}
 	}
 
+	if *benchmark != "" {
+		context = benchmarkInit(true)
+		if results, err := runReplayBenchmark(*benchmark); err != nil {
+			fmt.Fprintf(os.Stderr, "%s: unable to run benchmark: %v\n", *benchmark, err)
+		} else {
+			fmt.Print(results)
+		}
+		return
+	}
+
 	context = imguiInit()
 
 	server = &DisconnectedATCServer{}
@@ -174,10 +186,18 @@ func main() {
 	for {
 		platform.SetWindowTitle("vice: " + server.GetWindowTitle())
 
-		// Inform imgui about input events from the user.
-		platform.ProcessEvents()
+		// Inform imgui about input events from the user. If nothing has
+		// been happening, first wait for input, data from the network,
+		// or the next time a Pane needs to be redrawn, rather than
+		// redrawing continuously.
+		if timeout := wmIdleTimeout(); timeout > 0 {
+			wmNoteEvents(platform.WaitEvents(timeout))
+		} else {
+			wmNoteEvents(platform.ProcessEvents())
+		}
 
 		stats.redraws++
+		profiler.BeginFrame()
 
 		lastTime := time.Now()
 		timeMarker := func(d *time.Duration) {
@@ -189,24 +209,41 @@ func main() {
 		// Let the world update its state based on messages from the
 		// network; a synopsis of changes to aircraft is then passed along
 		// to the window panes and the active positionConfig.
+		scope := profiler.Begin("updates", "updates", 0)
 		positionConfig.SendUpdates()
 		server.GetUpdates()
 		positionConfig.Update()
 		audioProcessEvents(eventStream)
+		scope.End()
+
+		// Load any fonts that were requested last frame; this must happen
+		// before the imgui frame starts.
+		scope = profiler.Begin("fonts", "updates", 0)
+		fontsUpdate(renderer)
+		scope.End()
 
 		platform.NewFrame()
 		imgui.NewFrame()
 
 		// Generate and render vice draw lists
+		scope = profiler.Begin("panes", "panes", 0)
 		wmDrawPanes(platform, renderer)
+		scope.End()
 		timeMarker(&stats.drawPanes)
 
 		// Draw the user interface
+		scope = profiler.Begin("ui", "ui", 0)
 		drawUI(positionConfig.GetColorScheme(), platform)
+		scope.End()
 		timeMarker(&stats.drawImgui)
 
 		// Wait for vsync
+		scope = profiler.Begin("swap", "render", 0)
 		platform.PostRender()
+		scope.End()
+		profiler.EndFrame()
+
+		globalConfig.MaybeAutosave()
 
 		// Periodically log current memory use, etc.
 		if (*devmode && frameIndex%600 == 0) || frameIndex%3600 == 0 {
@@ -9,6 +9,8 @@ import (
 	"fmt"
 	"image"
 	"math"
+	"runtime"
+	"sync"
 	"unsafe"
 
 	"github.com/go-gl/gl/v2.1/gl"
@@ -19,6 +21,16 @@ type OpenGL2Renderer struct {
 	imguiIO imgui.IO
 
 	createdTextures map[uint32]int
+
+	// Vertex buffer objects holding the contents of static
+	// CommandBuffers, along with their sizes in bytes.
+	staticBuffers map[uint32]int
+	// Buffer objects for static CommandBuffers that have been garbage
+	// collected; they are deleted the next time a CommandBuffer is
+	// rendered, since OpenGL calls can only be made from the main
+	// thread.
+	freedBuffersMutex sync.Mutex
+	freedBuffers      []uint32
 }
 
 // NewOpenGL2Renderer creates an OpenGL context and creates a texture for the imgui fonts.
@@ -36,6 +48,7 @@ func NewOpenGL2Renderer(io imgui.IO) (Renderer, error) {
 	return &OpenGL2Renderer{
 		imguiIO:         io,
 		createdTextures: make(map[uint32]int),
+		staticBuffers:   make(map[uint32]int),
 	}, nil
 }
 
@@ -43,6 +56,9 @@ func (ogl2 *OpenGL2Renderer) Dispose() {
 	for texid := range ogl2.createdTextures {
 		gl.DeleteTextures(1, &texid)
 	}
+	for vbo := range ogl2.staticBuffers {
+		gl.DeleteBuffers(1, &vbo)
+	}
 }
 
 func (ogl2 *OpenGL2Renderer) CreateRGBA8Texture(w, h int, rgba unsafe.Pointer) uint32 {
@@ -65,6 +81,19 @@ func (ogl2 *OpenGL2Renderer) CreateRGBA8Texture(w, h int, rgba unsafe.Pointer) u
 	return texid
 }
 
+func (ogl2 *OpenGL2Renderer) UpdateRGBA8Texture(texid uint32, w, h int, rgba unsafe.Pointer) {
+	var lastTexture int32
+	gl.GetIntegerv(gl.TEXTURE_BINDING_2D, &lastTexture)
+
+	gl.BindTexture(gl.TEXTURE_2D, texid)
+	gl.PixelStorei(gl.UNPACK_ROW_LENGTH, 0)
+	gl.TexImage2D(gl.TEXTURE_2D, 0, gl.RGBA, int32(w), int32(h), 0, gl.RGBA, gl.UNSIGNED_BYTE, rgba)
+
+	gl.BindTexture(gl.TEXTURE_2D, uint32(lastTexture))
+
+	ogl2.createdTexture(texid, w*h*4)
+}
+
 func (ogl2 *OpenGL2Renderer) createdTexture(texid uint32, bytes int) {
 	_, exists := ogl2.createdTextures[texid]
 
@@ -146,10 +175,93 @@ func (ogl2 *OpenGL2Renderer) UpdateTextureFromImage(texid uint32, img image.Imag
 	ogl2.createdTexture(texid, bytes)
 }
 
+// uploadStaticBuffer makes sure that there is an up to date vertex buffer
+// object with the contents of the given static CommandBuffer, returning
+// the number of bytes uploaded.
+func (ogl2 *OpenGL2Renderer) uploadStaticBuffer(cb *CommandBuffer) int {
+	sb := cb.static
+	if sb.handle != 0 && !sb.dirty {
+		return 0
+	}
+
+	nbytes := 4 * len(cb.buf)
+	if sb.handle == 0 {
+		gl.GenBuffers(1, &sb.handle)
+		gl.BindBuffer(gl.ARRAY_BUFFER, sb.handle)
+		gl.BufferData(gl.ARRAY_BUFFER, nbytes, unsafe.Pointer(&cb.buf[0]), gl.STATIC_DRAW)
+		ogl2.staticBuffers[sb.handle] = nbytes
+
+		// Free the buffer object once the CommandBuffer is no longer
+		// reachable.
+		runtime.SetFinalizer(sb, func(sb *StaticBufferState) {
+			ogl2.freedBuffersMutex.Lock()
+			ogl2.freedBuffers = append(ogl2.freedBuffers, sb.handle)
+			ogl2.freedBuffersMutex.Unlock()
+		})
+	} else {
+		// Only colors are ever updated, but it's easiest to upload the
+		// whole thing again.
+		gl.BindBuffer(gl.ARRAY_BUFFER, sb.handle)
+		gl.BufferSubData(gl.ARRAY_BUFFER, 0, nbytes, unsafe.Pointer(&cb.buf[0]))
+	}
+	sb.dirty = false
+
+	return nbytes
+}
+
+func (ogl2 *OpenGL2Renderer) deleteFreedBuffers() {
+	ogl2.freedBuffersMutex.Lock()
+	defer ogl2.freedBuffersMutex.Unlock()
+
+	for _, vbo := range ogl2.freedBuffers {
+		gl.DeleteBuffers(1, &vbo)
+		delete(ogl2.staticBuffers, vbo)
+	}
+	ogl2.freedBuffers = ogl2.freedBuffers[:0]
+}
+
 func (ogl2 *OpenGL2Renderer) RenderCommandBuffer(cb *CommandBuffer) RendererStats {
+	ogl2.deleteFreedBuffers()
+
+	stats := ogl2.renderCommandBuffer(cb)
+
+	// Leave things as expected by code that uses client-side arrays.
+	gl.BindBuffer(gl.ARRAY_BUFFER, 0)
+	gl.BindBuffer(gl.ELEMENT_ARRAY_BUFFER, 0)
+
+	return stats
+}
+
+func (ogl2 *OpenGL2Renderer) renderCommandBuffer(cb *CommandBuffer) RendererStats {
 	var stats RendererStats
 	stats.nBuffers++
-	stats.bufferBytes += 4 * len(cb.buf)
+
+	// For static CommandBuffers, vertex and index arrays are sourced from
+	// the buffer object holding its contents, in which case array
+	// "pointers" are just offsets into it. Otherwise they are pointers to
+	// the arrays in the CommandBuffer itself.
+	static := cb.static != nil && len(cb.buf) > 0
+	if static {
+		stats.bufferBytes += ogl2.uploadStaticBuffer(cb)
+	} else {
+		stats.bufferBytes += 4 * len(cb.buf)
+	}
+	bindBuffers := func() {
+		var vbo uint32
+		if static {
+			vbo = cb.static.handle
+		}
+		gl.BindBuffer(gl.ARRAY_BUFFER, vbo)
+		gl.BindBuffer(gl.ELEMENT_ARRAY_BUFFER, vbo)
+	}
+	bindBuffers()
+	arrayPointer := func(offset uint32) unsafe.Pointer {
+		if static {
+			return gl.PtrOffset(int(offset))
+		}
+		ptr := uintptr(unsafe.Pointer(&cb.buf[0])) + uintptr(offset)
+		return unsafe.Pointer(ptr)
+	}
 
 	i := 0
 	ui32 := func() uint32 {
@@ -231,41 +343,37 @@ func (ogl2 *OpenGL2Renderer) RenderCommandBuffer(cb *CommandBuffer) RendererStat
 
 		case RendererVertexArray:
 			gl.EnableClientState(gl.VERTEX_ARRAY)
-			offset := ui32()
-			ptr := uintptr(unsafe.Pointer(&cb.buf[0])) + uintptr(offset)
+			ptr := arrayPointer(ui32())
 			nc := i32()
 			stride := i32()
-			gl.VertexPointer(nc, gl.FLOAT, stride, unsafe.Pointer(ptr))
+			gl.VertexPointer(nc, gl.FLOAT, stride, ptr)
 
 		case RendererDisableVertexArray:
 			gl.DisableClientState(gl.VERTEX_ARRAY)
 
 		case RendererRGB32Array:
 			gl.EnableClientState(gl.COLOR_ARRAY)
-			offset := ui32()
-			ptr := uintptr(unsafe.Pointer(&cb.buf[0])) + uintptr(offset)
+			ptr := arrayPointer(ui32())
 			nc := i32()
 			stride := i32()
-			gl.ColorPointer(nc, gl.FLOAT, stride, unsafe.Pointer(ptr))
+			gl.ColorPointer(nc, gl.FLOAT, stride, ptr)
 
 		case RendererRGB8Array:
 			gl.EnableClientState(gl.COLOR_ARRAY)
-			offset := ui32()
-			ptr := uintptr(unsafe.Pointer(&cb.buf[0])) + uintptr(offset)
+			ptr := arrayPointer(ui32())
 			nc := i32()
 			stride := i32()
-			gl.ColorPointer(nc, gl.UNSIGNED_BYTE, stride, unsafe.Pointer(ptr))
+			gl.ColorPointer(nc, gl.UNSIGNED_BYTE, stride, ptr)
 
 		case RendererDisableColorArray:
 			gl.DisableClientState(gl.COLOR_ARRAY)
 
 		case RendererTexCoordArray:
 			gl.EnableClientState(gl.TEXTURE_COORD_ARRAY)
-			offset := ui32()
-			ptr := uintptr(unsafe.Pointer(&cb.buf[0])) + uintptr(offset)
+			ptr := arrayPointer(ui32())
 			nc := i32()
 			stride := i32()
-			gl.TexCoordPointer(nc, gl.FLOAT, stride, unsafe.Pointer(ptr))
+			gl.TexCoordPointer(nc, gl.FLOAT, stride, ptr)
 
 		case RendererDisableTexCoordArray:
 			gl.DisableClientState(gl.TEXTURE_COORD_ARRAY)
@@ -274,8 +382,7 @@ func (ogl2 *OpenGL2Renderer) RenderCommandBuffer(cb *CommandBuffer) RendererStat
 			gl.PointSize(float())
 
 		case RendererDrawPoints:
-			offset := ui32()
-			ptr := uintptr(unsafe.Pointer(&cb.buf[0])) + uintptr(offset)
+			ptr := arrayPointer(ui32())
 			count := i32()
 
 			gl.Enable(gl.ALPHA_TEST)
@@ -285,7 +392,7 @@ func (ogl2 *OpenGL2Renderer) RenderCommandBuffer(cb *CommandBuffer) RendererStat
 			gl.Enable(gl.POINT_SMOOTH)
 			gl.Hint(gl.POINT_SMOOTH_HINT, gl.NICEST)
 
-			gl.DrawElements(gl.POINTS, count, gl.UNSIGNED_INT, unsafe.Pointer(ptr))
+			gl.DrawElements(gl.POINTS, count, gl.UNSIGNED_INT, ptr)
 			stats.nDrawCalls++
 			stats.nPoints += int(count)
 
@@ -297,28 +404,25 @@ func (ogl2 *OpenGL2Renderer) RenderCommandBuffer(cb *CommandBuffer) RendererStat
 			gl.LineWidth(float())
 
 		case RendererDrawLines:
-			offset := ui32()
-			ptr := uintptr(unsafe.Pointer(&cb.buf[0])) + uintptr(offset)
+			ptr := arrayPointer(ui32())
 			count := i32()
-			gl.DrawElements(gl.LINES, count, gl.UNSIGNED_INT, unsafe.Pointer(ptr))
+			gl.DrawElements(gl.LINES, count, gl.UNSIGNED_INT, ptr)
 
 			stats.nDrawCalls++
 			stats.nLines += int(count / 2)
 
 		case RendererDrawTriangles:
-			offset := ui32()
-			ptr := uintptr(unsafe.Pointer(&cb.buf[0])) + uintptr(offset)
+			ptr := arrayPointer(ui32())
 			count := i32()
-			gl.DrawElements(gl.TRIANGLES, count, gl.UNSIGNED_INT, unsafe.Pointer(ptr))
+			gl.DrawElements(gl.TRIANGLES, count, gl.UNSIGNED_INT, ptr)
 
 			stats.nDrawCalls++
 			stats.nTriangles += int(count / 3)
 
 		case RendererDrawQuads:
-			offset := ui32()
-			ptr := uintptr(unsafe.Pointer(&cb.buf[0])) + uintptr(offset)
+			ptr := arrayPointer(ui32())
 			count := i32()
-			gl.DrawElements(gl.QUADS, count, gl.UNSIGNED_INT, unsafe.Pointer(ptr))
+			gl.DrawElements(gl.QUADS, count, gl.UNSIGNED_INT, ptr)
 
 			stats.nDrawCalls++
 			stats.nQuads += int(count / 4)
@@ -334,8 +438,11 @@ func (ogl2 *OpenGL2Renderer) RenderCommandBuffer(cb *CommandBuffer) RendererStat
 
 		case RendererCallBuffer:
 			idx := ui32()
-			s2 := ogl2.RenderCommandBuffer(&cb.called[idx])
+			s2 := ogl2.renderCommandBuffer(&cb.called[idx])
 			stats.Merge(s2)
+			// The called buffer may have bound a different buffer
+			// object.
+			bindBuffers()
 
 		default:
 			lg.Errorf("unhandled command")
@@ -6,6 +6,8 @@ package main
 
 import (
 	"fmt"
+	"os"
+	"path"
 	"runtime"
 	"sort"
 	"strings"
@@ -35,6 +37,35 @@ type PaneUIDrawer interface {
 	DrawUI()
 }
 
+// PaneConcurrentDrawer is implemented by Panes whose Draw method may be
+// called on a worker goroutine, concurrently with the Draw methods of
+// other such Panes. PrepareDraw is always called on the main thread just
+// before Draw; it should handle anything that must happen on the main
+// thread (imgui calls, etc.) or that modifies state shared with other
+// Panes. Draw itself must then only read shared state, such as the
+// server's aircraft and the database. Panes that have the mouse or the
+// keyboard focus are always drawn on the main thread.
+type PaneConcurrentDrawer interface {
+	PrepareDraw(ctx *PaneContext)
+}
+
+// PaneDamageTracker is implemented by Panes that can report when what
+// they draw may have changed. If such a Pane isn't dirty, the window
+// manager reuses the CommandBuffer from its last Draw call rather than
+// calling Draw again. (The window manager itself makes sure that Panes
+// are redrawn after user input, when they are resized, and when the color
+// scheme changes.)
+type PaneDamageTracker interface {
+	// Dirty is called before PrepareDraw and Draw; it should return true
+	// if the Pane needs to be redrawn, e.g. because there are pending
+	// events for it in the EventStream.
+	Dirty(ctx *PaneContext) bool
+	// NextRedraw is called after Draw and returns the time at which the
+	// Pane will need to be redrawn even without any other changes, e.g.
+	// to update a clock or for blinking.
+	NextRedraw() time.Time
+}
+
 type PaneContext struct {
 	paneExtent       Extent2D
 	parentPaneExtent Extent2D
@@ -45,6 +76,10 @@ type PaneContext struct {
 	keyboard  *KeyboardState
 	haveFocus bool
 	events    *EventStream
+
+	// Identifies the goroutine the Pane is being drawn on for the
+	// profiler: zero for the main thread, otherwise a worker index.
+	profileTrack int32
 }
 
 type MouseState struct {
@@ -227,6 +262,8 @@ type AirportInfoPane struct {
 	seenDepartures map[string]interface{}
 	seenArrivals   map[string]interface{}
 
+	traffic *AirportTraffic
+
 	FontIdentifier FontIdentifier
 	font           *Font
 
@@ -255,6 +292,7 @@ func (a *AirportInfoPane) Duplicate(nameAsCopy bool) Pane {
 	dupe.lastATIS = DuplicateMap(a.lastATIS)
 	dupe.seenDepartures = DuplicateMap(a.seenDepartures)
 	dupe.seenArrivals = DuplicateMap(a.seenArrivals)
+	dupe.traffic = NewAirportTraffic(dupe.Airports)
 	dupe.sb = NewScrollBar(4, false)
 	dupe.cb = CommandBuffer{}
 	return &dupe
@@ -277,9 +315,17 @@ func (a *AirportInfoPane) Activate() {
 	if a.sb == nil {
 		a.sb = NewScrollBar(4, false)
 	}
+	if a.traffic == nil {
+		a.traffic = NewAirportTraffic(a.Airports)
+	}
 }
 
-func (a *AirportInfoPane) Deactivate() {}
+func (a *AirportInfoPane) Deactivate() {
+	if a.traffic != nil {
+		a.traffic.Dispose()
+		a.traffic = nil
+	}
+}
 
 func (a *AirportInfoPane) Name() string {
 	n := "Airport Information"
@@ -291,6 +337,11 @@ func (a *AirportInfoPane) Name() string {
 
 func (a *AirportInfoPane) DrawUI() {
 	a.Airports = drawAirportSelector(a.Airports, "Airports")
+	// The traffic lists are only maintained while the Pane is active;
+	// Activate creates them using the current airports.
+	if a.traffic != nil {
+		a.traffic.SetAirports(a.Airports)
+	}
 	if newFont, changed := DrawFontPicker(&a.FontIdentifier, "Font"); changed {
 		a.font = newFont
 	}
@@ -310,36 +361,205 @@ type Arrival struct {
 	sortDistance float32
 }
 
+// makeArrival returns the Arrival for an aircraft that is en route to its
+// arrival airport, or false if it is on the ground or its position is not
+// yet known.
+func makeArrival(ac *Aircraft) (Arrival, bool) {
+	if ac.FlightPlan == nil || ac.OnGround() {
+		return Arrival{}, false
+	}
+
+	pos := ac.Position()
+	// Filter ones where we don't have a valid position
+	if pos[0] == 0 || pos[1] == 0 {
+		return Arrival{}, false
+	}
+	ap, _ := database.FAA.LookupAirport(ac.FlightPlan.ArrivalAirport)
+	dist := nmdistance2ll(ap.Location, pos)
+	sortDist := dist + float32(ac.Altitude())/300.
+	return Arrival{aircraft: ac, distance: dist, sortDistance: sortDist}, true
+}
+
+type DepartureStatus int
+
+const (
+	DepartureUncleared DepartureStatus = iota
+	DepartureCleared
+	DepartureAirborne
+)
+
 type Departure struct {
 	*Aircraft
+	status DepartureStatus
+	// Distance from the departure airport; only set for airborne aircraft.
+	distance float32
+}
+
+func makeDeparture(ac *Aircraft) Departure {
+	if !ac.OnGround() {
+		ap, _ := database.FAA.LookupAirport(ac.FlightPlan.DepartureAirport)
+		return Departure{Aircraft: ac, status: DepartureAirborne,
+			distance: nmdistance2ll(ap.Location, ac.Position())}
+	} else if ac.AssignedSquawk == 0 {
+		return Departure{Aircraft: ac, status: DepartureUncleared}
+	} else {
+		return Departure{Aircraft: ac, status: DepartureCleared}
+	}
+}
+
+// Departures are sorted by status and then by callsign, except for
+// airborne ones, which are sorted by distance from the airport.
+func departureLess(a, b Departure) bool {
+	if a.status != b.status {
+		return a.status < b.status
+	} else if a.status == DepartureAirborne {
+		return a.distance < b.distance
+	} else {
+		return a.Callsign < b.Callsign
+	}
+}
+
+func arrivalLess(a, b Arrival) bool {
+	return a.sortDistance < b.sortDistance
 }
 
 func getDistanceSortedArrivals(airports map[string]interface{}) []Arrival {
 	var arr []Arrival
 	now := server.CurrentTime()
 	for _, ac := range server.GetFilteredAircraft(func(ac *Aircraft) bool {
-		if ac.OnGround() || ac.LostTrack(now) || ac.FlightPlan == nil {
+		if ac.LostTrack(now) || ac.FlightPlan == nil {
 			return false
 		}
 		_, ok := airports[ac.FlightPlan.ArrivalAirport]
 		return ok
 	}) {
-		pos := ac.Position()
-		// Filter ones where we don't have a valid position
-		if pos[0] != 0 && pos[1] != 0 {
-			dist := nmdistance2ll(database.FAA.airports[ac.FlightPlan.ArrivalAirport].Location, pos)
-			sortDist := dist + float32(ac.Altitude())/300.
-			arr = append(arr, Arrival{aircraft: ac, distance: dist, sortDistance: sortDist})
+		if a, ok := makeArrival(ac); ok {
+			arr = append(arr, a)
 		}
 	}
 
 	sort.Slice(arr, func(i, j int) bool {
-		return arr[i].sortDistance < arr[j].sortDistance
+		return arrivalLess(arr[i], arr[j])
 	})
 
 	return arr
 }
 
+// AirportTraffic maintains sorted lists of the aircraft arriving at and
+// departing from a set of airports.  Rather than searching through all of
+// the aircraft each time the lists are needed, it updates them using the
+// aircraft events from the EventStream, only recomputing and re-sorting the
+// entries for aircraft that have changed.
+type AirportTraffic struct {
+	airports map[string]interface{}
+	eventsId EventSubscriberId
+
+	// Both are kept sorted, according to arrivalLess and departureLess,
+	// respectively.  Aircraft whose tracks have been lost are included;
+	// callers should filter them out as appropriate.
+	arrivals   []Arrival
+	departures []Departure
+
+	// Aircraft whose entries need to be recomputed; nil values record
+	// aircraft that have been removed.
+	changed map[*Aircraft]*Aircraft
+}
+
+var airportTrafficEventTypes = []EventType{
+	AddedAircraftEventType, ModifiedAircraftEventType, RemovedAircraftEventType,
+}
+
+func NewAirportTraffic(airports map[string]interface{}) *AirportTraffic {
+	t := &AirportTraffic{
+		eventsId: eventStream.Subscribe(airportTrafficEventTypes...),
+		changed:  make(map[*Aircraft]*Aircraft),
+	}
+	t.SetAirports(airports)
+	return t
+}
+
+// Dispose unsubscribes the AirportTraffic from the EventStream; it should
+// not be used subsequently.
+func (t *AirportTraffic) Dispose() {
+	eventStream.Unsubscribe(t.eventsId)
+	t.eventsId = InvalidEventSubscriberId
+}
+
+// SetAirports updates the set of airports that traffic is tracked for,
+// rebuilding the lists if it has changed.
+func (t *AirportTraffic) SetAirports(airports map[string]interface{}) {
+	same := len(airports) == len(t.airports)
+	for ap := range airports {
+		if _, ok := t.airports[ap]; !ok {
+			same = false
+		}
+	}
+	if same && t.airports != nil {
+		return
+	}
+
+	t.airports = DuplicateMap(airports)
+	t.arrivals, t.departures = t.arrivals[:0], t.departures[:0]
+	for _, ac := range server.GetFilteredAircraft(func(*Aircraft) bool { return true }) {
+		t.changed[ac] = ac
+	}
+}
+
+// Update processes any pending aircraft events and brings the lists up
+// to date.
+func (t *AirportTraffic) Update(es *EventStream) {
+	for _, event := range es.Get(t.eventsId) {
+		switch v := event.(type) {
+		case *AddedAircraftEvent:
+			t.changed[v.ac] = v.ac
+		case *ModifiedAircraftEvent:
+			t.changed[v.ac] = v.ac
+		case *RemovedAircraftEvent:
+			t.changed[v.ac] = nil
+		}
+	}
+	if len(t.changed) == 0 {
+		return
+	}
+
+	// Remove the existing entries for all of the changed aircraft. The
+	// remaining ones are still sorted.
+	t.arrivals = FilterSliceInPlace(t.arrivals, func(a Arrival) bool {
+		_, ok := t.changed[a.aircraft]
+		return !ok
+	})
+	t.departures = FilterSliceInPlace(t.departures, func(d Departure) bool {
+		_, ok := t.changed[d.Aircraft]
+		return !ok
+	})
+
+	// Compute new entries for the changed aircraft that are still
+	// around, sort them, and merge them into the existing lists.
+	var arrivals []Arrival
+	var departures []Departure
+	for _, ac := range t.changed {
+		if ac == nil || ac.FlightPlan == nil {
+			continue
+		}
+		if _, ok := t.airports[ac.FlightPlan.DepartureAirport]; ok {
+			departures = append(departures, makeDeparture(ac))
+		}
+		if _, ok := t.airports[ac.FlightPlan.ArrivalAirport]; ok {
+			if a, ok := makeArrival(ac); ok {
+				arrivals = append(arrivals, a)
+			}
+		}
+	}
+	for ac := range t.changed {
+		delete(t.changed, ac)
+	}
+
+	sort.Slice(arrivals, func(i, j int) bool { return arrivalLess(arrivals[i], arrivals[j]) })
+	t.arrivals = MergeSortedSlices(t.arrivals, arrivals, arrivalLess)
+	sort.Slice(departures, func(i, j int) bool { return departureLess(departures[i], departures[j]) })
+	t.departures = MergeSortedSlices(t.departures, departures, departureLess)
+}
+
 func (a *AirportInfoPane) CanTakeKeyboardFocus() bool { return false }
 
 func (a *AirportInfoPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
@@ -432,28 +652,26 @@ func (a *AirportInfoPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 		}
 	}
 
+	// The traffic lists are already sorted; just split the departures up
+	// by status.
+	a.traffic.Update(ctx.events)
 	var uncleared, departures, airborne []Departure
-	for _, ac := range server.GetFilteredAircraft(func(ac *Aircraft) bool {
-		return ac.FlightPlan != nil && !ac.LostTrack(now)
-	}) {
-		if _, ok := a.Airports[ac.FlightPlan.DepartureAirport]; ok {
-			if ac.OnGround() {
-				if ac.AssignedSquawk == 0 {
-					uncleared = append(uncleared, Departure{Aircraft: ac})
-				} else {
-					departures = append(departures, Departure{Aircraft: ac})
-				}
-			} else {
-				airborne = append(airborne, Departure{Aircraft: ac})
-			}
+	for _, dep := range a.traffic.departures {
+		if dep.LostTrack(now) {
+			continue
+		}
+		switch dep.status {
+		case DepartureUncleared:
+			uncleared = append(uncleared, dep)
+		case DepartureCleared:
+			departures = append(departures, dep)
+		case DepartureAirborne:
+			airborne = append(airborne, dep)
 		}
 	}
 
 	if a.ShowUncleared && len(uncleared) > 0 {
 		str.WriteString("Uncleared:\n")
-		sort.Slice(uncleared, func(i, j int) bool {
-			return uncleared[i].Callsign < uncleared[j].Callsign
-		})
 		for _, ac := range uncleared {
 			str.WriteString(fmt.Sprintf("  %-8s %3s %4s-%4s %8s %5d\n", ac.Callsign,
 				ac.FlightPlan.Rules, ac.FlightPlan.DepartureAirport, ac.FlightPlan.ArrivalAirport,
@@ -476,9 +694,6 @@ func (a *AirportInfoPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 
 	if a.ShowDepartures && len(departures) > 0 {
 		str.WriteString("Departures:\n")
-		sort.Slice(departures, func(i, j int) bool {
-			return departures[i].Callsign < departures[j].Callsign
-		})
 		for _, ac := range departures {
 			route := ac.FlightPlan.Route
 			if len(route) > 10 {
@@ -505,14 +720,6 @@ func (a *AirportInfoPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 	}
 
 	if a.ShowDeparted && len(airborne) > 0 {
-		sort.Slice(airborne, func(i, j int) bool {
-			ai := &airborne[i]
-			di := nmdistance2ll(database.FAA.airports[ai.FlightPlan.DepartureAirport].Location, ai.Position())
-			aj := &airborne[j]
-			dj := nmdistance2ll(database.FAA.airports[aj.FlightPlan.DepartureAirport].Location, aj.Position())
-			return di < dj
-		})
-
 		str.WriteString("Departed:\n")
 		for _, ac := range airborne {
 			route := ac.FlightPlan.Route
@@ -536,7 +743,7 @@ func (a *AirportInfoPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 		str.WriteString("\n")
 	}
 
-	arrivals := getDistanceSortedArrivals(a.Airports)
+	arrivals := FilterSlice(a.traffic.arrivals, func(arr Arrival) bool { return !arr.aircraft.LostTrack(now) })
 	if a.ShowArrivals && len(arrivals) > 0 {
 		str.WriteString("Arrivals:\n")
 		for _, arr := range arrivals {
@@ -855,7 +1062,12 @@ func (nv *NotesViewPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 // PerformancePane
 
 type PerformancePane struct {
-	disableVSync bool
+	disableVSync          bool
+	disableDrawBatching   bool
+	disableConcurrentDraw bool
+	redrawContinuously    bool
+	showProfile           bool
+	traceStatus           string
 
 	nFrames        uint64
 	initialMallocs uint64
@@ -916,6 +1128,49 @@ func (pp *PerformancePane) DrawUI() {
 	if imgui.Checkbox("Disable vsync", &pp.disableVSync) {
 		platform.EnableVSync(!pp.disableVSync)
 	}
+	if imgui.Checkbox("Disable draw batching", &pp.disableDrawBatching) {
+		wm.disableDrawBatching = pp.disableDrawBatching
+	}
+	if imgui.Checkbox("Disable concurrent pane drawing", &pp.disableConcurrentDraw) {
+		wm.disableConcurrentDraw = pp.disableConcurrentDraw
+	}
+	if imgui.Checkbox("Redraw continuously", &pp.redrawContinuously) {
+		wm.redrawContinuously = pp.redrawContinuously
+	}
+	imgui.Checkbox("Show slowest recent frame", &pp.showProfile)
+	if imgui.Button("Export Chrome trace") {
+		pp.traceStatus = pp.exportTrace()
+	}
+	if pp.traceStatus != "" {
+		imgui.SameLine()
+		imgui.Text(pp.traceStatus)
+	}
+}
+
+// exportTrace writes the profiler's recent frames to a file in the user's
+// config directory that can be loaded into chrome://tracing or Perfetto
+// and returns a message describing the result.
+func (pp *PerformancePane) exportTrace() string {
+	dir, err := os.UserConfigDir()
+	if err != nil {
+		lg.Errorf("Unable to find user config dir: %v", err)
+		dir = "."
+	}
+	fn := path.Join(dir, "Vice", "vice-trace-"+time.Now().Format("20060102-150405")+".json")
+
+	f, err := os.Create(fn)
+	if err != nil {
+		lg.Errorf("%s: %v", fn, err)
+		return err.Error()
+	}
+	defer f.Close()
+
+	if err := profiler.WriteChromeTrace(f); err != nil {
+		lg.Errorf("%s: %v", fn, err)
+		return err.Error()
+	}
+	lg.Printf("%s: wrote Chrome trace", fn)
+	return "Wrote " + fn
 }
 
 func (pp *PerformancePane) Draw(ctx *PaneContext, cb *CommandBuffer) {
@@ -968,13 +1223,83 @@ func (pp *PerformancePane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 	// Rendering stats
 	perf.WriteString("\n" + stats.render.String())
 
+	if stats.vatsimSend != (VATSIMSendStats{}) {
+		perf.WriteString("\nVATSIM send " + stats.vatsimSend.String())
+	}
+
 	td := GetTextDrawBuilder()
 	defer ReturnTextDrawBuilder(td)
 	sz2 := float32(pp.font.size) / 2
-	td.AddText(perf.String(), [2]float32{sz2, ctx.paneExtent.Height() - sz2},
+	textEnd := td.AddText(perf.String(), [2]float32{sz2, ctx.paneExtent.Height() - sz2},
 		TextStyle{Font: pp.font, Color: ctx.cs.Text})
 
 	ctx.SetWindowCoordinateMatrices(cb)
+	if pp.showProfile {
+		if frame, ok := profiler.SlowestFrame(); ok {
+			pp.drawProfile(frame, textEnd[1]-float32(pp.font.size)-sz2, ctx, cb)
+		}
+	}
+	td.GenerateCommands(cb)
+}
+
+// drawProfile draws a flame graph of the given frame starting at the
+// vertical position y: there is a row of bars for each nesting level of
+// each of the profiler's tracks, with time increasing to the right.
+func (pp *PerformancePane) drawProfile(frame ProfileFrame, y float32, ctx *PaneContext, cb *CommandBuffer) {
+	trid := GetColoredTrianglesDrawBuilder()
+	defer ReturnColoredTrianglesDrawBuilder(trid)
+	td := GetTextDrawBuilder()
+	defer ReturnTextDrawBuilder(td)
+
+	sz2 := float32(pp.font.size) / 2
+	rowHeight := float32(pp.font.size) + 4
+	x0, width := sz2, ctx.paneExtent.Width()-2*sz2
+	style := TextStyle{Font: pp.font, Color: ctx.cs.Text}
+
+	label := fmt.Sprintf("Slowest recent frame: %.2fms", float32(frame.Duration().Microseconds())/1000)
+	if frame.Dropped > 0 {
+		label += fmt.Sprintf(" (%d events dropped)", frame.Dropped)
+	}
+	td.AddText(label, [2]float32{x0, y}, style)
+	y -= rowHeight
+
+	// Bar colors are chosen by category so that, e.g., all of the Pane
+	// draws are the same color.
+	palette := []RGB{{0.85, 0.45, 0.35}, {0.9, 0.7, 0.3}, {0.5, 0.75, 0.4},
+		{0.4, 0.6, 0.85}, {0.7, 0.5, 0.8}, {0.45, 0.75, 0.75}}
+	categoryColor := func(category string) RGB {
+		h := 0
+		for _, ch := range category {
+			h = 31*h + int(ch)
+		}
+		return palette[(h%len(palette)+len(palette))%len(palette)]
+	}
+
+	scale := width / float32(max(frame.Duration(), 1))
+	depths := frame.Depths()
+	track, rowBase, rows := int32(-1), y, 0
+	for i, e := range frame.Events {
+		if e.Track != track {
+			// Start a new set of rows below the ones for the previous track.
+			track, rowBase, rows = e.Track, rowBase-float32(rows)*rowHeight, 0
+		}
+		rows = max(rows, depths[i]+1)
+
+		px0 := x0 + scale*float32(e.Start-frame.Start)
+		px1 := max(x0+scale*float32(e.End-frame.Start), px0+1)
+		py1 := rowBase - float32(depths[i])*rowHeight
+		py0 := py1 - rowHeight + 1
+		trid.AddQuad([2]float32{px0, py0}, [2]float32{px1, py0}, [2]float32{px1, py1},
+			[2]float32{px0, py1}, categoryColor(e.Category))
+
+		// Only label the bar if the text fits.
+		text := fmt.Sprintf("%s %.2fms", e.Name, float32(e.Duration().Microseconds())/1000)
+		if bx, _ := pp.font.BoundText(text, 0); float32(bx)+4 < px1-px0 {
+			td.AddText(text, [2]float32{px0 + 2, py1 - 2}, TextStyle{Font: pp.font, Color: ctx.cs.Background})
+		}
+	}
+
+	trid.GenerateCommands(cb)
 	td.GenerateCommands(cb)
 }
 
@@ -1180,6 +1505,8 @@ type FlightStripPane struct {
 
 	eventsId  EventSubscriberId
 	scrollbar *ScrollBar
+
+	stripCache map[string]*cachedFlightStrip
 }
 
 func NewFlightStripPane() *FlightStripPane {
@@ -1205,8 +1532,9 @@ func (fsp *FlightStripPane) Duplicate(nameAsCopy bool) Pane {
 		addedAircraft:             DuplicateMap(fsp.addedAircraft),
 		selectedStrip:             -1,
 		selectedAnnotation:        -1,
-		eventsId:                  eventStream.Subscribe(),
+		eventsId:                  eventStream.Subscribe(flightStripEventTypes...),
 		scrollbar:                 NewScrollBar(4, true),
+		stripCache:                make(map[string]*cachedFlightStrip),
 	}
 }
 
@@ -1221,7 +1549,10 @@ func (fsp *FlightStripPane) Activate() {
 	if fsp.scrollbar == nil {
 		fsp.scrollbar = NewScrollBar(4, true)
 	}
-	fsp.eventsId = eventStream.Subscribe()
+	if fsp.stripCache == nil {
+		fsp.stripCache = make(map[string]*cachedFlightStrip)
+	}
+	fsp.eventsId = eventStream.Subscribe(flightStripEventTypes...)
 }
 
 func (fsp *FlightStripPane) Deactivate() {
@@ -1247,6 +1578,11 @@ func (fsp *FlightStripPane) isArrival(ac *Aircraft) bool {
 
 func (fsp *FlightStripPane) CanTakeKeyboardFocus() bool { return true }
 
+// flightStripEventTypes lists the events that the FlightStripPane handles
+// in processEvents.
+var flightStripEventTypes = []EventType{PushedFlightStripEventType, AddedAircraftEventType,
+	ModifiedAircraftEventType, RemovedAircraftEventType}
+
 func (fsp *FlightStripPane) processEvents(es *EventStream) {
 	possiblyAdd := func(ac *Aircraft) {
 		callsign := ac.Callsign
@@ -1266,20 +1602,40 @@ func (fsp *FlightStripPane) processEvents(es *EventStream) {
 		}
 	}
 
+	invalidate := func(callsign string) {
+		if cache, ok := fsp.stripCache[callsign]; ok {
+			cache.valid = false
+		}
+	}
+
 	for _, event := range es.Get(fsp.eventsId) {
 		switch v := event.(type) {
 		case *PushedFlightStripEvent:
+			invalidate(v.callsign)
 			if Find(fsp.strips, v.callsign) == -1 {
 				fsp.strips = append(fsp.strips, v.callsign)
 			}
 		case *AddedAircraftEvent:
 			possiblyAdd(v.ac)
 		case *ModifiedAircraftEvent:
-			possiblyAdd(v.ac)
+			// Flight strips don't show anything that depends on the
+			// aircraft's position.  (They do show its assigned squawk,
+			// temporary altitude, and scratchpad as well as its flight
+			// plan, so other changes require redrawing its strip.)
+			if v.Changed(^AircraftTrackChanged) {
+				invalidate(v.ac.Callsign)
+			}
+
+			// Whether it's a departure or arrival only depends on where it
+			// is and its flight plan.
+			if v.Changed(AircraftTrackChanged | AircraftFlightPlanChanged) {
+				possiblyAdd(v.ac)
+			}
 		case *RemovedAircraftEvent:
 			// Thus, if we later see the same callsign from someone else, we'll
 			// treat them as new.
 			delete(fsp.addedAircraft, v.ac.Callsign)
+			delete(fsp.stripCache, v.ac.Callsign)
 			fsp.strips = FilterSlice(fsp.strips, func(callsign string) bool { return callsign != v.ac.Callsign })
 		}
 	}
@@ -1321,6 +1677,34 @@ func (fsp *FlightStripPane) DrawUI() {
 	}
 }
 
+// cachedFlightStrip stores the rendered geometry for a single flight
+// strip, drawn as if it were at the bottom of the pane, along with
+// everything that determines its appearance other than the contents of
+// its Aircraft and FlightStrip, changes to which are tracked via events.
+// The background is kept separate so that the backgrounds of all of the
+// strips can be drawn before the lines and text of any of them.
+type cachedFlightStrip struct {
+	background, foreground CommandBuffer
+	key                    flightStripCacheKey
+	valid                  bool
+}
+
+type flightStripCacheKey struct {
+	ac                               *Aircraft
+	strip                            *FlightStrip
+	font                             *Font
+	fontGeneration                   int
+	drawWidth, widthCenter           float32
+	textColor, bgColor, controlColor RGB
+}
+
+// flightStripLayout records the sizes of the parts of a flight strip.
+type flightStripLayout struct {
+	fw, fh, vpad, stripHeight, indent float32
+	width0, width1, width2, widthAnn  float32
+	widthCenter, drawWidth            float32
+}
+
 func (fsp *FlightStripPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 	fsp.processEvents(ctx.events)
 
@@ -1337,26 +1721,33 @@ func (fsp *FlightStripPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 	visibleStrips := int(ctx.paneExtent.Height() / stripHeight)
 	fsp.scrollbar.Update(len(fsp.strips), visibleStrips, ctx)
 
-	indent := float32(int32(fw / 2))
-	// column widths
-	width0 := 10 * fw
-	width1 := 6 * fw
-	width2 := 5 * fw
-	widthAnn := 5 * fw
+	l := flightStripLayout{
+		fw:          fw,
+		fh:          fh,
+		vpad:        vpad,
+		stripHeight: stripHeight,
+		indent:      float32(int32(fw / 2)),
+		// column widths
+		width0:   10 * fw,
+		width1:   6 * fw,
+		width2:   5 * fw,
+		widthAnn: 5 * fw,
+	}
 
-	widthCenter := ctx.paneExtent.Width() - width0 - width1 - width2 - 3*widthAnn
+	l.widthCenter = ctx.paneExtent.Width() - l.width0 - l.width1 - l.width2 - 3*l.widthAnn
 	if fsp.scrollbar.Visible() {
-		widthCenter -= float32(fsp.scrollbar.Width())
+		l.widthCenter -= float32(fsp.scrollbar.Width())
 	}
-	if widthCenter < 0 {
+	if l.widthCenter < 0 {
 		// not sure what to do if it comes to this...
-		widthCenter = 20 * fw
+		l.widthCenter = 20 * fw
 	}
 
-	drawWidth := ctx.paneExtent.Width()
+	l.drawWidth = ctx.paneExtent.Width()
 	if fsp.scrollbar.Visible() {
-		drawWidth -= float32(fsp.scrollbar.Width())
+		l.drawWidth -= float32(fsp.scrollbar.Width())
 	}
+	drawWidth, widthAnn := l.drawWidth, l.widthAnn
 
 	// This can happen if, for example, the last aircraft is selected and
 	// then another one is removed. It might be better if selectedAircraft
@@ -1368,16 +1759,23 @@ func (fsp *FlightStripPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 		fsp.selectedStrip = len(fsp.strips) - 1
 	}
 
-	td := GetTextDrawBuilder()
-	defer ReturnTextDrawBuilder(td)
-	ld := GetLinesDrawBuilder()
-	defer ReturnLinesDrawBuilder(ld)
 	selectionLd := GetLinesDrawBuilder()
 	defer ReturnLinesDrawBuilder(selectionLd)
 
-	// Draw from the bottom
+	if len(fsp.stripCache) > len(fsp.strips) {
+		// Discard the geometry for strips that have been deleted.
+		for callsign := range fsp.stripCache {
+			if Find(fsp.strips, callsign) == -1 {
+				delete(fsp.stripCache, callsign)
+			}
+		}
+	}
+
+	// Bring the geometry for the visible strips up to date; only strips
+	// that have changed are rendered again.
 	scrollOffset := fsp.scrollbar.Offset()
-	y := stripHeight - 1 - vpad
+	var visible []*cachedFlightStrip
+	var editResult int
 	for i := scrollOffset; i < min(len(fsp.strips), visibleStrips+scrollOffset+1); i++ {
 		callsign := fsp.strips[i]
 		strip := server.GetFlightStrip(callsign)
@@ -1386,145 +1784,74 @@ func (fsp *FlightStripPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 			lg.Errorf("%s: no aircraft for callsign?!", strip.callsign)
 			continue
 		}
-		fp := ac.FlightPlan
 
-		style := TextStyle{Font: fsp.font, Color: ctx.cs.Text}
+		key := flightStripCacheKey{ac: ac, strip: strip, font: fsp.font, fontGeneration: fontAtlas.generation,
+			drawWidth: l.drawWidth, widthCenter: l.widthCenter, textColor: ctx.cs.Text,
+			controlColor: ctx.cs.UIControl}
 		if positionConfig.selectedAircraft != nil && positionConfig.selectedAircraft.Callsign == callsign {
-			style.Color = ctx.cs.TextHighlight
-		}
-
-		// Draw background quad for this flight strip
-		qb := GetColoredTrianglesDrawBuilder()
-		defer ReturnColoredTrianglesDrawBuilder(qb)
-		bgColor := func() RGB {
-			if fsp.isDeparture(ac) {
-				return ctx.cs.DepartureStrip
-			} else {
-				return ctx.cs.ArrivalStrip
-			}
-		}()
-		y0, y1 := y+1+vpad-stripHeight, y+1+vpad
-		qb.AddQuad([2]float32{0, y0}, [2]float32{drawWidth, y0}, [2]float32{drawWidth, y1}, [2]float32{0, y1}, bgColor)
-		qb.GenerateCommands(cb)
-
-		x := indent
-
-		// First column; 3 entries
-		td.AddText(callsign, [2]float32{x, y}, style)
-		if fp != nil {
-			td.AddText(fp.AircraftType, [2]float32{x, y - fh*3/2}, style)
-			td.AddText(fp.Rules.String(), [2]float32{x, y - fh*3}, style)
+			key.textColor = ctx.cs.TextHighlight
 		}
-		ld.AddLine([2]float32{width0, y}, [2]float32{width0, y - stripHeight})
-
-		// Second column; 3 entries
-		x += width0
-		td.AddText(ac.AssignedSquawk.String(), [2]float32{x, y}, style)
-		td.AddText(fmt.Sprintf("%d", ac.TempAltitude), [2]float32{x, y - fh*3/2}, style)
-		if fp != nil {
-			td.AddText(fmt.Sprintf("%d", fp.Altitude), [2]float32{x, y - fh*3}, style)
-		}
-		ld.AddLine([2]float32{width0, y - 4./3.*fh}, [2]float32{width0 + width1, y - 4./3.*fh})
-		ld.AddLine([2]float32{width0, y - 8./3.*fh}, [2]float32{width0 + width1, y - 8./3.*fh})
-		ld.AddLine([2]float32{width0 + width1, y}, [2]float32{width0 + width1, y - stripHeight})
-
-		// Third column; (up to) 4 entries
-		x += width1
-		if fp != nil {
-			td.AddText(fp.DepartureAirport, [2]float32{x, y}, style)
-			td.AddText(fp.ArrivalAirport, [2]float32{x, y - fh}, style)
-			td.AddText(fp.AlternateAirport, [2]float32{x, y - 2*fh}, style)
-		}
-		td.AddText(ac.Scratchpad, [2]float32{x, y - 3*fh}, style)
-		ld.AddLine([2]float32{width0 + width1 + width2, y},
-			[2]float32{width0 + width1 + width2, y - stripHeight})
-
-		// Fourth column: route and remarks
-		x += width2
-		if fp != nil {
-			cols := int(widthCenter / fw)
-			// Line-wrap the route to fit the box and break it into lines.
-			route, _ := wrapText(fp.Route, cols, 2 /* indent */, true)
-			text := strings.Split(route, "\n")
-			// Add a blank line if the route only used one line.
-			if len(text) < 2 {
-				text = append(text, "")
-			}
-			// Similarly for the remarks
-			remarks, _ := wrapText(fp.Remarks, cols, 2 /* indent */, true)
-			text = append(text, strings.Split(remarks, "\n")...)
-			// Limit to the first four lines so we don't spill over.
-			if len(text) > 4 {
-				text = text[:4]
-			}
-			// Truncate all lines to the column limit; wrapText() lets things
-			// spill over if it's unable to break a long word by itself on a
-			// line, for example.
-			for i, line := range text {
-				if len(line) > cols {
-					text[i] = text[i][:cols]
-				}
-			}
-			td.AddText(strings.Join(text, "\n"), [2]float32{x, y}, style)
+		if fsp.isDeparture(ac) {
+			key.bgColor = ctx.cs.DepartureStrip
+		} else {
+			key.bgColor = ctx.cs.ArrivalStrip
 		}
 
-		// Annotations
-		x += widthCenter
-		var editResult int
-		for ai, ann := range strip.annotations {
-			ix, iy := ai%3, ai/3
-			xp, yp := x+float32(ix)*widthAnn+indent, y-float32(iy)*1.5*fh
-
-			if ctx.haveFocus && fsp.selectedStrip == i && ai == fsp.selectedAnnotation {
-				// If were currently editing this annotation, don't draw it
-				// normally but instead draw it including a cursor, update
-				// it according to keyboard input, etc.
-				cursorStyle := TextStyle{Font: fsp.font, Color: bgColor,
-					DrawBackground: true, BackgroundColor: style.Color}
-				editResult, _ = uiDrawTextEdit(&strip.annotations[fsp.selectedAnnotation], &fsp.annotationCursorPos,
-					ctx.keyboard, [2]float32{xp, yp}, style, cursorStyle, cb)
-				if len(strip.annotations[fsp.selectedAnnotation]) >= 3 {
-					// Limit it to three characters
-					strip.annotations[fsp.selectedAnnotation] = strip.annotations[fsp.selectedAnnotation][:3]
-					fsp.annotationCursorPos = min(fsp.annotationCursorPos, len(strip.annotations[fsp.selectedAnnotation]))
-				}
-			} else {
-				td.AddText(ann, [2]float32{xp, yp}, style)
-			}
+		cache, ok := fsp.stripCache[callsign]
+		if !ok {
+			cache = &cachedFlightStrip{}
+			fsp.stripCache[callsign] = cache
 		}
+		visible = append(visible, cache)
 
-		// Only process this after drawing all of the annotations since
-		// otherwise we can end up with cascading tabbing ahead and the
-		// like.
-		switch editResult {
-		case TextEditReturnNone, TextEditReturnTextChanged:
-			// nothing to do
-		case TextEditReturnEnter:
-			fsp.selectedStrip = -1
-			wmReleaseKeyboardFocus()
-		case TextEditReturnNext:
-			fsp.selectedAnnotation = (fsp.selectedAnnotation + 1) % 9
-			fsp.annotationCursorPos = len(strip.annotations[fsp.selectedAnnotation])
-		case TextEditReturnPrev:
-			// +8 rather than -1 to keep it positive for the mod...
-			fsp.selectedAnnotation = (fsp.selectedAnnotation + 8) % 9
-			fsp.annotationCursorPos = len(strip.annotations[fsp.selectedAnnotation])
+		// The strip whose annotation is being edited is drawn from
+		// scratch each time, since it depends on the keyboard input.
+		editing := ctx.haveFocus && fsp.selectedStrip == i
+		if cache.valid && cache.key == key && !editing {
+			continue
 		}
 
-		// Horizontal lines
-		ld.AddLine([2]float32{x, y - 4./3.*fh}, [2]float32{drawWidth, y - 4./3.*fh})
-		ld.AddLine([2]float32{x, y - 8./3.*fh}, [2]float32{drawWidth, y - 8./3.*fh})
-		// Vertical lines
-		for i := 0; i < 3; i++ {
-			xp := x + float32(i)*widthAnn
-			ld.AddLine([2]float32{xp, y}, [2]float32{xp, y - stripHeight})
+		cache.background.Reset()
+		cache.foreground.Reset()
+		cache.key = key
+		if r := fsp.drawStrip(ctx, ac, strip, key, l, editing, cache); editing {
+			editResult = r
+			// Make sure it's redrawn once editing is finished.
+			cache.valid = false
+		} else {
+			cache.background.MarkStatic()
+			cache.foreground.MarkStatic()
+			cache.valid = true
 		}
+	}
 
-		// Line at the top
-		yl := y + 1 + vpad
-		ld.AddLine([2]float32{0, yl}, [2]float32{drawWidth, yl})
+	// Draw the backgrounds from the bottom, positioning each strip's
+	// geometry appropriately; the text and lines go on top of the
+	// scrollbar, below.
+	for i, cache := range visible {
+		cb.LoadModelViewMatrix(mgl32.Translate3D(0, float32(i)*stripHeight, 0))
+		cb.Call(cache.background)
+	}
+	cb.LoadModelViewMatrix(mgl32.Ident4())
 
-		y += stripHeight
+	// Only process this after drawing all of the annotations since
+	// otherwise we can end up with cascading tabbing ahead and the
+	// like.
+	switch editResult {
+	case TextEditReturnNone, TextEditReturnTextChanged:
+		// nothing to do
+	case TextEditReturnEnter:
+		fsp.selectedStrip = -1
+		wmReleaseKeyboardFocus()
+	case TextEditReturnNext:
+		strip := server.GetFlightStrip(fsp.strips[fsp.selectedStrip])
+		fsp.selectedAnnotation = (fsp.selectedAnnotation + 1) % 9
+		fsp.annotationCursorPos = len(strip.annotations[fsp.selectedAnnotation])
+	case TextEditReturnPrev:
+		strip := server.GetFlightStrip(fsp.strips[fsp.selectedStrip])
+		// +8 rather than -1 to keep it positive for the mod...
+		fsp.selectedAnnotation = (fsp.selectedAnnotation + 8) % 9
+		fsp.annotationCursorPos = len(strip.annotations[fsp.selectedAnnotation])
 	}
 
 	// Handle selection, deletion, and reordering
@@ -1623,12 +1950,144 @@ func (fsp *FlightStripPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 	}
 	fsp.scrollbar.Draw(ctx, cb)
 
-	cb.SetRGB(ctx.cs.UIControl)
-	cb.LineWidth(1)
-	ld.GenerateCommands(cb)
-	td.GenerateCommands(cb)
+	for i, cache := range visible {
+		cb.LoadModelViewMatrix(mgl32.Translate3D(0, float32(i)*stripHeight, 0))
+		cb.Call(cache.foreground)
+	}
+	cb.LoadModelViewMatrix(mgl32.Ident4())
 
 	cb.SetRGB(ctx.cs.TextHighlight)
 	cb.LineWidth(3)
 	selectionLd.GenerateCommands(cb)
 }
+
+// drawStrip renders the given flight strip into the cachedFlightStrip's
+// CommandBuffers as if it were the bottom strip in the pane.  If the
+// strip's selected annotation is being edited, it returns the result from
+// uiDrawTextEdit.
+func (fsp *FlightStripPane) drawStrip(ctx *PaneContext, ac *Aircraft, strip *FlightStrip,
+	key flightStripCacheKey, l flightStripLayout, editing bool, cache *cachedFlightStrip) int {
+	td := GetTextDrawBuilder()
+	defer ReturnTextDrawBuilder(td)
+	ld := GetLinesDrawBuilder()
+	defer ReturnLinesDrawBuilder(ld)
+	qb := GetColoredTrianglesDrawBuilder()
+	defer ReturnColoredTrianglesDrawBuilder(qb)
+
+	fw, fh, stripHeight, drawWidth := l.fw, l.fh, l.stripHeight, l.drawWidth
+	width0, width1, width2, widthAnn := l.width0, l.width1, l.width2, l.widthAnn
+	fp := ac.FlightPlan
+	style := TextStyle{Font: fsp.font, Color: key.textColor}
+	y := stripHeight - 1 - l.vpad
+
+	// Draw background quad for this flight strip
+	y0, y1 := y+1+l.vpad-stripHeight, y+1+l.vpad
+	qb.AddQuad([2]float32{0, y0}, [2]float32{drawWidth, y0}, [2]float32{drawWidth, y1}, [2]float32{0, y1}, key.bgColor)
+	qb.GenerateCommands(&cache.background)
+
+	x := l.indent
+
+	// First column; 3 entries
+	td.AddText(ac.Callsign, [2]float32{x, y}, style)
+	if fp != nil {
+		td.AddText(fp.AircraftType, [2]float32{x, y - fh*3/2}, style)
+		td.AddText(fp.Rules.String(), [2]float32{x, y - fh*3}, style)
+	}
+	ld.AddLine([2]float32{width0, y}, [2]float32{width0, y - stripHeight})
+
+	// Second column; 3 entries
+	x += width0
+	td.AddText(ac.AssignedSquawk.String(), [2]float32{x, y}, style)
+	td.AddText(fmt.Sprintf("%d", ac.TempAltitude), [2]float32{x, y - fh*3/2}, style)
+	if fp != nil {
+		td.AddText(fmt.Sprintf("%d", fp.Altitude), [2]float32{x, y - fh*3}, style)
+	}
+	ld.AddLine([2]float32{width0, y - 4./3.*fh}, [2]float32{width0 + width1, y - 4./3.*fh})
+	ld.AddLine([2]float32{width0, y - 8./3.*fh}, [2]float32{width0 + width1, y - 8./3.*fh})
+	ld.AddLine([2]float32{width0 + width1, y}, [2]float32{width0 + width1, y - stripHeight})
+
+	// Third column; (up to) 4 entries
+	x += width1
+	if fp != nil {
+		td.AddText(fp.DepartureAirport, [2]float32{x, y}, style)
+		td.AddText(fp.ArrivalAirport, [2]float32{x, y - fh}, style)
+		td.AddText(fp.AlternateAirport, [2]float32{x, y - 2*fh}, style)
+	}
+	td.AddText(ac.Scratchpad, [2]float32{x, y - 3*fh}, style)
+	ld.AddLine([2]float32{width0 + width1 + width2, y},
+		[2]float32{width0 + width1 + width2, y - stripHeight})
+
+	// Fourth column: route and remarks
+	x += width2
+	if fp != nil {
+		cols := int(l.widthCenter / fw)
+		// Line-wrap the route to fit the box and break it into lines.
+		route, _ := wrapText(fp.Route, cols, 2 /* indent */, true)
+		text := strings.Split(route, "\n")
+		// Add a blank line if the route only used one line.
+		if len(text) < 2 {
+			text = append(text, "")
+		}
+		// Similarly for the remarks
+		remarks, _ := wrapText(fp.Remarks, cols, 2 /* indent */, true)
+		text = append(text, strings.Split(remarks, "\n")...)
+		// Limit to the first four lines so we don't spill over.
+		if len(text) > 4 {
+			text = text[:4]
+		}
+		// Truncate all lines to the column limit; wrapText() lets things
+		// spill over if it's unable to break a long word by itself on a
+		// line, for example.
+		for i, line := range text {
+			if len(line) > cols {
+				text[i] = text[i][:cols]
+			}
+		}
+		td.AddText(strings.Join(text, "\n"), [2]float32{x, y}, style)
+	}
+
+	// Annotations
+	x += l.widthCenter
+	var editResult int
+	for ai, ann := range strip.annotations {
+		ix, iy := ai%3, ai/3
+		xp, yp := x+float32(ix)*widthAnn+l.indent, y-float32(iy)*1.5*fh
+
+		if editing && ai == fsp.selectedAnnotation {
+			// If were currently editing this annotation, don't draw it
+			// normally but instead draw it including a cursor, update
+			// it according to keyboard input, etc.
+			cursorStyle := TextStyle{Font: fsp.font, Color: key.bgColor,
+				DrawBackground: true, BackgroundColor: style.Color}
+			editResult, _ = uiDrawTextEdit(&strip.annotations[fsp.selectedAnnotation], &fsp.annotationCursorPos,
+				ctx.keyboard, [2]float32{xp, yp}, style, cursorStyle, &cache.foreground)
+			if len(strip.annotations[fsp.selectedAnnotation]) >= 3 {
+				// Limit it to three characters
+				strip.annotations[fsp.selectedAnnotation] = strip.annotations[fsp.selectedAnnotation][:3]
+				fsp.annotationCursorPos = min(fsp.annotationCursorPos, len(strip.annotations[fsp.selectedAnnotation]))
+			}
+		} else {
+			td.AddText(ann, [2]float32{xp, yp}, style)
+		}
+	}
+
+	// Horizontal lines
+	ld.AddLine([2]float32{x, y - 4./3.*fh}, [2]float32{drawWidth, y - 4./3.*fh})
+	ld.AddLine([2]float32{x, y - 8./3.*fh}, [2]float32{drawWidth, y - 8./3.*fh})
+	// Vertical lines
+	for i := 0; i < 3; i++ {
+		xp := x + float32(i)*widthAnn
+		ld.AddLine([2]float32{xp, y}, [2]float32{xp, y - stripHeight})
+	}
+
+	// Line at the top
+	yl := y + 1 + l.vpad
+	ld.AddLine([2]float32{0, yl}, [2]float32{drawWidth, yl})
+
+	cache.foreground.SetRGB(key.controlColor)
+	cache.foreground.LineWidth(1)
+	ld.GenerateCommands(&cache.foreground)
+	td.GenerateCommands(&cache.foreground)
+
+	return editResult
+}
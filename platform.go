@@ -10,6 +10,7 @@ package main
 import (
 	"fmt"
 	"math"
+	"time"
 
 	"github.com/go-gl/gl/v2.1/gl"
 	"github.com/go-gl/glfw/v3.2/glfw"
@@ -25,6 +26,12 @@ type Platform interface {
 	// ProcessEvents handles all pending window events. Returns true if
 	// there were any events and false otherwise.
 	ProcessEvents() bool
+	// WaitEvents is like ProcessEvents, but first waits until there is
+	// at least one event or the given amount of time has passed.
+	WaitEvents(timeout time.Duration) bool
+	// PostEmptyEvent causes a pending call to WaitEvents to return
+	// immediately; it may be called from any goroutine.
+	PostEmptyEvent()
 	// PostRender performs the buffer swap.
 	PostRender()
 	// Dispose is called when the application is shutting down and is when
@@ -69,6 +76,15 @@ func dpiScale(p Platform) float32 {
 	return p.FramebufferSize()[0] / p.DisplaySize()[0]
 }
 
+// wakeMainLoop causes the main loop to stop waiting for events, if it is
+// currently doing so, so that new data from the network or other
+// goroutines is handled promptly.  It may be called from any goroutine.
+func wakeMainLoop() {
+	if platform != nil {
+		platform.PostEmptyEvent()
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////
 
 // GLFWPlatform implements the Platform interface using GLFW.
@@ -87,6 +103,11 @@ type GLFWPlatform struct {
 	multisample            bool
 	windowTitle            string
 	mouseCapture           Extent2D
+
+	// The display and framebuffer sizes are queried from GLFW on the main
+	// thread and cached so that DisplaySize and FramebufferSize can also
+	// be called from Panes that are drawn concurrently.
+	displaySize, framebufferSize [2]float32
 }
 
 // NewGLFWPlatform returns a new instance of a GLFWPlatform with a window
@@ -131,6 +152,7 @@ func NewGLFWPlatform(io imgui.IO, windowSize [2]int, windowPosition [2]int, mult
 		window:      window,
 		multisample: multisample,
 	}
+	platform.updateSizes()
 	platform.setKeyMapping()
 	platform.installCallbacks()
 	platform.createMouseCursors()
@@ -171,10 +193,25 @@ func (g *GLFWPlatform) CancelShouldStop() {
 }
 
 func (g *GLFWPlatform) ProcessEvents() bool {
+	return g.processEvents(glfw.PollEvents)
+}
+
+func (g *GLFWPlatform) WaitEvents(timeout time.Duration) bool {
+	return g.processEvents(func() { glfw.WaitEventsTimeout(timeout.Seconds()) })
+}
+
+func (g *GLFWPlatform) PostEmptyEvent() {
+	glfw.PostEmptyEvent()
+}
+
+// processEvents calls the provided function to have GLFW process pending
+// events and then reports whether there was any user input.
+func (g *GLFWPlatform) processEvents(poll func()) bool {
 	g.inputCharacters = ""
 	g.anyEvents = false
 
-	glfw.PollEvents()
+	poll()
+	g.updateSizes()
 
 	if g.anyEvents {
 		return true
@@ -196,8 +233,7 @@ func (g *GLFWPlatform) ProcessEvents() bool {
 }
 
 func (g *GLFWPlatform) DisplaySize() [2]float32 {
-	w, h := g.window.GetSize()
-	return [2]float32{float32(w), float32(h)}
+	return g.displaySize
 }
 
 func (g *GLFWPlatform) WindowSize() [2]int {
@@ -211,8 +247,16 @@ func (g *GLFWPlatform) WindowPosition() [2]int {
 }
 
 func (g *GLFWPlatform) FramebufferSize() [2]float32 {
-	w, h := g.window.GetFramebufferSize()
-	return [2]float32{float32(w), float32(h)}
+	return g.framebufferSize
+}
+
+// updateSizes records the current display and framebuffer sizes; it must
+// be called on the main thread.
+func (g *GLFWPlatform) updateSizes() {
+	w, h := g.window.GetSize()
+	g.displaySize = [2]float32{float32(w), float32(h)}
+	fw, fh := g.window.GetFramebufferSize()
+	g.framebufferSize = [2]float32{float32(fw), float32(fh)}
 }
 
 func (g *GLFWPlatform) NewFrame() {
@@ -221,6 +265,7 @@ func (g *GLFWPlatform) NewFrame() {
 	}
 
 	// Setup display size (every frame to accommodate for window resizing)
+	g.updateSizes()
 	displaySize := g.DisplaySize()
 	g.imguiIO.SetDisplaySize(imgui.Vec2{X: displaySize[0], Y: displaySize[1]})
 
@@ -430,6 +475,10 @@ type SDLPlatform struct {
 	inputCharacters        string
 	mouseCursors           map[imgui.MouseCursorID]*sdl.Cursor
 	lastMouseX, lastMouseY int32
+
+	// As with the GLFWPlatform, the display and framebuffer sizes are
+	// cached so that they can be accessed from any goroutine.
+	displaySize, framebufferSize [2]float32
 }
 
 func NewSDLPlatform(io imgui.IO, windowSize [2]int, windowPosition [2]int) (Platform, error) {
@@ -483,6 +532,7 @@ func NewSDLPlatform(io imgui.IO, windowSize [2]int, windowPosition [2]int) (Plat
 	_ = sdl.GLSetSwapInterval(1)
 
 	window.Raise()
+	platform.updateSizes()
 
 	lg.Printf("Finished SDL initialization")
 	return platform, nil
@@ -536,13 +586,28 @@ func (s *SDLPlatform) CancelShouldStop() {
 }
 
 func (s *SDLPlatform) ProcessEvents() bool {
+	return s.processEvents(sdl.PollEvent())
+}
+
+func (s *SDLPlatform) WaitEvents(timeout time.Duration) bool {
+	return s.processEvents(sdl.WaitEventTimeout(int(timeout.Milliseconds())))
+}
+
+func (s *SDLPlatform) PostEmptyEvent() {
+	_, _ = sdl.PushEvent(&sdl.UserEvent{Type: sdl.USEREVENT})
+}
+
+// processEvents handles the provided event, if any, as well as all other
+// pending events, and reports whether there was any user input.
+func (s *SDLPlatform) processEvents(first sdl.Event) bool {
 	s.inputCharacters = ""
 	anyEvents := false
-	for event := sdl.PollEvent(); event != nil; event = sdl.PollEvent() {
+	for event := first; event != nil; event = sdl.PollEvent() {
 		if s.processEvent(event) {
 			anyEvents = true
 		}
 	}
+	s.updateSizes()
 
 	if anyEvents {
 		return true
@@ -557,17 +622,25 @@ func (s *SDLPlatform) ProcessEvents() bool {
 }
 
 func (s *SDLPlatform) DisplaySize() [2]float32 {
-	w, h := s.window.GetSize()
-	return [2]float32{float32(w), float32(h)}
+	return s.displaySize
 }
 
 func (s *SDLPlatform) FramebufferSize() [2]float32 {
-	w, h := s.window.GLGetDrawableSize()
-	return [2]float32{float32(w), float32(h)}
+	return s.framebufferSize
+}
+
+// updateSizes records the current display and framebuffer sizes; it must
+// be called on the main thread.
+func (s *SDLPlatform) updateSizes() {
+	w, h := s.window.GetSize()
+	s.displaySize = [2]float32{float32(w), float32(h)}
+	fw, fh := s.window.GLGetDrawableSize()
+	s.framebufferSize = [2]float32{float32(fw), float32(fh)}
 }
 
 func (s *SDLPlatform) NewFrame() {
 	// Setup display size (every frame to accommodate for window resizing)
+	s.updateSizes()
 	displaySize := s.DisplaySize()
 	s.imguiIO.SetDisplaySize(imgui.Vec2{X: displaySize[0], Y: displaySize[1]})
 
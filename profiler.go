@@ -0,0 +1,218 @@
+// profiler.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+package main
+
+import (
+	"encoding/json"
+	"io"
+	"sort"
+	"sync/atomic"
+	"time"
+)
+
+// Profiler records how long the phases of each frame take: updates from
+// the server, each Pane's drawing, the renderer, etc.  Timings for the
+// most recent profileFrameCount frames are kept in a ring buffer so that
+// slow frames can be examined after the fact, either in the
+// PerformancePane or by exporting them to Chrome's trace format.
+//
+// Scopes may be recorded both on the main thread and by the goroutines
+// that draw Panes concurrently; each one claims a slot in the current
+// frame's event array with an atomic increment, so no locking is needed.
+// BeginFrame and EndFrame must only be called on the main thread when no
+// other goroutines are recording scopes.
+type Profiler struct {
+	epoch  time.Time
+	frames [profileFrameCount]profileFrame
+	// Index in frames of the frame currently being recorded.
+	current int
+	// Total number of frames that have been completed.
+	completed int
+}
+
+const (
+	profileFrameCount     = 256
+	profileEventsPerFrame = 128
+)
+
+// ProfileEvent records a single named scope.  Track identifies the
+// goroutine that it ran on: zero for the main thread and the worker
+// index for concurrently drawn Panes.  Times are relative to the
+// Profiler's creation.
+type ProfileEvent struct {
+	Name, Category string
+	Track          int32
+	Start, End     time.Duration
+}
+
+func (e ProfileEvent) Duration() time.Duration {
+	return e.End - e.Start
+}
+
+type profileFrame struct {
+	start, end time.Duration
+	// Number of events that have been recorded; it may exceed
+	// profileEventsPerFrame, in which case the excess were dropped.
+	n      int32
+	events [profileEventsPerFrame]ProfileEvent
+}
+
+var profiler = &Profiler{epoch: time.Now()}
+
+// ProfileScope is returned by Profiler.Begin; its End method records the
+// scope's timing, so that the typical usage is
+// defer profiler.Begin("name", "category", 0).End().
+type ProfileScope struct {
+	p              *Profiler
+	name, category string
+	track          int32
+	start          time.Duration
+}
+
+func (p *Profiler) now() time.Duration {
+	return time.Since(p.epoch)
+}
+
+// Begin starts timing a scope with the given name and category on the
+// given track.
+func (p *Profiler) Begin(name, category string, track int32) ProfileScope {
+	return ProfileScope{p: p, name: name, category: category, track: track, start: p.now()}
+}
+
+func (s ProfileScope) End() {
+	f := &s.p.frames[s.p.current]
+	if i := atomic.AddInt32(&f.n, 1) - 1; i < profileEventsPerFrame {
+		f.events[i] = ProfileEvent{Name: s.name, Category: s.category, Track: s.track,
+			Start: s.start, End: s.p.now()}
+	}
+}
+
+// BeginFrame starts recording a new frame, overwriting the oldest one.
+func (p *Profiler) BeginFrame() {
+	f := &p.frames[p.current]
+	f.start, f.end, f.n = p.now(), 0, 0
+}
+
+// EndFrame marks the end of the current frame.
+func (p *Profiler) EndFrame() {
+	p.frames[p.current].end = p.now()
+	p.current = (p.current + 1) % profileFrameCount
+	p.completed++
+}
+
+// ProfileFrame is a completed frame's timings.
+type ProfileFrame struct {
+	Start, End time.Duration
+	Events     []ProfileEvent
+	// Number of events that didn't fit in the frame's event array.
+	Dropped int
+}
+
+func (f ProfileFrame) Duration() time.Duration {
+	return f.End - f.Start
+}
+
+// completedFrame returns a pointer to the ith oldest of the n most
+// recently completed frames.
+func (p *Profiler) completedFrame(i, n int) *profileFrame {
+	return &p.frames[(p.current-n+i+profileFrameCount)%profileFrameCount]
+}
+
+// export returns a copy of the given frame with its ProfileEvents sorted
+// by track and then start time.
+func (f *profileFrame) export() ProfileFrame {
+	ne := min(int(f.n), profileEventsPerFrame)
+	pf := ProfileFrame{Start: f.start, End: f.end, Dropped: int(f.n) - ne,
+		Events: append([]ProfileEvent(nil), f.events[:ne]...)}
+	sort.SliceStable(pf.Events, func(i, j int) bool {
+		a, b := pf.Events[i], pf.Events[j]
+		if a.Track != b.Track {
+			return a.Track < b.Track
+		}
+		if a.Start != b.Start {
+			return a.Start < b.Start
+		}
+		return a.End > b.End // enclosing scope first
+	})
+	return pf
+}
+
+// Frames returns the completed frames that are available, oldest first.
+func (p *Profiler) Frames() []ProfileFrame {
+	n := min(p.completed, profileFrameCount)
+	frames := make([]ProfileFrame, n)
+	for i := range frames {
+		frames[i] = p.completedFrame(i, n).export()
+	}
+	return frames
+}
+
+// SlowestFrame returns the slowest of the available frames, or false if
+// there are none.
+func (p *Profiler) SlowestFrame() (ProfileFrame, bool) {
+	n := min(p.completed, profileFrameCount)
+	if n == 0 {
+		return ProfileFrame{}, false
+	}
+	slowest := p.completedFrame(0, n)
+	for i := 1; i < n; i++ {
+		if f := p.completedFrame(i, n); f.end-f.start > slowest.end-slowest.start {
+			slowest = f
+		}
+	}
+	return slowest.export(), true
+}
+
+// Depths returns the nesting depth of each of the frame's events within
+// its track, for drawing the frame as a flame graph.  (Events that ended
+// in the order they were recorded always nest properly.)
+func (f ProfileFrame) Depths() []int {
+	depths := make([]int, len(f.Events))
+	var stack []time.Duration // end times of the enclosing scopes
+	track := int32(-1)
+	for i, e := range f.Events {
+		if e.Track != track {
+			track, stack = e.Track, stack[:0]
+		}
+		for len(stack) > 0 && stack[len(stack)-1] <= e.Start {
+			stack = stack[:len(stack)-1]
+		}
+		depths[i] = len(stack)
+		stack = append(stack, e.End)
+	}
+	return depths
+}
+
+// WriteChromeTrace writes all of the available frames to the given
+// Writer in the JSON format used by Chrome's about:tracing and by
+// Perfetto.
+func (p *Profiler) WriteChromeTrace(w io.Writer) error {
+	type traceEvent struct {
+		Name     string  `json:"name"`
+		Category string  `json:"cat"`
+		Phase    string  `json:"ph"`
+		Time     float64 `json:"ts"`  // microseconds
+		Duration float64 `json:"dur"` // microseconds
+		Pid      int     `json:"pid"`
+		Tid      int32   `json:"tid"`
+	}
+	us := func(d time.Duration) float64 { return float64(d.Nanoseconds()) / 1000 }
+
+	var trace struct {
+		TraceEvents     []traceEvent `json:"traceEvents"`
+		DisplayTimeUnit string       `json:"displayTimeUnit"`
+	}
+	trace.DisplayTimeUnit = "ms"
+	for _, f := range p.Frames() {
+		trace.TraceEvents = append(trace.TraceEvents, traceEvent{Name: "frame", Category: "frame",
+			Phase: "X", Time: us(f.Start), Duration: us(f.Duration())})
+		for _, e := range f.Events {
+			trace.TraceEvents = append(trace.TraceEvents, traceEvent{Name: e.Name, Category: e.Category,
+				Phase: "X", Time: us(e.Start), Duration: us(e.Duration()), Tid: e.Track})
+		}
+	}
+
+	return json.NewEncoder(w).Encode(&trace)
+}
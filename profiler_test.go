@@ -0,0 +1,90 @@
+// profiler_test.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+package main
+
+import (
+	"bytes"
+	"encoding/json"
+	"testing"
+	"time"
+)
+
+func TestProfiler(t *testing.T) {
+	p := &Profiler{epoch: time.Now()}
+	if _, ok := p.SlowestFrame(); ok {
+		t.Errorf("expected no frames before any were recorded")
+	}
+
+	record := func(e ProfileEvent) {
+		ProfileScope{p: p, name: e.Name, category: e.Category, track: e.Track, start: e.Start}.End()
+		if f := &p.frames[p.current]; f.n <= profileEventsPerFrame {
+			f.events[f.n-1].End = e.End
+		}
+	}
+
+	// Fill the ring so that the first frames are overwritten; frame i
+	// takes i microseconds.
+	nFrames := profileFrameCount + 10
+	for i := 0; i < nFrames; i++ {
+		p.BeginFrame()
+		if i == nFrames-5 {
+			// Events are recorded when scopes end, so nested scopes
+			// come first.
+			record(ProfileEvent{Name: "inner", Track: 0, Start: 2, End: 3})
+			record(ProfileEvent{Name: "outer", Track: 0, Start: 1, End: 5})
+			record(ProfileEvent{Name: "next", Track: 0, Start: 5, End: 6})
+			record(ProfileEvent{Name: "worker", Track: 1, Start: 2, End: 4})
+			for j := 0; j < profileEventsPerFrame; j++ {
+				record(ProfileEvent{Name: "extra", Track: 2, Start: 7, End: 8})
+			}
+		}
+		p.EndFrame()
+		f := &p.frames[(p.current+profileFrameCount-1)%profileFrameCount]
+		f.start, f.end = 0, time.Duration(i)*time.Microsecond
+	}
+
+	frames := p.Frames()
+	if len(frames) != profileFrameCount {
+		t.Fatalf("expected %d frames, got %d", profileFrameCount, len(frames))
+	}
+	if frames[0].End != 10*time.Microsecond {
+		t.Errorf("expected oldest frame to take 10us, got %s", frames[0].End)
+	}
+
+	slowest, ok := p.SlowestFrame()
+	if !ok || slowest.End != time.Duration(nFrames-1)*time.Microsecond {
+		t.Errorf("unexpected slowest frame %+v", slowest)
+	}
+
+	f := frames[len(frames)-5]
+	if f.Dropped != 4 {
+		t.Errorf("expected 4 dropped events, got %d", f.Dropped)
+	}
+	expected := []struct {
+		name  string
+		depth int
+	}{{"outer", 0}, {"inner", 1}, {"next", 0}, {"worker", 0}, {"extra", 0}}
+	depths := f.Depths()
+	for i, e := range expected {
+		if f.Events[i].Name != e.name || depths[i] != e.depth {
+			t.Errorf("event %d: expected %s at depth %d, got %s at depth %d", i, e.name, e.depth,
+				f.Events[i].Name, depths[i])
+		}
+	}
+
+	var buf bytes.Buffer
+	if err := p.WriteChromeTrace(&buf); err != nil {
+		t.Fatalf("WriteChromeTrace: %v", err)
+	}
+	var trace struct {
+		TraceEvents []map[string]interface{} `json:"traceEvents"`
+	}
+	if err := json.Unmarshal(buf.Bytes(), &trace); err != nil {
+		t.Fatalf("invalid trace JSON: %v", err)
+	}
+	if n := profileFrameCount + profileEventsPerFrame; len(trace.TraceEvents) != n {
+		t.Errorf("expected %d trace events, got %d", n, len(trace.TraceEvents))
+	}
+}
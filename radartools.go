@@ -7,13 +7,14 @@ package main
 import (
 	"fmt"
 	"image"
-	"image/color"
 	"image/draw"
 	"image/png"
+	"math"
 	"net/http"
 	"net/url"
 	"sort"
 	"strings"
+	"sync"
 	"time"
 
 	"github.com/go-gl/mathgl/mgl32"
@@ -28,28 +29,314 @@ import (
 // in radar scopes. Only locations in the USA are currently supported, as
 // the only current data source is the US NOAA. (TODO: find more sources
 // and add support for them!)
+//
+// Radar images are fetched in tiles that are aligned to a fixed
+// latitude-longitude grid, so that when the center moves, most of the
+// tiles that are needed are the same as before and can be reused from a
+// cache rather than being fetched again.  All of the active WeatherRadars
+// share the weatherService, which fetches each tile just once and shares
+// its GPU texture, even if multiple radar scopes cover the same region.
 type WeatherRadar struct {
 	active bool
 
-	// Images are fetched in a separate goroutine; updated radar center
-	// locations are sent from the main thread via reqChan and downloaded
-	// radar images are returned via imageChan.
-	reqChan   chan Point2LL
-	imageChan chan ImageAndBounds
-
-	// radarBounds records the lat-long bounding box of the most recently
-	// received radar image, which has texId as its GPU texture it.
-	radarBounds Extent2D
-	texId       uint32
+	// The tiles that are currently drawn; their textures are owned by
+	// the weatherService.
+	tiles []weatherTileTexture
+	// Set when the tiles have changed since the last call to Draw.
+	updated bool
 }
 
-// Latitude-longitude extent of the fetched image; the requests are +/-
-// this much from the current center.
+// Latitude-longitude extent of the region that is drawn; tiles are
+// fetched to cover +/- this much from the current center.
 const weatherLatLongExtent = 5
 
-type ImageAndBounds struct {
-	img    image.Image
+// Latitude-longitude extent of each tile and the resolution of the tile
+// images that are fetched.
+const weatherTileExtent = 5
+const weatherTileResolution = 512
+
+// NOAA posts new maps every 2 minutes; cached tiles are used until the
+// next one is available.
+const weatherUpdatePeriod = 2 * time.Minute
+
+// Number of tiles needed to cover the region around a center point.
+const weatherTilesPerView = (2*weatherLatLongExtent/weatherTileExtent + 1) *
+	(2*weatherLatLongExtent/weatherTileExtent + 1)
+
+// Number of tiles stored in a weatherTileCache beyond the ones needed for
+// the current request.  Each cached image has been upsampled to 4MB of
+// RGBA, so only a few more are kept so that panning a short ways or a
+// fetch that fails can use tiles that were fetched earlier.
+const weatherTileCacheMargin = 4
+
+// weatherTileKey identifies a weather radar tile: its lower-left corner is
+// at (x,y)*weatherTileExtent in latitude-longitude and it holds the radar
+// data from the given weatherUpdatePeriod-long interval of time.
+type weatherTileKey struct {
+	x, y   int
+	period int64
+}
+
+func (k weatherTileKey) Bounds() Extent2D {
+	p0 := Point2LL{float32(k.x * weatherTileExtent), float32(k.y * weatherTileExtent)}
+	return Extent2D{p0: p0, p1: add2ll(p0, Point2LL{weatherTileExtent, weatherTileExtent})}
+}
+
+// weatherTilesForCenter returns the keys for the tiles that cover the
+// region around the given center point, with data for the given time.
+func weatherTilesForCenter(center Point2LL, t time.Time) []weatherTileKey {
+	period := t.Unix() / int64(weatherUpdatePeriod/time.Second)
+	x0 := int(floor((center[0] - weatherLatLongExtent) / weatherTileExtent))
+	x1 := int(floor((center[0] + weatherLatLongExtent) / weatherTileExtent))
+	y0 := int(floor((center[1] - weatherLatLongExtent) / weatherTileExtent))
+	y1 := int(floor((center[1] + weatherLatLongExtent) / weatherTileExtent))
+
+	var keys []weatherTileKey
+	for y := y0; y <= y1; y++ {
+		for x := x0; x <= x1; x++ {
+			keys = append(keys, weatherTileKey{x: x, y: y, period: period})
+		}
+	}
+	return keys
+}
+
+// weatherTileTexture records a tile that has been uploaded to the GPU.
+type weatherTileTexture struct {
+	key    weatherTileKey
 	bounds Extent2D
+	texId  uint32
+}
+
+// weatherTileCache is an LRU cache of weather radar tile images.
+type weatherTileCache struct {
+	entries map[weatherTileKey]*weatherTileCacheEntry
+	// Maximum number of entries and the value of counter when the current
+	// request started; see Resize.
+	maxSize      int
+	requestStart int
+	// Incremented on each lookup; entries record its value when they are
+	// used so that the least recently used one can be found.
+	counter int
+}
+
+type weatherTileCacheEntry struct {
+	img      image.Image
+	lastUsed int
+}
+
+// Get returns the image for the given tile.  If it isn't available but
+// an image of the same region from an earlier period is, the most recent
+// such image is returned along with its key.  If no image is available,
+// nil is returned.
+func (c *weatherTileCache) Get(key weatherTileKey) (weatherTileKey, image.Image) {
+	c.counter++
+	if e, ok := c.entries[key]; ok {
+		e.lastUsed = c.counter
+		return key, e.img
+	}
+
+	var latest *weatherTileCacheEntry
+	var latestKey weatherTileKey
+	for k, e := range c.entries {
+		if k.x == key.x && k.y == key.y && (latest == nil || k.period > latestKey.period) {
+			latest, latestKey = e, k
+		}
+	}
+	if latest != nil {
+		latest.lastUsed = c.counter
+		return latestKey, latest.img
+	}
+	return key, nil
+}
+
+// Resize should be called with the number of tiles needed before a
+// request is served.  It sets the maximum number of tiles stored in the
+// cache, evicting the least recently used ones if there are more than
+// that.  Tiles that are looked up or added while serving the request are
+// never evicted, even if the cache then holds more than the maximum.
+func (c *weatherTileCache) Resize(n int) {
+	c.maxSize = n
+	c.requestStart = c.counter
+	for len(c.entries) > c.maxSize && c.evictLRU() {
+	}
+}
+
+// evictLRU evicts the least recently used tile, unless it has been used
+// for the current request.  It returns true if a tile was evicted.
+func (c *weatherTileCache) evictLRU() bool {
+	var lru weatherTileKey
+	lruUsed := math.MaxInt
+	for k, e := range c.entries {
+		if e.lastUsed < lruUsed {
+			lru, lruUsed = k, e.lastUsed
+		}
+	}
+	if lruUsed > c.requestStart {
+		return false
+	}
+	delete(c.entries, lru)
+	return true
+}
+
+// Add adds the given tile to the cache, evicting the least recently used
+// tile if the cache is full.
+func (c *weatherTileCache) Add(key weatherTileKey, img image.Image) {
+	if c.entries == nil {
+		c.entries = make(map[weatherTileKey]*weatherTileCacheEntry)
+	}
+	if _, ok := c.entries[key]; !ok && len(c.entries) >= c.maxSize {
+		c.evictLRU()
+	}
+
+	c.counter++
+	c.entries[key] = &weatherTileCacheEntry{img: img, lastUsed: c.counter}
+}
+
+// weatherServiceState manages fetching weather radar tiles on behalf of
+// all of the active WeatherRadars.  A single goroutine fetches the union
+// of the tiles that they need and the tiles' GPU textures are reference
+// counted, so that neither network use nor GPU memory grow with the
+// number of radar scopes that are showing weather over the same region.
+type weatherServiceState struct {
+	// Centers of the active WeatherRadars; the current set is sent to the
+	// fetchWeather goroutine via reqChan whenever it changes and the tiles
+	// for each are returned via resultChan.
+	centers    map[*WeatherRadar]Point2LL
+	reqChan    chan map[*WeatherRadar]Point2LL
+	resultChan chan weatherFetchResult
+
+	textures map[weatherTileKey]*weatherSharedTexture
+	// Textures for tiles that are no longer drawn by any WeatherRadar;
+	// they are reused for new tiles.
+	freeTextures []uint32
+}
+
+var weatherService weatherServiceState
+
+type weatherSharedTexture struct {
+	texId uint32
+	refs  int
+}
+
+// weatherFetchResult is sent back from the fetchWeather goroutine after
+// the tiles for a set of radar centers have been fetched.
+type weatherFetchResult struct {
+	// The tiles to draw for each WeatherRadar.
+	radarTiles map[*WeatherRadar][]weatherTileKey
+	images     map[weatherTileKey]image.Image
+}
+
+func (s *weatherServiceState) activate(w *WeatherRadar, center Point2LL) {
+	if s.reqChan == nil {
+		s.centers = make(map[*WeatherRadar]Point2LL)
+		s.textures = make(map[weatherTileKey]*weatherSharedTexture)
+		s.reqChan = make(chan map[*WeatherRadar]Point2LL, 1000) // lots of buffering
+		s.resultChan = make(chan weatherFetchResult)            // unbuffered channel
+
+		// NOAA posts new maps every 2 minutes, so fetch new maps at
+		// minimum every 100s to stay current.
+		go fetchWeather(s.reqChan, s.resultChan, 100*time.Second)
+	}
+
+	s.centers[w] = center
+	s.sendRequest()
+}
+
+func (s *weatherServiceState) deactivate(w *WeatherRadar) {
+	delete(s.centers, w)
+	for _, t := range w.tiles {
+		s.release(t.key)
+	}
+	w.tiles = nil
+	s.sendRequest()
+}
+
+func (s *weatherServiceState) updateCenter(w *WeatherRadar, center Point2LL) {
+	if c, ok := s.centers[w]; ok && c != center {
+		s.centers[w] = center
+		s.sendRequest()
+	}
+}
+
+// sendRequest sends the current set of radar centers to the fetchWeather
+// goroutine.
+func (s *weatherServiceState) sendRequest() {
+	centers := make(map[*WeatherRadar]Point2LL, len(s.centers))
+	for w, c := range s.centers {
+		centers[w] = c
+	}
+
+	select {
+	case s.reqChan <- centers:
+		// success
+	default:
+		// The channel is full; this may happen if the user is continuously
+		// dragging the radar scope around. Worst case, we drop some
+		// position update requests, which is generally no big deal.
+	}
+}
+
+// update receives the most recently fetched tiles from the fetchWeather
+// goroutine, if they are available, and updates the tiles that the
+// WeatherRadars draw.  It must be called from the main thread, since it
+// uploads textures for new tiles.
+func (s *weatherServiceState) update() {
+	var result weatherFetchResult
+	select {
+	case result = <-s.resultChan:
+	default:
+		// no message
+		return
+	}
+
+	for w, keys := range result.radarTiles {
+		if _, ok := s.centers[w]; !ok {
+			// The WeatherRadar has been deactivated since the request was made.
+			continue
+		}
+
+		// Acquire the new tiles before releasing the old ones so that
+		// tiles that remain in use don't have their textures recycled.
+		old := w.tiles
+		w.tiles = nil
+		w.updated = true
+		for _, key := range keys {
+			texId := s.acquire(key, result.images[key])
+			w.tiles = append(w.tiles, weatherTileTexture{key: key, bounds: key.Bounds(), texId: texId})
+		}
+		for _, t := range old {
+			s.release(t.key)
+		}
+	}
+}
+
+// acquire returns the texture for the given tile, uploading its image if
+// the tile isn't already on the GPU.
+func (s *weatherServiceState) acquire(key weatherTileKey, img image.Image) uint32 {
+	if t, ok := s.textures[key]; ok {
+		t.refs++
+		return t.texId
+	}
+
+	var texId uint32
+	if n := len(s.freeTextures); n > 0 {
+		texId = s.freeTextures[n-1]
+		s.freeTextures = s.freeTextures[:n-1]
+		renderer.UpdateTextureFromImage(texId, img, false)
+	} else {
+		texId = renderer.CreateTextureFromImage(img, false)
+	}
+	s.textures[key] = &weatherSharedTexture{texId: texId, refs: 1}
+	return texId
+}
+
+func (s *weatherServiceState) release(key weatherTileKey) {
+	if t, ok := s.textures[key]; ok {
+		if t.refs--; t.refs == 0 {
+			s.freeTextures = append(s.freeTextures, t.texId)
+			delete(s.textures, key)
+		}
+	}
 }
 
 // Activate must be called for the WeatherRadar to start fetching weather
@@ -62,13 +349,7 @@ func (w *WeatherRadar) Activate(center Point2LL) {
 	}
 	w.active = true
 
-	w.reqChan = make(chan Point2LL, 1000) // lots of buffering
-	w.reqChan <- center
-	w.imageChan = make(chan ImageAndBounds) // unbuffered channel
-
-	// NOAA posts new maps every 2 minutes, so fetch a new map at minimum
-	// every 100s to stay current.
-	go fetchWeather(w.reqChan, w.imageChan, 100*time.Second)
+	weatherService.activate(w, center)
 }
 
 // Deactivate causes the WeatherRadar to stop fetching weather updates;
@@ -76,176 +357,239 @@ func (w *WeatherRadar) Activate(center Point2LL) {
 // deactivated so that we don't continue to consume bandwidth fetching
 // unneeded weather images.
 func (w *WeatherRadar) Deactivate() {
-	close(w.reqChan)
+	if w.active {
+		weatherService.deactivate(w)
+	}
 	w.active = false
 }
 
-// UpdateCenter provides a new center point for the radar image, causing a
-// new image to be fetched.
+// UpdateCenter provides a new center point for the radar image, causing
+// new tiles to be fetched if needed.
 func (w *WeatherRadar) UpdateCenter(center Point2LL) {
-	select {
-	case w.reqChan <- center:
-		// success
-	default:
-		// The channel is full; this may happen if the user is continuously
-		// dragging the radar scope around. Worst case, we drop some
-		// position update requests, which is generally no big deal.
+	if w.active {
+		weatherService.updateCenter(w, center)
 	}
 }
 
-// fetchWeather runs asynchronously in a goroutine, receiving requests from
-// reqChan, fetching corresponding radar images from the NOAA, and sending
-// the results back on imageChan.  New images are also automatically
-// fetched periodically, with a wait time specified by the delay parameter.
-func fetchWeather(reqChan chan Point2LL, imageChan chan ImageAndBounds, delay time.Duration) {
-	// center stores the current center position of the radar image
-	var center Point2LL
+// fetchWeather runs asynchronously in a goroutine, receiving the centers
+// of the active WeatherRadars from reqChan, fetching the tiles that cover
+// the regions around them from the NOAA, and sending the results back on
+// resultChan.  Tiles that are not already cached are fetched in parallel;
+// each one is fetched just once even if the regions around multiple
+// centers include it.  New tiles are also automatically fetched
+// periodically, with a wait time specified by the delay parameter.
+func fetchWeather(reqChan chan map[*WeatherRadar]Point2LL, resultChan chan weatherFetchResult, delay time.Duration) {
+	var cache weatherTileCache
+
+	var centers map[*WeatherRadar]Point2LL
 	for {
-		var ok, timedOut bool
+		var timedOut bool
 		select {
-		case center, ok = <-reqChan:
-			if ok {
-				// Drain any additional requests so that we get the most
-				// recent one.
-				for len(reqChan) > 0 {
-					center = <-reqChan
-				}
-			} else {
-				// The channel is closed; wrap up.
-				close(imageChan)
-				return
+		case centers = <-reqChan:
+			// Drain any additional requests so that we get the most
+			// recent one.
+			for len(reqChan) > 0 {
+				centers = <-reqChan
 			}
 		case <-time.After(delay):
-			// Periodically make a new request even if the center hasn't
+			// Periodically make a new request even if the centers haven't
 			// changed.
 			timedOut = true
 		}
 
-		// Lat-long bounds of the region we're going to request weater for.
-		rb := Extent2D{p0: sub2ll(center, Point2LL{weatherLatLongExtent, weatherLatLongExtent}),
-			p1: add2ll(center, Point2LL{weatherLatLongExtent, weatherLatLongExtent})}
-
-		// The weather radar image comes via a WMS GetMap request from the NOAA.
-		//
-		// Relevant background:
-		// https://enterprise.arcgis.com/en/server/10.3/publish-services/windows/communicating-with-a-wms-service-in-a-web-browser.htm
-		// http://schemas.opengis.net/wms/1.3.0/capabilities_1_3_0.xsd
-		// NOAA weather: https://opengeo.ncep.noaa.gov/geoserver/www/index.html
-		// https://opengeo.ncep.noaa.gov/geoserver/conus/conus_bref_qcd/ows?service=wms&version=1.3.0&request=GetCapabilities
-		params := url.Values{}
-		params.Add("SERVICE", "WMS")
-		params.Add("REQUEST", "GetMap")
-		params.Add("FORMAT", "image/png")
-		params.Add("WIDTH", "1024")
-		params.Add("HEIGHT", "1024")
-		params.Add("LAYERS", "conus_bref_qcd")
-		params.Add("BBOX", fmt.Sprintf("%f,%f,%f,%f", rb.p0[0], rb.p0[1], rb.p1[0], rb.p1[1]))
-
-		url := "https://opengeo.ncep.noaa.gov/geoserver/conus/conus_bref_qcd/ows?" + params.Encode()
-		lg.Printf("Fetching weather: %s", url)
-
-		// Request the image
-		resp, err := http.Get(url)
-		if err != nil {
-			lg.Printf("Weather error: %s", err)
+		if len(centers) == 0 {
 			continue
 		}
-		defer resp.Body.Close()
 
-		img, err := png.Decode(resp.Body)
-		if err != nil {
-			lg.Printf("Weather error: %s", err)
-			continue
+		// Find the union of the tiles needed for all of the centers.
+		now := time.Now()
+		result := weatherFetchResult{
+			radarTiles: make(map[*WeatherRadar][]weatherTileKey),
+			images:     make(map[weatherTileKey]image.Image),
+		}
+		needed := make(map[weatherTileKey]interface{})
+		for w, center := range centers {
+			keys := weatherTilesForCenter(center, now)
+			result.radarTiles[w] = keys
+			for _, key := range keys {
+				needed[key] = nil
+			}
 		}
 
-		// Convert the Image returned by png.Decode to an RGBA image so
-		// that we can patch up some of the pixel values.
-		rgba := image.NewRGBA(img.Bounds())
-		draw.Draw(rgba, img.Bounds(), img, image.Point{}, draw.Over)
-		ny, nx := img.Bounds().Dy(), img.Bounds().Dx()
-		for y := 0; y < ny; y++ {
-			for x := 0; x < nx; x++ {
-				r, g, b, a := img.At(x, y).RGBA()
-				// Convert all-white to black and an alpha channel of zero, so
-				// that where there's no weather, nothing is drawn.
-				if r == 0xffff && g == 0xffff && b == 0xffff && a == 0xffff {
-					rgba.Set(x, y, color.RGBA{})
-				}
+		// Make sure that the cache can hold all of the tiles needed for
+		// the union of the centers, so that serving this request doesn't
+		// evict tiles that it uses.
+		cache.Resize(max(len(needed), weatherTilesPerView) + weatherTileCacheMargin)
+
+		// Start fetching the tiles that aren't in the cache.  resolved
+		// maps from the requested tiles to the tiles whose images will
+		// be used for them; if a fetch fails, an older version of the
+		// tile is used if one is available.
+		resolved := make(map[weatherTileKey]weatherTileKey)
+		var missing []weatherTileKey
+		for key := range needed {
+			if cachedKey, img := cache.Get(key); img != nil && cachedKey == key {
+				result.images[key] = img
+				resolved[key] = key
+			} else {
+				missing = append(missing, key)
 			}
 		}
 
-		// The image we get back is relatively low resolution (and doesn't
-		// even have 1024x1024 pixels of actual detail); use a decent
-		// filter to upsample it, which looks better than relying on GPU
-		// bilinear interpolation...
-		resized := resize.Resize(2048, 2048, rgba, resize.MitchellNetravali)
+		var wg sync.WaitGroup
+		fetched := make([]image.Image, len(missing))
+		for i, key := range missing {
+			wg.Add(1)
+			go func(i int, key weatherTileKey) {
+				defer wg.Done()
+				if img, err := fetchWeatherTile(key.Bounds()); err != nil {
+					lg.Printf("Weather error: %s", err)
+				} else {
+					fetched[i] = img
+				}
+			}(i, key)
+		}
+		wg.Wait()
+
+		for i, key := range missing {
+			if fetched[i] != nil {
+				cache.Add(key, fetched[i])
+				result.images[key] = fetched[i]
+				resolved[key] = key
+			} else if cachedKey, img := cache.Get(key); img != nil {
+				result.images[cachedKey] = img
+				resolved[key] = cachedKey
+			}
+		}
 
-		// Send it back to the main thread.
-		imageChan <- ImageAndBounds{img: resized, bounds: rb}
-		lg.Printf("finish weather fetch")
+		// Send back the tiles that we have images for.
+		for w, keys := range result.radarTiles {
+			var available []weatherTileKey
+			for _, key := range keys {
+				if rk, ok := resolved[key]; ok {
+					available = append(available, rk)
+				}
+			}
+			result.radarTiles[w] = available
+		}
+		// Make sure the main loop isn't waiting for events so that it
+		// receives the result promptly.
+		wakeMainLoop()
+		resultChan <- result
+		if len(missing) > 0 {
+			lg.Printf("finish weather fetch: %d tiles, %d fetched", len(needed), len(missing))
+		}
 
-		if !timedOut {
+		if !timedOut && len(missing) > 0 {
 			time.Sleep(15 * time.Second)
 		}
 	}
 }
 
+// fetchWeatherTile fetches the weather radar image for the given
+// latitude-longitude bounds.
+func fetchWeatherTile(rb Extent2D) (image.Image, error) {
+	// The weather radar image comes via a WMS GetMap request from the NOAA.
+	//
+	// Relevant background:
+	// https://enterprise.arcgis.com/en/server/10.3/publish-services/windows/communicating-with-a-wms-service-in-a-web-browser.htm
+	// http://schemas.opengis.net/wms/1.3.0/capabilities_1_3_0.xsd
+	// NOAA weather: https://opengeo.ncep.noaa.gov/geoserver/www/index.html
+	// https://opengeo.ncep.noaa.gov/geoserver/conus/conus_bref_qcd/ows?service=wms&version=1.3.0&request=GetCapabilities
+	params := url.Values{}
+	params.Add("SERVICE", "WMS")
+	params.Add("REQUEST", "GetMap")
+	params.Add("FORMAT", "image/png")
+	params.Add("WIDTH", fmt.Sprintf("%d", weatherTileResolution))
+	params.Add("HEIGHT", fmt.Sprintf("%d", weatherTileResolution))
+	params.Add("LAYERS", "conus_bref_qcd")
+	params.Add("BBOX", fmt.Sprintf("%f,%f,%f,%f", rb.p0[0], rb.p0[1], rb.p1[0], rb.p1[1]))
+
+	url := "https://opengeo.ncep.noaa.gov/geoserver/conus/conus_bref_qcd/ows?" + params.Encode()
+	lg.Printf("Fetching weather: %s", url)
+
+	// Request the image
+	resp, err := http.Get(url)
+	if err != nil {
+		return nil, err
+	}
+	defer resp.Body.Close()
+
+	img, err := png.Decode(resp.Body)
+	if err != nil {
+		return nil, err
+	}
+
+	// Convert the Image returned by png.Decode to an RGBA image (if it
+	// isn't one already) so that we can patch up some of the pixel
+	// values.
+	rgba, ok := img.(*image.RGBA)
+	if !ok {
+		rgba = image.NewRGBA(img.Bounds())
+		draw.Draw(rgba, img.Bounds(), img, img.Bounds().Min, draw.Src)
+	}
+	// Convert all-white to black and an alpha channel of zero, so that
+	// where there's no weather, nothing is drawn.
+	ny, nx := rgba.Bounds().Dy(), rgba.Bounds().Dx()
+	for y := 0; y < ny; y++ {
+		row := rgba.Pix[y*rgba.Stride : y*rgba.Stride+4*nx]
+		for x := 0; x < len(row); x += 4 {
+			if row[x] == 0xff && row[x+1] == 0xff && row[x+2] == 0xff && row[x+3] == 0xff {
+				row[x], row[x+1], row[x+2], row[x+3] = 0, 0, 0, 0
+			}
+		}
+	}
+
+	// The image we get back is relatively low resolution (and doesn't
+	// even have full resolution of actual detail); use a decent filter to
+	// upsample it, which looks better than relying on GPU bilinear
+	// interpolation...
+	return resize.Resize(2*weatherTileResolution, 2*weatherTileResolution, rgba, resize.MitchellNetravali), nil
+}
+
 // Draw draws the current weather radar image, if available. (If none is yet
 // available, it returns rather than stalling waiting for it). The provided
 // CommandBuffer should be set up with viewing matrices such that vertex
-// coordinates are provided in latitude-longitude.
+// coordinates are provided in latitude-longitude.  Updated tiles from the
+// fetchWeather goroutine are received separately, on the main thread, by
+// weatherService.update, so Draw may be called from any goroutine.
 func (w *WeatherRadar) Draw(intensity float32, transforms ScopeTransformations, cb *CommandBuffer) {
-	// Try to receive an updated image from the fetchWather goroutine, if
-	// one is available.
-	select {
-	case ib, ok := <-w.imageChan:
-		if ok {
-			w.radarBounds = ib.bounds
-			if w.texId == 0 {
-				w.texId = renderer.CreateTextureFromImage(ib.img, false)
-			} else {
-				renderer.UpdateTextureFromImage(w.texId, ib.img, false)
-			}
-		}
-	default:
-		// no message
-	}
+	w.updated = false
 
-	// Note that we always go ahead and drain the imageChan, even if if the
-	// WeatherRadar is inactive. This way the chan is ready for the
-	// future...
 	if !w.active {
 		return
 	}
 
-	if w.texId == 0 {
+	if len(w.tiles) == 0 {
 		// Presumably we haven't yet gotten a response to the initial
 		// request...
 		return
 	}
 
-	// We have a valid radar image, so draw it.
+	// We have valid radar images, so draw them.
 	transforms.LoadLatLongViewingMatrices(cb)
 	cb.SetRGBA(RGBA{1, 1, 1, intensity})
 	cb.Blend()
-	cb.EnableTexture(w.texId)
-
-	// Draw the lat-long space quad corresponding to the region that we
-	// have weather for; just stuff the vertex and index buffers into the
-	// CommandBuffer directly rather than bothering with a
-	// TrianglesDrawable or the like.
-	rb := w.radarBounds
-	p := [4][2]float32{[2]float32{rb.p0[0], rb.p0[1]}, [2]float32{rb.p1[0], rb.p0[1]},
-		[2]float32{rb.p1[0], rb.p1[1]}, [2]float32{rb.p0[0], rb.p1[1]}}
-	pidx := cb.Float2Buffer(p[:])
-	cb.VertexArray(pidx, 2, 2*4)
 
 	uv := [4][2]float32{[2]float32{0, 1}, [2]float32{1, 1}, [2]float32{1, 0}, [2]float32{0, 0}}
 	uvidx := cb.Float2Buffer(uv[:])
 	cb.TexCoordArray(uvidx, 2, 2*4)
-
 	indidx := cb.IntBuffer([]int32{0, 1, 2, 3})
-	cb.DrawQuads(indidx, 4)
+
+	// Draw the lat-long space quad corresponding to each tile; just stuff
+	// the vertex and index buffers into the CommandBuffer directly rather
+	// than bothering with a TrianglesDrawable or the like.
+	for _, tile := range w.tiles {
+		cb.EnableTexture(tile.texId)
+
+		rb := tile.bounds
+		p := [4][2]float32{[2]float32{rb.p0[0], rb.p0[1]}, [2]float32{rb.p1[0], rb.p0[1]},
+			[2]float32{rb.p1[0], rb.p1[1]}, [2]float32{rb.p0[0], rb.p1[1]}}
+		pidx := cb.Float2Buffer(p[:])
+		cb.VertexArray(pidx, 2, 2*4)
+
+		cb.DrawQuads(indidx, 4)
+	}
 
 	cb.DisableTexture()
 	cb.DisableBlend()
@@ -325,6 +669,33 @@ func runwayIntersection(a *Runway, b *Runway) (Point2LL, bool) {
 	return nm2ll(p), ok
 }
 
+// releaseGhosts releases the track storage of all of the ghosts in the
+// given map, which maps from aircraft to their ghosts.
+func releaseGhosts(ghosts map[*Aircraft]*Aircraft) {
+	for _, ghost := range ghosts {
+		ghost.Tracks.Release()
+	}
+}
+
+// duplicateGhosts returns a copy of the given ghosts with their own track
+// storage, so that they can be released independently of the originals.
+// The function f is called for each ghost with the original and its
+// copy.
+func duplicateGhosts(ghosts map[*Aircraft]*Aircraft, f func(orig, dupe *Aircraft)) map[*Aircraft]*Aircraft {
+	dupes := make(map[*Aircraft]*Aircraft)
+	for ac, gh := range ghosts {
+		ghost := *gh // make a copy
+		ghost.Tracks = gh.Tracks.Duplicate()
+		dupes[ac] = &ghost
+		f(gh, &ghost)
+	}
+	return dupes
+}
+
+// GetGhost returns a ghost of the given aircraft for the other runway if
+// it is in the CRDA region, or nil otherwise.  The ghost's tracks are
+// stored separately from the aircraft's; they should be released with
+// releaseGhosts when the ghost is no longer needed.
 func (c *CRDAConfig) GetGhost(ac *Aircraft) *Aircraft {
 	src, dst := c.getRunways()
 	if src == nil || dst == nil {
@@ -337,7 +708,7 @@ func (c *CRDAConfig) GetGhost(ac *Aircraft) *Aircraft {
 		return nil
 	}
 
-	airport, ok := database.FAA.airports[c.Airport]
+	airport, ok := database.FAA.LookupAirport(c.Airport)
 	if !ok {
 		lg.Printf("%s: airport unknown?!", c.Airport)
 		return nil
@@ -390,8 +761,11 @@ func (c *CRDAConfig) GetGhost(ac *Aircraft) *Aircraft {
 	// Now we just need to update the track positions to be those for
 	// the ghost. We'll again do this in nm space before going to
 	// lat-long in the end.
+	ghost.Tracks = ac.Tracks.Duplicate()
 	pi := ll2nm(pIntersect)
-	for i, t := range ghost.Tracks {
+	for it := ghost.Tracks.Iterate(ghost.Tracks.Len()); it.Next(); {
+		t := it.Track()
+
 		// Vector from the intersection point to the track location
 		v := sub2f(ll2nm(t.Position), pi)
 
@@ -409,7 +783,7 @@ func (c *CRDAConfig) GetGhost(ac *Aircraft) *Aircraft {
 		pr := add2f(pi, vr)
 
 		// TODO: offset it as appropriate
-		ghost.Tracks[i].Position = nm2ll(pr)
+		t.Position = nm2ll(pr)
 	}
 	return &ghost
 }
@@ -1073,6 +1447,26 @@ func UpdateScopePosition(mouse *MouseState, button int, transforms ScopeTransfor
 	return
 }
 
+// scopeNextRedraw returns the time at which a radar scope should next be
+// redrawn, absent any other changes: the scopes' clocks, blinking, and
+// lost-track timeouts all work with one-second granularity, in terms of
+// both the server's time and the actual time, and the highlighted
+// location fades out continuously.
+func scopeNextRedraw() time.Time {
+	now := time.Now()
+	if now.Before(positionConfig.highlightedLocationEndTime) {
+		return now
+	}
+
+	next := now.Truncate(time.Second).Add(time.Second)
+	if st := server.CurrentTime(); !st.IsZero() {
+		if sn := now.Add(st.Truncate(time.Second).Add(time.Second).Sub(st)); sn.Before(next) {
+			next = sn
+		}
+	}
+	return next
+}
+
 // If the user has run the "find" command to highlight a point in the
 // world, draw a red circle around that point for a few seconds.
 func DrawHighlighted(ctx *PaneContext, transforms ScopeTransformations, cb *CommandBuffer) {
@@ -0,0 +1,537 @@
+// renderer-batch.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+package main
+
+// This file implements an optional pass that rewrites a CommandBuffer so
+// that adjacent draw commands that are rendered with the same state are
+// merged into a single draw command.  Each pane generates its own
+// commands (and often, each DrawBuilder within a pane generates its own
+// buffers and draw commands), so a frame's CommandBuffer has many small
+// draws separated by redundant state changes; after batching, there are
+// fewer draw calls and state changes for the Renderer to issue.
+//
+// Batching works by interpreting the CommandBuffer, tracking the
+// rendering state that it sets, and accumulating the vertices used by
+// each draw command.  When a draw command can't be merged with the ones
+// before it, the accumulated vertices are written to the output
+// CommandBuffer along with the state changes needed to draw them.  Only
+// adjacent draws are merged, so the order in which things are drawn is
+// unchanged.  Called CommandBuffers that are static are emitted as calls
+// in the output so that the Renderer can still use its retained copies;
+// other called CommandBuffers are flattened into the output.
+
+import (
+	"math"
+	"sync"
+	"unsafe"
+)
+
+// batchArray records the most recent specification of a vertex
+// attribute array.
+type batchArray struct {
+	enabled bool
+	// The CommandBuffer that the array is stored in.
+	src            *CommandBuffer
+	offset, stride int
+	ncomps         int
+	// For color arrays: 8-bit vs float32 components.
+	rgb8 bool
+}
+
+// batchRenderState is the rendering state, other than the vertex arrays,
+// used by a draw command.  The "known" flags are false until the
+// corresponding state is first set.
+type batchRenderState struct {
+	projection, modelview           [16]float32
+	projectionKnown, modelviewKnown bool
+
+	viewport      [4]int32
+	viewportKnown bool
+
+	scissorEnabled bool
+	scissor        [4]int32
+
+	blend bool
+
+	// The current color, which is used if the color array is disabled.
+	rgba      [4]float32
+	rgbaKnown bool
+
+	textureEnabled bool
+	texture        uint32
+
+	pointSize, lineWidth           float32
+	pointSizeKnown, lineWidthKnown bool
+}
+
+// batchKey encodes everything about a draw command that must match for
+// it to be merged into a batch.  State that doesn't affect the draw is
+// normalized (e.g., the texture id if texturing is disabled) so that
+// irrelevant differences don't prevent draws from being merged.
+type batchKey struct {
+	command uint32
+	state   batchRenderState
+	// Which of the optional arrays are in use; the batch's arrays are
+	// always densely packed, so their layout in the source buffers
+	// doesn't matter.
+	color, colorRGB8, texCoord bool
+}
+
+// drawBatcher holds the state of the batching pass.
+type drawBatcher struct {
+	out *CommandBuffer
+
+	// The state as set by the commands processed so far.
+	state                   batchRenderState
+	vertex, color, texCoord batchArray
+
+	// The state that the output CommandBuffer leaves the Renderer in.
+	emitted                                      batchRenderState
+	emittedVertex, emittedColor, emittedTexCoord bool
+	// Set after a static CommandBuffer has been called, since it may
+	// leave arbitrary arrays enabled.
+	emittedArraysUnknown bool
+
+	// When non-zero, draws only update the state; this is used when
+	// processing a static CommandBuffer that is emitted as a call.
+	stateOnly int
+
+	// The pending batch of draws.
+	key       batchKey
+	positions [][2]float32
+	rgb       []RGB
+	rgba8     []int32
+	uv        [][2]float32
+	indices   []int32
+
+	// Number of draw commands in the input and the output.
+	drawsIn, drawsOut int
+	// Set if something was encountered that the batcher doesn't handle.
+	failed bool
+}
+
+var drawBatcherPool = sync.Pool{New: func() any { return &drawBatcher{} }}
+
+// BatchCommandBuffer adds commands to out that render the same thing as
+// cb but with adjacent compatible draw commands merged.  It returns the
+// number of draw commands that were eliminated and a boolean that
+// indicates whether batching was successful; if it returns false, cb
+// includes commands that the batcher does not support and it should be
+// rendered directly instead.
+func BatchCommandBuffer(cb *CommandBuffer, out *CommandBuffer) (merged int, ok bool) {
+	b := drawBatcherPool.Get().(*drawBatcher)
+	defer drawBatcherPool.Put(b)
+
+	// Reuse the allocations from previous batches.
+	*b = drawBatcher{
+		out:       out,
+		positions: b.positions[:0],
+		rgb:       b.rgb[:0],
+		rgba8:     b.rgba8[:0],
+		uv:        b.uv[:0],
+		indices:   b.indices[:0],
+	}
+
+	b.process(cb)
+	if !b.failed {
+		b.flush()
+	}
+	b.out = nil
+
+	if b.failed {
+		return 0, false
+	}
+	return b.drawsIn - b.drawsOut, true
+}
+
+// uint32At returns the 32-bit value at the given byte offset in the
+// CommandBuffer.
+func uint32At(cb *CommandBuffer, offset int) uint32 {
+	if offset%4 == 0 {
+		return cb.buf[offset/4]
+	}
+	// Unaligned, which may happen with RGB8 arrays in raw buffers.
+	ptr := uintptr(unsafe.Pointer(&cb.buf[0])) + uintptr(offset)
+	return *(*uint32)(unsafe.Pointer(ptr))
+}
+
+func float32At(cb *CommandBuffer, offset int) float32 {
+	return math.Float32frombits(uint32At(cb, offset))
+}
+
+// process interprets the commands in cb, updating the current state and
+// accumulating draws.
+func (b *drawBatcher) process(cb *CommandBuffer) {
+	i := 0
+	ui32 := func() uint32 {
+		v := cb.buf[i]
+		i++
+		return v
+	}
+	i32 := func() int32 { return int32(ui32()) }
+	float := func() float32 { return math.Float32frombits(ui32()) }
+	array := func(rgb8 bool) batchArray {
+		offset := int(ui32())
+		ncomps := int(i32())
+		stride := int(i32())
+		return batchArray{enabled: true, src: cb, offset: offset, ncomps: ncomps, stride: stride, rgb8: rgb8}
+	}
+	matrix := func(m *[16]float32) {
+		for j := range m {
+			m[j] = float()
+		}
+	}
+
+	for i < len(cb.buf) && !b.failed {
+		cmd := ui32()
+		switch cmd {
+		case RendererLoadProjectionMatrix:
+			matrix(&b.state.projection)
+			b.state.projectionKnown = true
+
+		case RendererLoadModelViewMatrix:
+			matrix(&b.state.modelview)
+			b.state.modelviewKnown = true
+
+		case RendererClearRGBA:
+			r, g, bl, a := float(), float(), float(), float()
+			if b.stateOnly == 0 {
+				// The clear is affected by the scissor rectangle, so the
+				// state must be up to date when it's emitted.
+				b.flush()
+				b.emitState(b.state)
+				b.out.appendInts(RendererClearRGBA)
+				b.out.appendFloats(r, g, bl, a)
+			}
+
+		case RendererScissor:
+			b.state.scissorEnabled = true
+			b.state.scissor = [4]int32{i32(), i32(), i32(), i32()}
+
+		case RendererViewport:
+			b.state.viewport = [4]int32{i32(), i32(), i32(), i32()}
+			b.state.viewportKnown = true
+
+		case RendererBlend:
+			b.state.blend = true
+
+		case RendererDisableBlend:
+			b.state.blend = false
+
+		case RendererSetRGBA:
+			b.state.rgba = [4]float32{float(), float(), float(), float()}
+			b.state.rgbaKnown = true
+			// Setting the color also disables the color array.
+			b.color.enabled = false
+
+		case RendererFloatBuffer, RendererIntBuffer, RendererRawBuffer:
+			i += int(ui32())
+
+		case RendererEnableTexture:
+			b.state.textureEnabled = true
+			b.state.texture = ui32()
+
+		case RendererDisableTexture:
+			b.state.textureEnabled = false
+
+		case RendererVertexArray:
+			b.vertex = array(false)
+
+		case RendererDisableVertexArray:
+			b.vertex.enabled = false
+
+		case RendererRGB32Array:
+			b.color = array(false)
+
+		case RendererRGB8Array:
+			b.color = array(true)
+
+		case RendererDisableColorArray:
+			b.color.enabled = false
+
+		case RendererTexCoordArray:
+			b.texCoord = array(false)
+
+		case RendererDisableTexCoordArray:
+			b.texCoord.enabled = false
+
+		case RendererPointSize:
+			b.state.pointSize = float()
+			b.state.pointSizeKnown = true
+
+		case RendererLineWidth:
+			b.state.lineWidth = float()
+			b.state.lineWidthKnown = true
+
+		case RendererDrawPoints, RendererDrawLines, RendererDrawTriangles, RendererDrawQuads:
+			offset := int(ui32())
+			count := int(i32())
+			b.draw(cmd, cb, offset, count)
+
+		case RendererResetState:
+			b.state.scissorEnabled = false
+			b.state.blend = false
+			b.vertex.enabled = false
+			b.color.enabled = false
+			b.texCoord.enabled = false
+			b.state.textureEnabled = false
+
+		case RendererCallBuffer:
+			sub := &cb.called[ui32()]
+			if sub.static != nil && b.stateOnly == 0 {
+				b.callStatic(sub)
+			} else {
+				b.process(sub)
+			}
+
+		default:
+			b.failed = true
+		}
+	}
+}
+
+// callStatic emits a call to the given static CommandBuffer in the
+// output and then updates the current state to account for the state
+// changes that it makes.
+func (b *drawBatcher) callStatic(sub *CommandBuffer) {
+	b.flush()
+	b.emitState(b.state)
+	// Make sure that arrays that are disabled in the input are disabled
+	// in the output; the static buffer specifies any arrays that it uses.
+	if !b.vertex.enabled && (b.emittedVertex || b.emittedArraysUnknown) {
+		b.out.DisableVertexArray()
+	}
+	if !b.color.enabled && (b.emittedColor || b.emittedArraysUnknown) {
+		b.out.DisableColorArray()
+	}
+	if !b.texCoord.enabled && (b.emittedTexCoord || b.emittedArraysUnknown) {
+		b.out.DisableTexCoordArray()
+	}
+	b.out.Call(*sub)
+
+	// Run through the called buffer to bring the current state up to
+	// date.  Its draws aren't accumulated, since the Renderer draws them
+	// directly from its copy of the buffer.
+	b.stateOnly++
+	nDraws := b.drawsIn
+	b.process(sub)
+	b.drawsOut += b.drawsIn - nDraws
+	b.stateOnly--
+
+	// Now the Renderer's state matches the current state, other than
+	// the vertex arrays, which refer to the called buffer's arrays.
+	b.emitted = b.state
+	b.emittedArraysUnknown = true
+}
+
+// draw handles a single draw command, either adding it to the current
+// batch or flushing the current batch and starting a new one.
+func (b *drawBatcher) draw(cmd uint32, cb *CommandBuffer, offset, count int) {
+	b.drawsIn++
+
+	if b.stateOnly == 0 && count > 0 {
+		b.accumulate(cmd, cb, offset, count)
+	}
+
+	// Account for the state changes that draws cause.
+	if cmd == RendererDrawPoints {
+		// The Renderer disables blending after drawing points.
+		b.state.blend = false
+	}
+	if b.color.enabled {
+		// The current color is undefined after drawing with a color
+		// array.
+		b.state.rgbaKnown = false
+	}
+}
+
+// accumulate adds the vertices used by a draw command to the current
+// batch, first flushing the batch if the draw isn't compatible with it.
+func (b *drawBatcher) accumulate(cmd uint32, cb *CommandBuffer, offset, count int) {
+	if !b.vertex.enabled || b.vertex.ncomps != 2 ||
+		(b.color.enabled && !(b.color.ncomps == 3 && !b.color.rgb8) && !(b.color.ncomps == 4 && b.color.rgb8)) ||
+		(b.texCoord.enabled && b.texCoord.ncomps != 2) {
+		// Not something we know how to handle.
+		b.failed = true
+		return
+	}
+
+	key := batchKey{
+		command:   cmd,
+		state:     b.state,
+		color:     b.color.enabled,
+		colorRGB8: b.color.enabled && b.color.rgb8,
+		texCoord:  b.texCoord.enabled,
+	}
+	s := &key.state
+	if !s.scissorEnabled {
+		s.scissor = [4]int32{}
+	}
+	if !s.textureEnabled {
+		s.texture = 0
+	}
+	if key.color {
+		s.rgba, s.rgbaKnown = [4]float32{}, false
+	}
+	if cmd != RendererDrawPoints {
+		s.pointSize, s.pointSizeKnown = 0, false
+	}
+	if cmd != RendererDrawLines {
+		s.lineWidth, s.lineWidthKnown = 0, false
+	}
+
+	if len(b.indices) > 0 && key != b.key {
+		b.flush()
+	}
+	b.key = key
+
+	// Copy each vertex used by the draw into the batch; the batch's
+	// indices are then just sequential.
+	for j := 0; j < count; j++ {
+		idx := int(uint32At(cb, offset+4*j))
+
+		po := b.vertex.offset + idx*b.vertex.stride
+		b.positions = append(b.positions, [2]float32{float32At(b.vertex.src, po), float32At(b.vertex.src, po+4)})
+
+		if b.color.enabled {
+			co := b.color.offset + idx*b.color.stride
+			if b.color.rgb8 {
+				b.rgba8 = append(b.rgba8, int32(uint32At(b.color.src, co)))
+			} else {
+				b.rgb = append(b.rgb, RGB{R: float32At(b.color.src, co), G: float32At(b.color.src, co+4),
+					B: float32At(b.color.src, co+8)})
+			}
+		}
+		if b.texCoord.enabled {
+			to := b.texCoord.offset + idx*b.texCoord.stride
+			b.uv = append(b.uv, [2]float32{float32At(b.texCoord.src, to), float32At(b.texCoord.src, to+4)})
+		}
+
+		b.indices = append(b.indices, int32(len(b.indices)))
+	}
+}
+
+// emitState adds the commands to the output that are needed to bring
+// the Renderer's state to the given state.
+func (b *drawBatcher) emitState(s batchRenderState) {
+	out, e := b.out, &b.emitted
+
+	if e.scissorEnabled && !s.scissorEnabled {
+		// The only way to disable the scissor test is to reset
+		// everything.
+		out.ResetState()
+		e.scissorEnabled, e.blend, e.textureEnabled = false, false, false
+		b.emittedVertex, b.emittedColor, b.emittedTexCoord = false, false, false
+		b.emittedArraysUnknown = false
+	}
+
+	if s.projectionKnown && (!e.projectionKnown || e.projection != s.projection) {
+		out.appendInts(RendererLoadProjectionMatrix)
+		out.appendFloats(s.projection[:]...)
+		e.projection, e.projectionKnown = s.projection, true
+	}
+	if s.modelviewKnown && (!e.modelviewKnown || e.modelview != s.modelview) {
+		out.appendInts(RendererLoadModelViewMatrix)
+		out.appendFloats(s.modelview[:]...)
+		e.modelview, e.modelviewKnown = s.modelview, true
+	}
+	if s.viewportKnown && (!e.viewportKnown || e.viewport != s.viewport) {
+		out.Viewport(int(s.viewport[0]), int(s.viewport[1]), int(s.viewport[2]), int(s.viewport[3]))
+		e.viewport, e.viewportKnown = s.viewport, true
+	}
+	if s.scissorEnabled && (!e.scissorEnabled || e.scissor != s.scissor) {
+		out.Scissor(int(s.scissor[0]), int(s.scissor[1]), int(s.scissor[2]), int(s.scissor[3]))
+		e.scissor, e.scissorEnabled = s.scissor, true
+	}
+	if s.blend != e.blend {
+		if s.blend {
+			out.Blend()
+		} else {
+			out.DisableBlend()
+		}
+		e.blend = s.blend
+	}
+	if s.rgbaKnown && (!e.rgbaKnown || e.rgba != s.rgba) {
+		out.appendInts(RendererSetRGBA)
+		out.appendFloats(s.rgba[:]...)
+		e.rgba, e.rgbaKnown = s.rgba, true
+		// This also disables the color array.
+		b.emittedColor = false
+	}
+	if s.textureEnabled && (!e.textureEnabled || e.texture != s.texture) {
+		out.EnableTexture(s.texture)
+		e.texture, e.textureEnabled = s.texture, true
+	} else if !s.textureEnabled && e.textureEnabled {
+		out.DisableTexture()
+		e.textureEnabled = false
+	}
+	// The point size and line width have already been scaled for the
+	// display, so they're added directly rather than via the
+	// CommandBuffer methods, which would scale them again.
+	if s.pointSizeKnown && (!e.pointSizeKnown || e.pointSize != s.pointSize) {
+		out.appendInts(RendererPointSize)
+		out.appendFloats(s.pointSize)
+		e.pointSize, e.pointSizeKnown = s.pointSize, true
+	}
+	if s.lineWidthKnown && (!e.lineWidthKnown || e.lineWidth != s.lineWidth) {
+		out.appendInts(RendererLineWidth)
+		out.appendFloats(s.lineWidth)
+		e.lineWidth, e.lineWidthKnown = s.lineWidth, true
+	}
+}
+
+// flush emits the pending batch of draws, if there is one.
+func (b *drawBatcher) flush() {
+	if len(b.indices) == 0 {
+		return
+	}
+
+	k := &b.key
+	b.emitState(k.state)
+
+	out := b.out
+	p := out.Float2Buffer(b.positions)
+	out.VertexArray(p, 2, 2*4)
+	b.emittedVertex = true
+
+	if k.color {
+		if k.colorRGB8 {
+			rgba := out.IntBuffer(b.rgba8)
+			out.RGB8Array(rgba, 4, 4)
+		} else {
+			rgb := out.RGBBuffer(b.rgb)
+			out.RGB32Array(rgb, 3, 3*4)
+		}
+		b.emittedColor = true
+		b.emitted.rgbaKnown = false
+	} else if b.emittedColor || b.emittedArraysUnknown {
+		out.DisableColorArray()
+		b.emittedColor = false
+	}
+
+	if k.texCoord {
+		uv := out.Float2Buffer(b.uv)
+		out.TexCoordArray(uv, 2, 2*4)
+		b.emittedTexCoord = true
+	} else if b.emittedTexCoord || b.emittedArraysUnknown {
+		out.DisableTexCoordArray()
+		b.emittedTexCoord = false
+	}
+	b.emittedArraysUnknown = false
+
+	ind := out.IntBuffer(b.indices)
+	out.appendInts(int(k.command), ind, len(b.indices))
+	b.drawsOut++
+
+	if k.command == RendererDrawPoints {
+		b.emitted.blend = false
+	}
+
+	b.positions = b.positions[:0]
+	b.rgb = b.rgb[:0]
+	b.rgba8 = b.rgba8[:0]
+	b.uv = b.uv[:0]
+	b.indices = b.indices[:0]
+}
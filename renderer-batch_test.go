@@ -0,0 +1,251 @@
+// renderer-batch_test.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+package main
+
+import (
+	"math"
+	"testing"
+)
+
+// batchTestVertex records everything that determines how a single vertex
+// of a draw command is rendered.
+type batchTestVertex struct {
+	command          uint32
+	viewport         [4]int32
+	scissorEnabled   bool
+	scissor          [4]int32
+	blend            bool
+	texture          uint32
+	width            float32 // line width or point size
+	projection, view float32 // first element of each matrix
+	pos              [2]float32
+	rgba             [4]float32
+	uv               [2]float32
+}
+
+// renderForTest interprets the commands in the CommandBuffer and returns
+// the vertices drawn, in order.  Clears are recorded as vertices with the
+// RendererClearRGBA command.
+func renderForTest(t *testing.T, cb *CommandBuffer) []batchTestVertex {
+	var verts []batchTestVertex
+	var v batchTestVertex
+	var rgba [4]float32
+	var pointSize, lineWidth float32
+	type array struct {
+		cb                 *CommandBuffer
+		offset, nc, stride int
+		enabled, rgb8      bool
+	}
+	var vertex, color, texCoord array
+
+	var render func(cb *CommandBuffer)
+	render = func(cb *CommandBuffer) {
+		i := 0
+		ui32 := func() uint32 { i++; return cb.buf[i-1] }
+		float := func() float32 { return math.Float32frombits(ui32()) }
+		i4 := func() [4]int32 { return [4]int32{int32(ui32()), int32(ui32()), int32(ui32()), int32(ui32())} }
+		arr := func(rgb8 bool) array {
+			return array{cb: cb, offset: int(ui32()), nc: int(ui32()), stride: int(ui32()), enabled: true, rgb8: rgb8}
+		}
+		for i < len(cb.buf) {
+			switch cmd := ui32(); cmd {
+			case RendererLoadProjectionMatrix:
+				v.projection = float()
+				i += 15
+			case RendererLoadModelViewMatrix:
+				v.view = float()
+				i += 15
+			case RendererClearRGBA:
+				verts = append(verts, batchTestVertex{command: cmd, scissorEnabled: v.scissorEnabled,
+					scissor: v.scissor, rgba: [4]float32{float(), float(), float(), float()}})
+			case RendererScissor:
+				v.scissorEnabled, v.scissor = true, i4()
+			case RendererViewport:
+				v.viewport = i4()
+			case RendererBlend:
+				v.blend = true
+			case RendererDisableBlend:
+				v.blend = false
+			case RendererSetRGBA:
+				rgba = [4]float32{float(), float(), float(), float()}
+				color.enabled = false
+			case RendererFloatBuffer, RendererIntBuffer, RendererRawBuffer:
+				i += int(ui32())
+			case RendererEnableTexture:
+				v.texture = ui32()
+			case RendererDisableTexture:
+				v.texture = 0
+			case RendererVertexArray:
+				vertex = arr(false)
+			case RendererDisableVertexArray:
+				vertex.enabled = false
+			case RendererRGB32Array:
+				color = arr(false)
+			case RendererRGB8Array:
+				color = arr(true)
+			case RendererDisableColorArray:
+				color.enabled = false
+			case RendererTexCoordArray:
+				texCoord = arr(false)
+			case RendererDisableTexCoordArray:
+				texCoord.enabled = false
+			case RendererPointSize:
+				pointSize = float()
+			case RendererLineWidth:
+				lineWidth = float()
+			case RendererDrawPoints, RendererDrawLines, RendererDrawTriangles, RendererDrawQuads:
+				offset, count := int(ui32()), int(ui32())
+				for j := 0; j < count; j++ {
+					idx := int(cb.buf[offset/4+j])
+					d := v
+					d.command = cmd
+					if cmd == RendererDrawPoints {
+						d.width, d.blend = pointSize, true
+					} else if cmd == RendererDrawLines {
+						d.width = lineWidth
+					}
+					if !vertex.enabled {
+						t.Fatalf("draw without vertex array")
+					}
+					d.pos[0] = float32At(vertex.cb, vertex.offset+idx*vertex.stride)
+					d.pos[1] = float32At(vertex.cb, vertex.offset+idx*vertex.stride+4)
+					d.rgba = rgba
+					if color.enabled {
+						co := color.offset + idx*color.stride
+						if color.rgb8 {
+							c := uint32At(color.cb, co)
+							d.rgba = [4]float32{float32(c & 0xff), float32((c >> 8) & 0xff),
+								float32((c >> 16) & 0xff), float32(c >> 24)}
+						} else {
+							d.rgba = [4]float32{float32At(color.cb, co), float32At(color.cb, co+4),
+								float32At(color.cb, co+8), 1}
+						}
+					}
+					if texCoord.enabled && d.texture != 0 {
+						d.uv[0] = float32At(texCoord.cb, texCoord.offset+idx*texCoord.stride)
+						d.uv[1] = float32At(texCoord.cb, texCoord.offset+idx*texCoord.stride+4)
+					}
+					verts = append(verts, d)
+				}
+				if cmd == RendererDrawPoints {
+					v.blend = false
+				}
+			case RendererResetState:
+				v.scissorEnabled, v.blend, v.texture = false, false, 0
+				vertex.enabled, color.enabled, texCoord.enabled = false, false, false
+			case RendererCallBuffer:
+				render(&cb.called[ui32()])
+			default:
+				t.Fatalf("%d: unexpected command", cmd)
+			}
+		}
+	}
+	render(cb)
+	return verts
+}
+
+func TestBatchCommandBuffer(t *testing.T) {
+	quad := func(cb *CommandBuffer, x, y float32) {
+		p := cb.Float2Buffer([][2]float32{{x, y}, {x + 1, y}, {x + 1, y + 1}, {x, y + 1}})
+		ind := cb.IntBuffer([]int32{0, 1, 2, 0, 2, 3})
+		cb.VertexArray(p, 2, 2*4)
+		cb.DrawTriangles(ind, 6)
+	}
+	lines := func(cb *CommandBuffer, x, width float32, color RGB) {
+		p := cb.Float2Buffer([][2]float32{{x, 0}, {x, 10}, {x + 5, 10}})
+		ind := cb.IntBuffer([]int32{0, 1, 1, 2})
+		cb.appendInts(RendererLineWidth)
+		cb.appendFloats(width)
+		cb.SetRGB(color)
+		cb.VertexArray(p, 2, 2*4)
+		cb.DrawLines(ind, 4)
+	}
+
+	// A static buffer with per-vertex colors that leaves the color array
+	// enabled.
+	var static CommandBuffer
+	p := static.Float2Buffer([][2]float32{{0, 0}, {1, 1}})
+	c := static.RGBBuffer([]RGB{{1, 0, 0}, {0, 1, 0}})
+	ind := static.IntBuffer([]int32{0, 1})
+	static.VertexArray(p, 2, 2*4)
+	static.RGB32Array(c, 3, 3*4)
+	static.DrawLines(ind, 2)
+	static.MarkStatic()
+
+	var cb CommandBuffer
+	cb.ClearRGB(RGB{0.1, 0.1, 0.1})
+	cb.appendInts(RendererLoadProjectionMatrix)
+	cb.appendFloats(make([]float32, 16)...)
+	for pane := 0; pane < 3; pane++ {
+		cb.Scissor(pane*100, 0, 100, 100)
+		cb.Viewport(pane*100, 0, 100, 100)
+		cb.appendInts(RendererLoadModelViewMatrix)
+		cb.appendFloats(float32(pane), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+
+		// Several mergeable sets of lines, then some that differ.
+		for i := 0; i < 4; i++ {
+			lines(&cb, float32(i), 1, RGB{1, 1, 1})
+		}
+		lines(&cb, 10, 2, RGB{1, 1, 1})
+		lines(&cb, 11, 2, RGB{1, 0, 1})
+
+		// Triangles, some of them in called non-static buffers.
+		cb.SetRGBA(RGBA{0.5, 0.5, 0.5, 0.5})
+		cb.Blend()
+		quad(&cb, 0, 0)
+		var sub CommandBuffer
+		quad(&sub, 5, 5)
+		quad(&sub, 6, 6)
+		cb.Call(sub)
+		cb.DisableBlend()
+		quad(&cb, 7, 7)
+
+		if pane == 1 {
+			cb.Call(static)
+			// Draws using the current color after the static buffer
+			// enabled a color array.
+			cb.SetRGB(RGB{0, 0, 1})
+			quad(&cb, 8, 8)
+			// The arrays are all set again after this call.
+			cb.Call(static)
+		}
+
+		// Textured quads with per-vertex colors.
+		cb.EnableTexture(uint32(1 + pane%2))
+		for i := 0; i < 3; i++ {
+			p := cb.Float2Buffer([][2]float32{{0, 0}, {1, 0}, {1, 1}, {0, 1}})
+			uv := cb.Float2Buffer([][2]float32{{0, 0}, {1, 0}, {1, 1}, {0, 1}})
+			rgb := cb.RGBBuffer([]RGB{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 1}})
+			ind := cb.IntBuffer([]int32{0, 1, 2, 3})
+			cb.VertexArray(p, 2, 2*4)
+			cb.TexCoordArray(uv, 2, 2*4)
+			cb.RGB32Array(rgb, 3, 3*4)
+			cb.DrawQuads(ind, 4)
+		}
+		cb.ResetState()
+	}
+	// Something drawn after the scissor test has been disabled.
+	cb.SetRGB(RGB{1, 1, 0})
+	quad(&cb, 20, 20)
+
+	var batched CommandBuffer
+	merged, ok := BatchCommandBuffer(&cb, &batched)
+	if !ok {
+		t.Fatalf("batching failed")
+	}
+	if merged == 0 {
+		t.Errorf("no draws were merged")
+	}
+
+	expected, got := renderForTest(t, &cb), renderForTest(t, &batched)
+	if len(expected) != len(got) {
+		t.Fatalf("expected %d vertices, got %d", len(expected), len(got))
+	}
+	for i := range expected {
+		if expected[i] != got[i] {
+			t.Errorf("vertex %d: expected %+v, got %+v", i, expected[i], got[i])
+		}
+	}
+}
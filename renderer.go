@@ -24,6 +24,10 @@ type Renderer interface {
 	// the provided 8-big RGBA pixel values.
 	CreateRGBA8Texture(w, h int, rgba unsafe.Pointer) uint32
 
+	// UpdateRGBA8Texture replaces the contents of an existing texture
+	// with the provided 8-bit RGBA pixel values; its size may change.
+	UpdateRGBA8Texture(id uint32, w, h int, rgba unsafe.Pointer)
+
 	// CreateTextureFromImage returns an identifier for a texture map defined
 	// by the specified image.
 	CreateTextureFromImage(image image.Image, generateMIPs bool) uint32
@@ -46,11 +50,14 @@ type RendererStats struct {
 	nBuffers, bufferBytes               int
 	nDrawCalls                          int
 	nPoints, nLines, nTriangles, nQuads int
+	// Number of draw calls that were eliminated by BatchCommandBuffer.
+	nMergedDrawCalls int
 }
 
 func (rs *RendererStats) String() string {
-	return fmt.Sprintf("%d buffers (%.2f MB), %d draw calls: %d points, %d lines, %d tris, %d quads",
-		rs.nBuffers, float32(rs.bufferBytes)/(1024*1024), rs.nDrawCalls, rs.nPoints, rs.nLines, rs.nTriangles, rs.nQuads)
+	return fmt.Sprintf("%d buffers (%.2f MB), %d draw calls (%d merged): %d points, %d lines, %d tris, %d quads",
+		rs.nBuffers, float32(rs.bufferBytes)/(1024*1024), rs.nDrawCalls, rs.nMergedDrawCalls, rs.nPoints, rs.nLines,
+		rs.nTriangles, rs.nQuads)
 }
 
 func (rs *RendererStats) Merge(s RendererStats) {
@@ -61,6 +68,7 @@ func (rs *RendererStats) Merge(s RendererStats) {
 	rs.nLines += s.nLines
 	rs.nTriangles += s.nTriangles
 	rs.nQuads += s.nQuads
+	rs.nMergedDrawCalls += s.nMergedDrawCalls
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -119,6 +127,22 @@ const (
 type CommandBuffer struct {
 	buf    []uint32
 	called []CommandBuffer
+
+	// Non-nil if the CommandBuffer has been marked as static via
+	// MarkStatic.  It is a pointer so that all copies of the CommandBuffer
+	// (e.g., those made by Call) share it.
+	static *StaticBufferState
+}
+
+// StaticBufferState records the state of a Renderer's retained copy of the
+// contents of a static CommandBuffer.
+type StaticBufferState struct {
+	// Renderer-specific handle for its copy of the buffer; zero if it
+	// hasn't made one yet.
+	handle uint32
+	// Set if the CommandBuffer's contents have been modified since the
+	// Renderer made its copy.
+	dirty bool
 }
 
 // CommandBuffers are managed using a sync.Pool so that their buf slice
@@ -139,6 +163,28 @@ func ReturnCommandBuffer(cb *CommandBuffer) {
 func (cb *CommandBuffer) Reset() {
 	cb.buf = cb.buf[:0]
 	cb.called = cb.called[:0]
+	cb.static = nil
+}
+
+// MarkStatic indicates that the contents of the command buffer will not
+// change (other than in-place updates that are followed by a call to
+// InvalidateStatic), which allows the Renderer to retain its own copy of
+// its contents (e.g., in GPU memory) rather than uploading them each time
+// it is rendered.  Nothing may be added to a CommandBuffer after it has
+// been marked as static.
+func (cb *CommandBuffer) MarkStatic() {
+	if cb.static == nil && len(cb.buf) > 0 {
+		cb.static = &StaticBufferState{}
+	}
+}
+
+// InvalidateStatic must be called after the contents of a static
+// CommandBuffer are modified (e.g., via a slice returned by FloatSlice) so
+// that the Renderer updates its copy.
+func (cb *CommandBuffer) InvalidateStatic() {
+	if cb.static != nil {
+		cb.static.dirty = true
+	}
 }
 
 // growFor ensures that at least n more values can be added to the end of
@@ -557,8 +603,10 @@ func (l *LinesDrawBuilder) AddPolyline(p [2]float32, shape [][2]float32) {
 var (
 	// So that we can efficiently draw circles with various tessellations,
 	// circlePoints caches vertex positions of a unit circle at the origin
-	// for specified tessellation rates.
-	circlePoints map[int][][2]float32
+	// for specified tessellation rates. It may be accessed concurrently
+	// by Panes that are drawn in parallel.
+	circlePoints      map[int][][2]float32
+	circlePointsMutex sync.Mutex
 )
 
 // getCirclePoints returns the vertices for a unit circle at the origin
@@ -566,6 +614,9 @@ var (
 // tessellation rate hasn't been seen before and otherwise returns a
 // preexisting one.
 func getCirclePoints(nsegs int) [][2]float32 {
+	circlePointsMutex.Lock()
+	defer circlePointsMutex.Unlock()
+
 	if circlePoints == nil {
 		circlePoints = make(map[int][][2]float32)
 	}
@@ -893,6 +944,20 @@ func (t *TextBuffers) Add(p [2]float32, glyph *Glyph, color RGB) {
 	t.indices = append(t.indices, startIdx, startIdx+1, startIdx+2, startIdx+3)
 }
 
+// AddTranslated adds the glyphs stored in the provided TextBuffers,
+// offset by the given amount.
+func (t *TextBuffers) AddTranslated(from *TextBuffers, offset [2]float32) {
+	startIdx := int32(len(t.p))
+	for _, p := range from.p {
+		t.p = append(t.p, add2f(p, offset))
+	}
+	t.uv = append(t.uv, from.uv...)
+	t.rgb = append(t.rgb, from.rgb...)
+	for _, idx := range from.indices {
+		t.indices = append(t.indices, startIdx+idx)
+	}
+}
+
 func (t *TextBuffers) GenerateCommands(cb *CommandBuffer) {
 	if len(t.indices) == 0 {
 		return
@@ -1032,6 +1097,62 @@ func (td *TextDrawBuilder) AddTextMulti(text []string, p [2]float32, styles []Te
 	return [2]float32{px, py}
 }
 
+// TextLayout stores the glyph quads for a string of text drawn with a
+// given TextStyle, laid out with respect to the origin.  It allows text
+// that is drawn repeatedly but changes rarely (e.g., datablocks) to be
+// laid out once and then added to a TextDrawBuilder with just a
+// translation.
+type TextLayout struct {
+	text  string
+	style TextStyle
+	// Font atlas generation that the glyphs were laid out with; the glyph
+	// texture coordinates change when the atlas is rebuilt.
+	fontGeneration int
+	td             TextDrawBuilder
+	// Cursor position after the last character.
+	end [2]float32
+}
+
+// LayoutText returns a TextLayout for the given text and style.  If the
+// provided TextLayout is non-nil, it is reused: if it already holds the
+// layout for the text and style and the font atlas hasn't been rebuilt
+// since, it is returned as is, and otherwise it is laid out again.
+func LayoutText(l *TextLayout, text string, style TextStyle) *TextLayout {
+	if l == nil {
+		l = &TextLayout{}
+	} else if l.text == text && l.style == style && l.fontGeneration == fontAtlas.generation {
+		return l
+	} else {
+		l.td.Reset()
+	}
+
+	l.text, l.style, l.fontGeneration = text, style, fontAtlas.generation
+	l.end = l.td.AddText(text, [2]float32{0, 0}, style)
+	return l
+}
+
+// AddTextLayout draws the text stored in the given TextLayout using the
+// given position p as the upper-left corner.  The result is the same as
+// calling AddText with the layout's text and style.
+func (td *TextDrawBuilder) AddTextLayout(l *TextLayout, p [2]float32) [2]float32 {
+	// Round to the pixel, as AddTextMulti does.
+	p = [2]float32{float32(int(p[0] + 0.5)), float32(int(p[1] + 0.5))}
+
+	td.regular.AddTranslated(&l.td.regular, p)
+	td.shadow.AddTranslated(&l.td.shadow, p)
+
+	startIdx := int32(len(td.background.p))
+	for _, bp := range l.td.background.p {
+		td.background.p = append(td.background.p, add2f(bp, p))
+	}
+	td.background.rgb = append(td.background.rgb, l.td.background.rgb...)
+	for _, idx := range l.td.background.indices {
+		td.background.indices = append(td.background.indices, startIdx+idx)
+	}
+
+	return add2f(l.end, p)
+}
+
 func (td *TextDrawBuilder) Reset() {
 	td.regular.Reset()
 	td.shadow.Reset()
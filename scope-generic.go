@@ -48,6 +48,7 @@ type RadarScopePane struct {
 	RangeIndicatorStyle int
 	RangeLimits         RangeLimitList
 	rangeWarnings       map[AircraftPair]interface{}
+	conflictDetector    *ConflictDetector
 
 	AutoMIT         bool
 	AutoMITAirports map[string]interface{}
@@ -92,6 +93,9 @@ type AircraftScopeState struct {
 	datablockText            [2]string
 	datablockTextCurrent     bool
 	datablockBounds          Extent2D // w.r.t. lower-left corner (so (0,0) p0 always)
+	// Glyph layouts for datablockText; they are laid out again when the
+	// text or its style changes.
+	datablockLayouts [2]*TextLayout
 }
 
 // Takes aircraft position in window coordinates
@@ -137,6 +141,9 @@ func (rs *RadarScopePane) Duplicate(nameAsCopy bool) Pane {
 	dupe.StaticDraw = rs.StaticDraw.Duplicate()
 
 	dupe.rangeWarnings = DuplicateMap(rs.rangeWarnings)
+	dupe.conflictDetector = nil
+	// The WeatherRadar is activated separately for the copy.
+	dupe.WeatherRadar = WeatherRadar{}
 
 	dupe.aircraft = make(map[*Aircraft]*AircraftScopeState)
 	for ac, tracked := range rs.aircraft {
@@ -145,16 +152,19 @@ func (rs *RadarScopePane) Duplicate(nameAsCopy bool) Pane {
 			datablockText: tracked.datablockText}
 	}
 
-	dupe.ghostAircraft = make(map[*Aircraft]*Aircraft)
-	for ac, gh := range rs.ghostAircraft {
-		ghost := *gh // make a copy
-		dupe.ghostAircraft[ac] = &ghost
-	}
+	// The copy's ghosts have their own tracks and so are different
+	// aircraft; their states are moved to be keyed by them.
+	dupe.ghostAircraft = duplicateGhosts(rs.ghostAircraft, func(orig, ghost *Aircraft) {
+		if state, ok := dupe.aircraft[orig]; ok {
+			dupe.aircraft[ghost] = state
+			delete(dupe.aircraft, orig)
+		}
+	})
 	dupe.pointedOutAircraft = NewTransientMap[*Aircraft, string]()
 
 	dupe.AutoMITAirports = DuplicateMap(rs.AutoMITAirports)
 
-	dupe.eventsId = eventStream.Subscribe()
+	dupe.eventsId = eventStream.Subscribe(radarScopeEventTypes...)
 
 	return dupe
 }
@@ -175,7 +185,7 @@ func (rs *RadarScopePane) Activate() {
 		rs.LabelFontIdentifier = rs.labelFont.id
 	}
 
-	rs.eventsId = eventStream.Subscribe()
+	rs.eventsId = eventStream.Subscribe(radarScopeEventTypes...)
 
 	if rs.DrawWeather {
 		rs.WeatherRadar.Activate(rs.Center)
@@ -188,6 +198,7 @@ func (rs *RadarScopePane) Activate() {
 func (rs *RadarScopePane) initializeAircraft() {
 	// Reset and initialize all of these
 	rs.aircraft = make(map[*Aircraft]*AircraftScopeState)
+	releaseGhosts(rs.ghostAircraft)
 	rs.ghostAircraft = make(map[*Aircraft]*Aircraft)
 
 	for _, ac := range server.GetAllAircraft() {
@@ -207,6 +218,7 @@ func (rs *RadarScopePane) Deactivate() {
 
 	// Drop all of them
 	rs.aircraft = nil
+	releaseGhosts(rs.ghostAircraft)
 	rs.ghostAircraft = nil
 
 	eventStream.Unsubscribe(rs.eventsId)
@@ -234,7 +246,7 @@ func (rs *RadarScopePane) DrawUI() {
 			}
 		}
 		imgui.SliderIntV("Data block update frequency (seconds)", &rs.DatablockFrequency, 1, 10, "%d", 0 /* flags */)
-		imgui.SliderIntV("Tracks shown", &rs.RadarTracksDrawn, 1, 10, "%d", 0 /* flags */)
+		imgui.SliderIntV("Tracks shown", &rs.RadarTracksDrawn, 1, int32(trackHistoryLength), "%d", 0 /* flags */)
 		imgui.Checkbox("Vector lines", &rs.DrawVectorLine)
 		if rs.DrawVectorLine {
 			imgui.SliderFloatV("Vector line extent", &rs.VectorLineExtent, 0.1, 10, "%.1f", 0)
@@ -317,6 +329,11 @@ func (rs *RadarScopePane) DrawUI() {
 
 func (rs *RadarScopePane) CanTakeKeyboardFocus() bool { return false }
 
+// radarScopeEventTypes lists the events that the RadarScopePane handles
+// in processEvents.
+var radarScopeEventTypes = []EventType{AddedAircraftEventType, ModifiedAircraftEventType,
+	RemovedAircraftEventType, PointOutEventType}
+
 func (rs *RadarScopePane) processEvents(es *EventStream) {
 	for _, event := range es.Get(rs.eventsId) {
 		switch v := event.(type) {
@@ -332,25 +349,34 @@ func (rs *RadarScopePane) processEvents(es *EventStream) {
 		case *RemovedAircraftEvent:
 			if ghost, ok := rs.ghostAircraft[v.ac]; ok {
 				delete(rs.aircraft, ghost)
+				ghost.Tracks.Release()
 			}
 			delete(rs.aircraft, v.ac)
 			delete(rs.ghostAircraft, v.ac)
 
 		case *ModifiedAircraftEvent:
+			state, known := rs.aircraft[v.ac]
+			if !known {
+				rs.aircraft[v.ac] = &AircraftScopeState{}
+			} else {
+				state.datablockTextCurrent = false
+			}
+
+			// The ghost only depends on the aircraft's position and
+			// flight plan, so there's no need to update it otherwise.
+			if known && !v.Changed(AircraftTrackChanged|AircraftFlightPlanChanged) {
+				break
+			}
+
 			if rs.CRDAEnabled {
 				// always start out by removing the old ghost
 				if oldGhost, ok := rs.ghostAircraft[v.ac]; ok {
 					delete(rs.aircraft, oldGhost)
 					delete(rs.ghostAircraft, v.ac)
+					oldGhost.Tracks.Release()
 				}
 			}
 
-			if state, ok := rs.aircraft[v.ac]; !ok {
-				rs.aircraft[v.ac] = &AircraftScopeState{}
-			} else {
-				state.datablockTextCurrent = false
-			}
-
 			// new ghost
 			if rs.CRDAEnabled {
 				if ghost := rs.CRDAConfig.GetGhost(v.ac); ghost != nil {
@@ -365,9 +391,23 @@ func (rs *RadarScopePane) processEvents(es *EventStream) {
 	}
 }
 
-func (rs *RadarScopePane) Draw(ctx *PaneContext, cb *CommandBuffer) {
+func (rs *RadarScopePane) Dirty(ctx *PaneContext) bool {
+	return ctx.events.Pending(rs.eventsId) ||
+		(rs.DrawWeather && rs.WeatherIntensity > 0 && rs.WeatherRadar.updated)
+}
+
+func (rs *RadarScopePane) NextRedraw() time.Time {
+	return scopeNextRedraw()
+}
+
+// PrepareDraw processes new events on the main thread; the rest of the
+// RadarScopePane's drawing only reads shared state and may happen
+// concurrently with other Panes.
+func (rs *RadarScopePane) PrepareDraw(ctx *PaneContext) {
 	rs.processEvents(ctx.events)
+}
 
+func (rs *RadarScopePane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 	transforms := GetScopeTransformations(ctx, rs.Center, rs.Range, rs.RotationAngle)
 
 	if rs.DrawWeather && rs.WeatherIntensity > 0 {
@@ -560,7 +600,9 @@ func (rs *RadarScopePane) drawTracks(ctx *PaneContext, transforms ScopeTransform
 
 		// Draw in reverse order so that if it's not moving, more recent tracks (which will have
 		// more contrast with the background), will be the ones that are visible.
-		for i := rs.RadarTracksDrawn; i > 0; i-- {
+		for it := ac.Tracks.IterateOldestFirst(int(rs.RadarTracksDrawn)); it.Next(); {
+			i := it.Index() + 1
+
 			// blend the track color with the background color; more
 			// background further into history but only a 50/50 blend
 			// at the oldest track.
@@ -568,7 +610,7 @@ func (rs *RadarScopePane) drawTracks(ctx *PaneContext, transforms ScopeTransform
 			x := float32(i-1) / (1e-6 + float32(2*(rs.RadarTracksDrawn-1))) // 0 <= x <= 0.5
 			trackColor := lerpRGB(x, color, ctx.cs.Background)
 
-			p := ac.Tracks[i-1].Position
+			p := it.Track().Position
 			pw := transforms.WindowFromLatLongP(p)
 
 			px := float32(3) // TODO: make configurable?
@@ -994,13 +1036,15 @@ func (rs *RadarScopePane) drawDatablocks(ctx *PaneContext, transforms ScopeTrans
 
 		// Draw characters starting at the upper left.
 		flashCycle := (actualNow.Second() / int(rs.DatablockFrequency)) & 1
-		td.AddText(state.datablockText[flashCycle], [2]float32{bbox.p0[0], bbox.p1[1]},
-			TextStyle{
-				Font:            rs.datablockFont,
-				Color:           color,
-				DropShadow:      true,
-				DropShadowColor: ctx.cs.Background,
-				LineSpacing:     -2})
+		style := TextStyle{
+			Font:            rs.datablockFont,
+			Color:           color,
+			DropShadow:      true,
+			DropShadowColor: ctx.cs.Background,
+			LineSpacing:     -2}
+		state.datablockLayouts[flashCycle] = LayoutText(state.datablockLayouts[flashCycle],
+			state.datablockText[flashCycle], style)
+		td.AddTextLayout(state.datablockLayouts[flashCycle], [2]float32{bbox.p0[0], bbox.p1[1]})
 
 		// visualize bounds
 		if false {
@@ -1111,7 +1155,12 @@ func (rs *RadarScopePane) drawRangeIndicators(ctx *PaneContext, transforms Scope
 	aircraft, _ := FlattenMap(FilterMap(rs.aircraft, func(ac *Aircraft, state *AircraftScopeState) bool {
 		return !state.isGhost && !ac.LostTrack(now) && ac.Altitude() >= int(rs.MinAltitude) && ac.Altitude() <= int(rs.MaxAltitude)
 	}))
-	warnings, violations := GetConflicts(aircraft, rs.RangeLimits)
+	if rs.conflictDetector == nil {
+		rs.conflictDetector = &ConflictDetector{}
+	}
+	scope := profiler.Begin("conflicts", "conflicts", ctx.profileTrack)
+	warnings, violations := rs.conflictDetector.Update(aircraft, rs.RangeLimits)
+	scope.End()
 
 	// Reset it each frame
 	rs.rangeWarnings = make(map[AircraftPair]interface{})
@@ -87,6 +87,23 @@ type STARSPane struct {
 
 	selectedMapIndex        int
 	havePlayedSPCAlertSound map[*Aircraft]interface{}
+
+	// The radar sites that are currently used to determine aircraft
+	// visibility; these and visibilityGeneration are updated by
+	// updateRadarVisibility() whenever the radar sites or which of them
+	// are selected change.
+	visibilitySites      []starsRadarSiteVisibility
+	noRadarSites         bool
+	visibilityGeneration int
+	// What visibilitySites was computed from.
+	visibilityRadarSites   []STARSRadarSite
+	visibilitySelected     []bool
+	visibilityNmPerLatLong [2]float32
+	// The aircraft returned by visibleAircraft(); it's only computed
+	// again if aircraft have been added or removed, if an aircraft's
+	// track has changed, or if the visibility parameters have changed.
+	visibleAircraftList  []*Aircraft
+	visibleAircraftValid bool
 }
 
 type STARSRangeBearingLine struct {
@@ -137,9 +154,16 @@ type STARSAircraftState struct {
 
 	partialDatablockIfAssociated bool
 
-	datablockErrText    string
-	datablockText       [2][]string
+	datablockErrText string
+	datablockText    [2][]string
+	// The lines of datablockText joined with newlines; they are only
+	// joined again when the lines change.
+	datablockJoinedText [2]string
 	datablockDrawOffset [2]float32
+	// Glyph layouts for the datablock text, which are reused until the
+	// text or its style changes.
+	datablockLayouts   [2]*TextLayout
+	datablockErrLayout *TextLayout
 
 	// Only drawn if non-zero
 	jRingRadius    float32
@@ -158,6 +182,14 @@ type STARSAircraftState struct {
 	inhibitMSAWAlert      bool // only applies if in an alert. clear when alert is over?
 
 	spcOverride string
+
+	// Cached result of STARSPane radarVisibility() for the aircraft; it is
+	// valid if visibilityGeneration matches the STARSPane's.  It is reset
+	// to zero when the aircraft's track changes.
+	visibilityGeneration int
+	primaryVisible       bool
+	secondaryVisible     bool
+	radarDistance        float32
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -197,6 +229,12 @@ type STARSRadarSite struct {
 	SecondaryRange int32
 	SlopeAngle     float32
 	SilenceAngle   float32
+
+	// The resolved location of Position; see resolvePosition().
+	position           Point2LL
+	positionValid      bool
+	resolvedPosition   string
+	resolvedGeneration int
 }
 
 type STARSMap struct {
@@ -224,22 +262,68 @@ func MakeDefaultFacility() STARSFacility {
 	return f
 }
 
+// resolvePosition looks up the location of the radar site's Position,
+// caching the result so that the name doesn't need to be looked up
+// repeatedly when checking the visibility of each aircraft.  It is only
+// looked up again if Position changes or if the database's locations have
+// been reset.
+func (rs *STARSRadarSite) resolvePosition() {
+	if rs.resolvedPosition == rs.Position && rs.resolvedGeneration == database.LocationGeneration() {
+		return
+	}
+
+	id, generation := database.LookupLocationId(rs.Position)
+	rs.position, rs.positionValid = database.Location(id)
+	rs.resolvedPosition = rs.Position
+	rs.resolvedGeneration = generation
+}
+
 func (rs *STARSRadarSite) Valid() bool {
-	_, ok := database.Locate(rs.Position)
-	return rs.Char != "" && rs.Id != "" && rs.Position != "" && ok
+	rs.resolvePosition()
+	return rs.Char != "" && rs.Id != "" && rs.Position != "" && rs.positionValid
 }
 
 func (rs *STARSRadarSite) CheckVisibility(p Point2LL, altitude int) (primary, secondary bool, distance float32) {
-	// Check altitude first; this is a quick first cull that
-	// e.g. takes care of everyone on the ground.
-	if altitude < int(rs.Elevation) {
+	rs.resolvePosition()
+	if !rs.positionValid {
+		// Really, this method shouldn't be called if the site is invalid,
+		// but if it is, there's not much else we can do.
 		return
 	}
 
-	pRadar, ok := database.Locate(rs.Position)
-	if !ok {
-		// Really, this method shouldn't be called if the site is invalid,
-		// but if it is, there's not much else we can do.
+	v := rs.visibilityParameters()
+	return v.CheckVisibility(p, altitude)
+}
+
+// starsRadarSiteVisibility stores the values derived from a valid
+// STARSRadarSite that are needed to check the visibility of aircraft so
+// that they don't need to be recomputed for each one.
+type starsRadarSiteVisibility struct {
+	position  [2]float32 // nm
+	elevation int
+	altitude  float32 // nm
+	// Cosines of the angle from vertical of the cone of silence and of
+	// the slope angle.
+	cosSilence, cosSlope         float32
+	primaryRange, secondaryRange float32
+}
+
+func (rs *STARSRadarSite) visibilityParameters() starsRadarSiteVisibility {
+	return starsRadarSiteVisibility{
+		position:       ll2nm(rs.position),
+		elevation:      int(rs.Elevation),
+		altitude:       float32(rs.Elevation) * FeetToNauticalMiles,
+		cosSilence:     cos(radians(rs.SilenceAngle)),
+		cosSlope:       cos(radians(90 - rs.SlopeAngle)),
+		primaryRange:   float32(rs.PrimaryRange),
+		secondaryRange: float32(rs.SecondaryRange),
+	}
+}
+
+func (v *starsRadarSiteVisibility) CheckVisibility(p Point2LL, altitude int) (primary, secondary bool, distance float32) {
+	// Check altitude first; this is a quick first cull that
+	// e.g. takes care of everyone on the ground.
+	if altitude < v.elevation {
 		return
 	}
 
@@ -247,11 +331,9 @@ func (rs *STARSRadarSite) CheckVisibility(p Point2LL, altitude int) (primary, se
 	// since that's how we check the range anyway.
 	p = ll2nm(p)
 	palt := float32(altitude) * FeetToNauticalMiles
-	pRadar = ll2nm(pRadar)
-	ralt := float32(rs.Elevation) * FeetToNauticalMiles
 
-	dxy := sub2f(p, pRadar)
-	dalt := palt - ralt
+	dxy := sub2f(p, v.position)
+	dalt := palt - v.altitude
 	distance = sqrt(sqr(dxy[0]) + sqr(dxy[1]) + sqr(dalt))
 
 	// If we normalize the vector from the radar site to the aircraft, then
@@ -260,20 +342,19 @@ func (rs *STARSRadarSite) CheckVisibility(p Point2LL, altitude int) (primary, se
 	cosAngle := dalt / distance
 	// if angle < silence angle, we can't see it, but the test flips since
 	// we're testing cosines.
-	// FIXME: it's annoying to be repeatedly computing these cosines here...
-	if cosAngle > cos(radians(rs.SilenceAngle)) {
+	if cosAngle > v.cosSilence {
 		// inside the cone of silence
 		return
 	}
 	// similarly, if angle > 90-slope angle, we can't see it, but again the
 	// test flips.
-	if cosAngle < cos(radians(90-rs.SlopeAngle)) {
+	if cosAngle < v.cosSlope {
 		// below the slope angle
 		return
 	}
 
-	primary = distance <= float32(rs.PrimaryRange)
-	secondary = !primary && distance <= float32(rs.SecondaryRange)
+	primary = distance <= v.primaryRange
+	secondary = !primary && distance <= v.secondaryRange
 	return
 }
 
@@ -645,6 +726,10 @@ func (sp *STARSPane) Duplicate(nameAsCopy bool) Pane {
 
 	// Facility
 	dupe.Facility.Airports = DuplicateSlice(sp.Facility.Airports)
+	// The maps are copied before their StaticDrawConfigs are duplicated;
+	// otherwise both panes would share the duplicates, which are updated
+	// when the panes are drawn concurrently.
+	dupe.Facility.Maps = DuplicateSlice(sp.Facility.Maps)
 	for i := range sp.Facility.Maps {
 		dupe.Facility.Maps[i].Draw = sp.Facility.Maps[i].Draw.Duplicate()
 	}
@@ -655,24 +740,34 @@ func (sp *STARSPane) Duplicate(nameAsCopy bool) Pane {
 	}
 
 	// Internal state
+	dupe.weatherRadar = WeatherRadar{}
+	dupe.visibilitySites = nil
+	dupe.visibilityGeneration = 0
+	dupe.visibleAircraftList, dupe.visibleAircraftValid = nil, false
 	dupe.aircraft = make(map[*Aircraft]*STARSAircraftState)
 	for ac, tracked := range sp.aircraft {
 		dupe.aircraft[ac] = &STARSAircraftState{}
 		*dupe.aircraft[ac] = *tracked
+		// The text layouts are updated in place, so they can't be shared.
+		dupe.aircraft[ac].datablockLayouts = [2]*TextLayout{}
+		dupe.aircraft[ac].datablockErrLayout = nil
 	}
 
-	dupe.ghostAircraft = make(map[*Aircraft]*Aircraft)
-	for ac, gh := range sp.ghostAircraft {
-		ghost := *gh // make a copy
-		dupe.ghostAircraft[ac] = &ghost
-	}
+	// The copy's ghosts have their own tracks and so are different
+	// aircraft; their states are moved to be keyed by them.
+	dupe.ghostAircraft = duplicateGhosts(sp.ghostAircraft, func(orig, ghost *Aircraft) {
+		if state, ok := dupe.aircraft[orig]; ok {
+			dupe.aircraft[ghost] = state
+			delete(dupe.aircraft, orig)
+		}
+	})
 
 	dupe.havePlayedSPCAlertSound = DuplicateMap(sp.havePlayedSPCAlertSound)
 
 	dupe.pointedOutAircraft = NewTransientMap[*Aircraft, string]()
 	dupe.queryUnassociated = NewTransientMap[*Aircraft, interface{}]()
 
-	dupe.eventsId = eventStream.Subscribe()
+	dupe.eventsId = eventStream.Subscribe(starsEventTypes...)
 
 	return dupe
 }
@@ -710,10 +805,14 @@ func (sp *STARSPane) Activate() {
 		sp.UIFontIdentifier = sp.uiFont.id
 	}
 
-	sp.eventsId = eventStream.Subscribe()
+	sp.eventsId = eventStream.Subscribe(starsEventTypes...)
 
 	sp.weatherRadar.Activate(sp.currentPreferenceSet.Center)
 
+	for i := range sp.Facility.RadarSites {
+		sp.Facility.RadarSites[i].resolvePosition()
+	}
+
 	// start tracking all of the active aircraft
 	sp.initializeAircraft()
 }
@@ -725,7 +824,9 @@ func (sp *STARSPane) Deactivate() {
 
 	// Drop all of them
 	sp.aircraft = nil
+	releaseGhosts(sp.ghostAircraft)
 	sp.ghostAircraft = nil
+	sp.visibleAircraftList, sp.visibleAircraftValid = nil, false
 
 	eventStream.Unsubscribe(sp.eventsId)
 	sp.eventsId = InvalidEventSubscriberId
@@ -986,12 +1087,18 @@ func (sp *STARSPane) DrawUI() {
 
 func (sp *STARSPane) CanTakeKeyboardFocus() bool { return true }
 
+// starsEventTypes lists the events that the STARSPane handles in
+// processEvents.
+var starsEventTypes = []EventType{AddedAircraftEventType, ModifiedAircraftEventType,
+	RemovedAircraftEventType, PointOutEventType}
+
 func (sp *STARSPane) processEvents(es *EventStream) {
 	ps := sp.currentPreferenceSet
 
 	for _, event := range es.Get(sp.eventsId) {
 		switch v := event.(type) {
 		case *AddedAircraftEvent:
+			sp.visibleAircraftValid = false
 			sp.aircraft[v.ac] = &STARSAircraftState{}
 			if !ps.DisableCRDA {
 				if ghost := sp.Facility.CRDAConfig.GetGhost(v.ac); ghost != nil {
@@ -1011,32 +1118,48 @@ func (sp *STARSPane) processEvents(es *EventStream) {
 			}
 
 		case *RemovedAircraftEvent:
+			sp.visibleAircraftValid = false
 			if ghost, ok := sp.ghostAircraft[v.ac]; ok {
 				delete(sp.aircraft, ghost)
+				ghost.Tracks.Release()
 			}
 			delete(sp.aircraft, v.ac)
 			delete(sp.ghostAircraft, v.ac)
 
 		case *ModifiedAircraftEvent:
-			if squawkingSPC(v.ac.Squawk) {
+			if v.Changed(AircraftSquawkChanged) && squawkingSPC(v.ac.Squawk) {
 				if _, ok := sp.havePlayedSPCAlertSound[v.ac]; !ok {
 					sp.havePlayedSPCAlertSound[v.ac] = nil
 					globalConfig.AudioSettings.HandleEvent(AudioEventAlert)
 				}
 			}
 
+			state, known := sp.aircraft[v.ac]
+			if !known {
+				sp.aircraft[v.ac] = &STARSAircraftState{}
+				sp.visibleAircraftValid = false
+			} else if v.Changed(AircraftTrackChanged) {
+				// Its radar visibility needs to be checked again.
+				state.visibilityGeneration = 0
+				sp.visibleAircraftValid = false
+			}
+
+			// The ghost only depends on the aircraft's position and
+			// flight plan, so there's no need to update it otherwise.
+			if known && !v.Changed(AircraftTrackChanged|AircraftFlightPlanChanged) {
+				break
+			}
+			sp.visibleAircraftValid = false
+
 			if !ps.DisableCRDA {
 				// always start out by removing the old ghost
 				if oldGhost, ok := sp.ghostAircraft[v.ac]; ok {
 					delete(sp.aircraft, oldGhost)
 					delete(sp.ghostAircraft, v.ac)
+					oldGhost.Tracks.Release()
 				}
 			}
 
-			if _, ok := sp.aircraft[v.ac]; !ok {
-				sp.aircraft[v.ac] = &STARSAircraftState{}
-			}
-
 			// new ghost
 			if !ps.DisableCRDA {
 				if ghost := sp.Facility.CRDAConfig.GetGhost(v.ac); ghost != nil {
@@ -1051,16 +1174,42 @@ func (sp *STARSPane) processEvents(es *EventStream) {
 	}
 }
 
-func (sp *STARSPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
-	sp.processEvents(ctx.events)
+func (sp *STARSPane) Dirty(ctx *PaneContext) bool {
+	return ctx.events.Pending(sp.eventsId) || sp.weatherRadar.updated
+}
 
-	cb.ClearRGB(RGB{}) // clear to black, regardless of the color scheme
+func (sp *STARSPane) NextRedraw() time.Time {
+	return scopeNextRedraw()
+}
+
+// PrepareDraw handles everything that must happen on the main thread
+// before the STARSPane is drawn: processing events and keyboard input,
+// which may modify the server's state, and drawing the DCB, which uses
+// imgui.
+func (sp *STARSPane) PrepareDraw(ctx *PaneContext) {
+	sp.processEvents(ctx.events)
 
 	if ctx.mouse != nil && ctx.mouse.Clicked[MouseButtonPrimary] {
 		wmTakeKeyboardFocus(sp, false)
 	}
 	sp.processKeyboardInput(ctx)
 
+	for _, ap := range sp.Facility.Airports {
+		if ap.TowerListIndex != 0 {
+			server.AddAirportForWeather(ap.ICAOCode)
+		}
+	}
+
+	if sp.currentPreferenceSet.DisplayDCB {
+		transforms := GetScopeTransformations(ctx, sp.currentPreferenceSet.currentCenter,
+			float32(sp.currentPreferenceSet.Range), 0)
+		sp.DrawDCB(ctx, transforms)
+	}
+}
+
+func (sp *STARSPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
+	cb.ClearRGB(RGB{}) // clear to black, regardless of the color scheme
+
 	transforms := GetScopeTransformations(ctx, sp.currentPreferenceSet.currentCenter,
 		float32(sp.currentPreferenceSet.Range), 0)
 	ps := sp.currentPreferenceSet
@@ -1070,8 +1219,6 @@ func (sp *STARSPane) Draw(ctx *PaneContext, cb *CommandBuffer) {
 		p1: [2]float32{ctx.paneExtent.Width(), ctx.paneExtent.Height()}}
 
 	if ps.DisplayDCB {
-		sp.DrawDCB(ctx, transforms)
-
 		drawBounds.p1[1] -= STARSButtonHeight
 
 		// scissor so we can't draw in the DCB area
@@ -2791,12 +2938,6 @@ func (sp *STARSPane) DrawDCB(ctx *PaneContext, transforms ScopeTransformations)
 
 func (sp *STARSPane) drawSystemLists(aircraft []*Aircraft, ctx *PaneContext,
 	transforms ScopeTransformations, cb *CommandBuffer) {
-	for _, ap := range sp.Facility.Airports {
-		if ap.TowerListIndex != 0 {
-			server.AddAirportForWeather(ap.ICAOCode)
-		}
-	}
-
 	ps := sp.currentPreferenceSet
 
 	transforms.LoadWindowViewingMatrices(cb)
@@ -3255,7 +3396,7 @@ func (sp *STARSPane) drawTracks(aircraft []*Aircraft, ctx *PaneContext, transfor
 			box[i] = transforms.LatLongFromWindowP(box[i])
 		}
 		color := brightness.ScaleRGB(STARSTrackBlockColor)
-		if _, secondary, _ := sp.radarVisibility(ac.Position(), ac.Altitude()); secondary {
+		if _, secondary, _ := sp.radarVisibility(ac); secondary {
 			// If it's just a secondary return, only draw the box outline.
 			// TODO: is this 40nm, or secondary?
 			ld.AddPolyline([2]float32{}, color, box[:])
@@ -3317,7 +3458,13 @@ func (sp *STARSPane) drawTracks(aircraft []*Aircraft, ctx *PaneContext, transfor
 		// more contrast with the background), will be the ones that are visible.
 		histColor := ps.Brightness.History.ScaleRGB(STARSTrackHistoryColor)
 		n := ps.RadarTrackHistory
-		for i := n; i > 1; i-- {
+		for it := ac.Tracks.IterateOldestFirst(n); it.Next(); {
+			i := it.Index() + 1
+			if i == 1 {
+				// The current track is drawn separately.
+				continue
+			}
+
 			// blend the track color with the background color; more
 			// background further into history but only a 50/50 blend
 			// at the oldest track.
@@ -3325,9 +3472,7 @@ func (sp *STARSPane) drawTracks(aircraft []*Aircraft, ctx *PaneContext, transfor
 			x := float32(i-1) / (1e-6 + float32(2*(n-1))) // 0 <= x <= 0.5
 			trackColor := lerpRGB(x, histColor, STARSBackgroundColor)
 
-			p := ac.Tracks[i-1].Position
-
-			pd.AddPoint(p, trackColor)
+			pd.AddPoint(it.Track().Position, trackColor)
 		}
 	}
 
@@ -3340,6 +3485,24 @@ func (sp *STARSPane) drawTracks(aircraft []*Aircraft, ctx *PaneContext, transfor
 	td.GenerateCommands(cb)
 }
 
+// joinedLinesEqual reports whether joined is the result of joining the
+// given lines with newlines, without building the joined string.
+func joinedLinesEqual(lines []string, joined string) bool {
+	for i, line := range lines {
+		if i > 0 {
+			if len(joined) == 0 || joined[0] != '\n' {
+				return false
+			}
+			joined = joined[1:]
+		}
+		if !strings.HasPrefix(joined, line) {
+			return false
+		}
+		joined = joined[len(line):]
+	}
+	return joined == ""
+}
+
 func (sp *STARSPane) updateDatablockTextAndPosition(aircraft []*Aircraft) {
 	now := server.CurrentTime()
 	font := sp.systemFont[sp.currentPreferenceSet.CharSize.Datablocks]
@@ -3379,13 +3542,18 @@ func (sp *STARSPane) updateDatablockTextAndPosition(aircraft []*Aircraft) {
 			}
 		}
 
+		for i := 0; i < 2; i++ {
+			if !joinedLinesEqual(state.datablockText[i], state.datablockJoinedText[i]) {
+				state.datablockJoinedText[i] = strings.Join(state.datablockText[i], "\n")
+			}
+		}
+
 		// Compute the bounds of the datablock; it's fine to use just one of them here,.
-		var text []string
+		text := state.datablockJoinedText[0]
 		if state.datablockErrText != "" {
-			text = append(text, state.datablockErrText)
+			text = state.datablockErrText + "\n" + text
 		}
-		text = append(text, state.datablockText[0]...)
-		w, h := font.BoundText(strings.Join(text, "\n"), -2)
+		w, h := font.BoundText(text, -2)
 
 		// To place the datablock, start with the vector for the leader line.
 		state.datablockDrawOffset = sp.getLeaderLineVector(ac)
@@ -3594,7 +3762,7 @@ func (sp *STARSPane) drawDatablocks(aircraft []*Aircraft, ctx *PaneContext,
 
 		color := sp.datablockColor(ac)
 		style := TextStyle{Font: font, Color: color, DropShadow: true, LineSpacing: -2}
-		dbText := state.datablockText[now.Second()&1]
+		phase := now.Second() & 1
 
 		// Draw characters starting at the upper left.
 		pac := transforms.WindowFromLatLongP(ac.Position())
@@ -3604,9 +3772,13 @@ func (sp *STARSPane) drawDatablocks(aircraft []*Aircraft, ctx *PaneContext,
 				Font:        font,
 				Color:       ps.Brightness.FullDatablocks.ScaleRGB(STARSTextAlertColor),
 				LineSpacing: -2}
-			pt = td.AddText(state.datablockErrText+"\n", pt, errorStyle)
+			state.datablockErrLayout = LayoutText(state.datablockErrLayout, state.datablockErrText+"\n", errorStyle)
+			pt = td.AddTextLayout(state.datablockErrLayout, pt)
+		} else {
+			state.datablockErrLayout = nil
 		}
-		td.AddText(strings.Join(dbText, "\n"), pt, style)
+		state.datablockLayouts[phase] = LayoutText(state.datablockLayouts[phase], state.datablockJoinedText[phase], style)
+		td.AddTextLayout(state.datablockLayouts[phase], pt)
 
 		// Leader line
 		v := sp.getLeaderLineVector(ac)
@@ -3946,7 +4118,7 @@ func (sp *STARSPane) StartDrawDCB(ctx *PaneContext) {
 	//	imgui.WindowDrawList().AddRectFilledV(imgui.Vec2{}, imgui.Vec2{X: ctx.paneExtent.Width() - 2, Y: STARSButtonHeight},
 	//		0xff0000ff, 1, 0)
 
-	imgui.PushFont(sp.uiFont.ifont)
+	imgui.PushFont(sp.uiFont.ImguiFont())
 
 	imgui.PushStyleVarVec2(imgui.StyleVarItemSpacing, imgui.Vec2{1, 0})
 	imgui.PushStyleVarVec2(imgui.StyleVarFramePadding, imgui.Vec2{1, 1})
@@ -4123,7 +4295,9 @@ func (sp *STARSPane) initializeSystemFonts() {
 
 func (sp *STARSPane) initializeAircraft() {
 	// Reset and initialize all of these
+	sp.visibleAircraftValid = false
 	sp.aircraft = make(map[*Aircraft]*STARSAircraftState)
+	releaseGhosts(sp.ghostAircraft)
 	sp.ghostAircraft = make(map[*Aircraft]*Aircraft)
 
 	ps := sp.currentPreferenceSet
@@ -4151,68 +4325,100 @@ func (sp *STARSPane) resetInputState() {
 	sp.scopeClickHandler = nil
 }
 
-func (sp *STARSPane) noRadarDefined() bool {
-	for _, site := range sp.Facility.RadarSites {
-		if site.Valid() {
-			return false
-		}
+// updateRadarVisibility updates the radar site parameters used for
+// visibility checks if the radar sites or their selection have changed
+// since the last time it was called.
+func (sp *STARSPane) updateRadarVisibility() {
+	for i := range sp.Facility.RadarSites {
+		sp.Facility.RadarSites[i].resolvePosition()
 	}
-	return true
-}
 
-func (sp *STARSPane) radarVisibility(pos Point2LL, alt int) (primary, secondary bool, distance float32) {
-	if sp.noRadarDefined() {
-		return true, false, 0 // yolo
+	ps := &sp.currentPreferenceSet
+	nmPerLatLong := [2]float32{database.NmPerLatitude, database.NmPerLongitude}
+	if sp.visibilityGeneration != 0 && nmPerLatLong == sp.visibilityNmPerLatLong &&
+		SliceEqual(sp.Facility.RadarSites, sp.visibilityRadarSites) &&
+		SliceEqual(ps.RadarSiteSelected, sp.visibilitySelected) {
+		return
 	}
 
-	ps := sp.currentPreferenceSet
+	sp.visibilityRadarSites = DuplicateSlice(sp.Facility.RadarSites)
+	sp.visibilitySelected = DuplicateSlice(ps.RadarSiteSelected)
+	sp.visibilityNmPerLatLong = nmPerLatLong
+	sp.visibilityGeneration++
+	sp.visibleAircraftValid = false
+
+	sp.noRadarSites = true
+	sp.visibilitySites = sp.visibilitySites[:0]
 	multi := ps.multiRadarMode()
-	distance = 1e30
-	for i, sel := range ps.RadarSiteSelected {
-		if !sel && !multi {
+	for i := range sp.Facility.RadarSites {
+		site := &sp.Facility.RadarSites[i]
+		if !site.Valid() {
 			continue
 		}
+		sp.noRadarSites = false
 
-		site := sp.Facility.RadarSites[i]
-		if !site.Valid() {
-			continue
+		if multi || (i < len(ps.RadarSiteSelected) && ps.RadarSiteSelected[i]) {
+			sp.visibilitySites = append(sp.visibilitySites, site.visibilityParameters())
 		}
+	}
+}
+
+func (sp *STARSPane) radarVisibility(ac *Aircraft) (primary, secondary bool, distance float32) {
+	sp.updateRadarVisibility()
+	return sp.cachedRadarVisibility(ac)
+}
+
+// cachedRadarVisibility returns the aircraft's visibility, using the
+// cached result from a previous call if it is still valid.
+// updateRadarVisibility must have been called first.
+func (sp *STARSPane) cachedRadarVisibility(ac *Aircraft) (primary, secondary bool, distance float32) {
+	if sp.noRadarSites {
+		return true, false, 0 // yolo
+	}
+
+	state, ok := sp.aircraft[ac]
+	if ok && state.visibilityGeneration == sp.visibilityGeneration {
+		return state.primaryVisible, state.secondaryVisible, state.radarDistance
+	}
 
-		if p, s, dist := site.CheckVisibility(pos, alt); p || s {
+	pos, alt := ac.Position(), ac.Altitude()
+	distance = 1e30
+	for i := range sp.visibilitySites {
+		if p, s, dist := sp.visibilitySites[i].CheckVisibility(pos, alt); p || s {
 			primary = primary || p
 			secondary = secondary || s
 			distance = min(distance, dist)
 		}
 	}
 
+	if ok {
+		state.visibilityGeneration = sp.visibilityGeneration
+		state.primaryVisible, state.secondaryVisible, state.radarDistance = primary, secondary, distance
+	}
+
 	return
 }
 
+// visibleAircraft returns the aircraft that are visible to the radar
+// sites.  Callers may reorder the returned slice but must not otherwise
+// modify it.
 func (sp *STARSPane) visibleAircraft() []*Aircraft {
-	if sp.noRadarDefined() {
-		ac, _ := FlattenMap(sp.aircraft)
-		return ac
+	sp.updateRadarVisibility()
+	if sp.visibleAircraftValid {
+		return sp.visibleAircraftList
 	}
 
-	var aircraft []*Aircraft
-	ps := sp.currentPreferenceSet
-	multi := ps.multiRadarMode()
-
+	// Only the aircraft whose tracks have changed since the last time
+	// are checked again; the rest use their cached visibility.
+	sp.visibleAircraftList = sp.visibleAircraftList[:0]
 	for ac := range sp.aircraft {
-		for i, sel := range ps.RadarSiteSelected {
-			if !sel && !multi {
-				continue
-			}
-			site := sp.Facility.RadarSites[i]
-			if site.Valid() {
-				if p, s, _ := site.CheckVisibility(ac.Position(), ac.Altitude()); p || s {
-					aircraft = append(aircraft, ac)
-				}
-			}
+		if p, s, _ := sp.cachedRadarVisibility(ac); p || s {
+			sp.visibleAircraftList = append(sp.visibleAircraftList, ac)
 		}
 	}
+	sp.visibleAircraftValid = true
 
-	return aircraft
+	return sp.visibleAircraftList
 }
 
 func (sp *STARSPane) datablockVisible(ac *Aircraft) bool {
@@ -0,0 +1,388 @@
+// sector-cache.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+// This file implements an on-disk cache of the StaticDatabase contents
+// that are derived from a sector file.  Parsing a large sector file and
+// then triangulating its regions and generating the command buffers for
+// everything in it can take seconds; with the cache, all of that is only
+// done the first time a given version of a sector file is loaded.
+//
+// The cache for a sector file is stored in a single file in the user's
+// cache directory. Its layout is:
+//
+//   magic                  8 bytes
+//   sector file size       uint64
+//   sector file CRC32      uint32
+//   padding                4 bytes
+//   metadata size          uint64
+//   metadata               gob-encoded sectorFileCacheMetadata
+//   padding                to a multiple of 8 bytes
+//   geometry               uint32s
+//
+// The geometry section holds the contents of all of the CommandBuffers
+// for the StaticDrawables; after the cache is read, the CommandBuffers
+// refer directly to the memory it was read into so that the geometry
+// doesn't need to be decoded or copied.  (As such, the geometry is stored
+// in the host's byte order; caches aren't portable across systems, but
+// they don't need to be.)  The metadata holds everything else--the
+// names, bounds, and color indices of the StaticDrawables, the sector
+// file's navaids, and so forth--which is small in comparison.
+
+package main
+
+import (
+	"bytes"
+	"encoding/binary"
+	"encoding/gob"
+	"errors"
+	"fmt"
+	"hash/crc32"
+	"os"
+	"path/filepath"
+	"unsafe"
+)
+
+// sectorFileCacheMagic is at the start of all sector file cache files;
+// the final byte is the format version, which must be updated whenever
+// the layout of the cache or of any of the types stored in it changes
+// (including the encoding of commands in CommandBuffers).
+var sectorFileCacheMagic = []byte{'V', 'I', 'C', 'E', 'S', 'C', 'T', 1}
+
+const sectorFileCacheHeaderSize = 32
+
+var ErrCorruptSectorFileCache = errors.New("corrupt sector file cache")
+
+// sectorFileCacheMetadata stores everything derived from a sector file
+// other than the contents of the StaticDrawables' CommandBuffers.
+type sectorFileCacheMetadata struct {
+	// Absolute path of the sector file; this guards against collisions
+	// in the hash used for the cache's filename.
+	Filename string
+
+	DefaultAirport    string
+	DefaultCenter     Point2LL
+	NmPerLatitude     float32
+	NmPerLongitude    float32
+	MagneticVariation float32
+	SectorFileId      string
+
+	VORs, NDBs, Fixes, Airports map[string]Point2LL
+	Runways                     map[string][]Runway
+	Colors                      map[string]RGB
+
+	RunwayTiles, LowAirwayTiles, HighAirwayTiles []cachedStaticDrawable
+	Regions                                      []cachedStaticDrawable
+	ARTCC, ARTCCLow, ARTCCHigh                   []cachedStaticDrawable
+	Geos, GeosNoColor                            []cachedStaticDrawable
+	SIDs, STARs                                  []cachedStaticDrawable
+	SIDsNoColor, STARsNoColor                    []cachedStaticDrawable
+
+	LowAirwayLabels, HighAirwayLabels, Labels []cachedLabel
+	LabelColors                               cachedColorBufferIndex
+}
+
+// cachedStaticDrawable stores a StaticDrawable; its CommandBuffer's
+// contents are the given range of the geometry section.
+type cachedStaticDrawable struct {
+	Name           string
+	Offset, Length int
+	// Range of the CommandBuffer (in 32-bit words) that holds the RGB
+	// values, if any.
+	RGBOffset, RGBLength int
+	Bounds               [2][2]float32
+	Colors               cachedColorBufferIndex
+}
+
+type cachedColorBufferIndex struct {
+	M   map[string]int
+	Ids []int
+}
+
+type cachedLabel struct {
+	Name  string
+	P     Point2LL
+	Color RGB
+}
+
+func sectorFileCachePath(filename string) (string, error) {
+	abs, err := filepath.Abs(filename)
+	if err != nil {
+		return "", err
+	}
+	return cacheFilePath(fmt.Sprintf("sector-%08x.cache", crc32.ChecksumIEEE([]byte(abs))))
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Writing
+
+// sectorFileCacheWriter accumulates the StaticDrawables' geometry.
+type sectorFileCacheWriter struct {
+	geometry []uint32
+	err      error
+}
+
+func (w *sectorFileCacheWriter) addDrawables(sds []StaticDrawable) []cachedStaticDrawable {
+	var c []cachedStaticDrawable
+	for _, sd := range sds {
+		if len(sd.cb.called) > 0 {
+			// There's no way to represent these, though nothing in the
+			// sector file geometry currently calls other CommandBuffers.
+			w.err = errors.New("unable to cache CommandBuffer that calls other CommandBuffers")
+		}
+
+		csd := cachedStaticDrawable{
+			Name:   sd.name,
+			Offset: len(w.geometry),
+			Length: len(sd.cb.buf),
+			Bounds: [2][2]float32{sd.bounds.p0, sd.bounds.p1},
+			Colors: cachedColorBufferIndex{M: sd.colorBufferIndex.m, Ids: sd.colorBufferIndex.ids},
+		}
+		if len(sd.rgbSlice) > 0 {
+			// The RGB slice points into the CommandBuffer; find its offset.
+			start := uintptr(unsafe.Pointer(&sd.cb.buf[0]))
+			csd.RGBOffset = int((uintptr(unsafe.Pointer(&sd.rgbSlice[0])) - start) / 4)
+			csd.RGBLength = len(sd.rgbSlice)
+		}
+		w.geometry = append(w.geometry, sd.cb.buf...)
+		c = append(c, csd)
+	}
+	return c
+}
+
+func cachedLabels(labels []Label) []cachedLabel {
+	return MapSlice(labels, func(l Label) cachedLabel { return cachedLabel{Name: l.name, P: l.p, Color: l.color} })
+}
+
+// writeSectorFileCache writes a cache of the StaticDatabase's sector
+// file-derived contents for the given sector file.
+func (db *StaticDatabase) writeSectorFileCache(filename string, contents []byte) error {
+	fn, err := sectorFileCachePath(filename)
+	if err != nil {
+		return err
+	}
+	abs, err := filepath.Abs(filename)
+	if err != nil {
+		return err
+	}
+
+	w := &sectorFileCacheWriter{}
+	md := sectorFileCacheMetadata{
+		Filename:          abs,
+		DefaultAirport:    db.defaultAirport,
+		DefaultCenter:     db.defaultCenter,
+		NmPerLatitude:     db.NmPerLatitude,
+		NmPerLongitude:    db.NmPerLongitude,
+		MagneticVariation: db.MagneticVariation,
+		SectorFileId:      db.sectorFileId,
+		VORs:              db.VORs,
+		NDBs:              db.NDBs,
+		Fixes:             db.fixes,
+		Airports:          db.airports,
+		Runways:           db.runways,
+		Colors:            db.sectorFileColors,
+		RunwayTiles:       w.addDrawables(db.runwayTiles),
+		LowAirwayTiles:    w.addDrawables(db.lowAirwayTiles),
+		HighAirwayTiles:   w.addDrawables(db.highAirwayTiles),
+		Regions:           w.addDrawables(db.regions),
+		ARTCC:             w.addDrawables(db.ARTCC),
+		ARTCCLow:          w.addDrawables(db.ARTCCLow),
+		ARTCCHigh:         w.addDrawables(db.ARTCCHigh),
+		Geos:              w.addDrawables(db.geos),
+		GeosNoColor:       w.addDrawables(db.geosNoColor),
+		SIDs:              w.addDrawables(db.SIDs),
+		STARs:             w.addDrawables(db.STARs),
+		SIDsNoColor:       w.addDrawables(db.SIDsNoColor),
+		STARsNoColor:      w.addDrawables(db.STARsNoColor),
+		LowAirwayLabels:   cachedLabels(db.lowAirwayLabels),
+		HighAirwayLabels:  cachedLabels(db.highAirwayLabels),
+		Labels:            cachedLabels(db.labels),
+		LabelColors: cachedColorBufferIndex{M: db.labelColorBufferIndex.m,
+			Ids: db.labelColorBufferIndex.ids},
+	}
+	if w.err != nil {
+		return w.err
+	}
+
+	var metadata bytes.Buffer
+	if err := gob.NewEncoder(&metadata).Encode(md); err != nil {
+		return err
+	}
+
+	var buf bytes.Buffer
+	buf.Write(sectorFileCacheMagic)
+	var header [sectorFileCacheHeaderSize - 8]byte
+	binary.LittleEndian.PutUint64(header[0:], uint64(len(contents)))
+	binary.LittleEndian.PutUint32(header[8:], crc32.ChecksumIEEE(contents))
+	binary.LittleEndian.PutUint64(header[16:], uint64(metadata.Len()))
+	buf.Write(header[:])
+	buf.Write(metadata.Bytes())
+	for buf.Len()%8 != 0 {
+		buf.WriteByte(0)
+	}
+	if len(w.geometry) > 0 {
+		buf.Write(unsafe.Slice((*byte)(unsafe.Pointer(&w.geometry[0])), 4*len(w.geometry)))
+	}
+
+	return writeFileAtomically(fn, buf.Bytes())
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Reading
+
+// loadSectorFileCache initializes the StaticDatabase's sector
+// file-derived contents from the cache for the given sector file, if
+// there is one and it's up to date. It returns an error otherwise, in
+// which case the StaticDatabase is unchanged.
+func (db *StaticDatabase) loadSectorFileCache(filename string, contents []byte) error {
+	fn, err := sectorFileCachePath(filename)
+	if err != nil {
+		return err
+	}
+	abs, err := filepath.Abs(filename)
+	if err != nil {
+		return err
+	}
+
+	data, err := os.ReadFile(fn)
+	if err != nil {
+		return err
+	}
+
+	if len(data) < sectorFileCacheHeaderSize {
+		return ErrCorruptSectorFileCache
+	}
+	if !bytes.Equal(data[:len(sectorFileCacheMagic)], sectorFileCacheMagic) {
+		return errors.New("sector file cache has the wrong version")
+	}
+	header := data[len(sectorFileCacheMagic):]
+	if binary.LittleEndian.Uint64(header[0:]) != uint64(len(contents)) ||
+		binary.LittleEndian.Uint32(header[8:]) != crc32.ChecksumIEEE(contents) {
+		return errors.New("sector file has changed")
+	}
+
+	mdSize := binary.LittleEndian.Uint64(header[16:])
+	if mdSize > uint64(len(data)-sectorFileCacheHeaderSize) {
+		return ErrCorruptSectorFileCache
+	}
+	var md sectorFileCacheMetadata
+	mdBytes := data[sectorFileCacheHeaderSize : sectorFileCacheHeaderSize+mdSize]
+	if err := gob.NewDecoder(bytes.NewReader(mdBytes)).Decode(&md); err != nil {
+		return err
+	}
+	if md.Filename != abs {
+		return errors.New("sector file cache is for a different sector file")
+	}
+
+	// The geometry starts at the next multiple of 8 bytes. Note that
+	// os.ReadFile's buffer is sufficiently aligned for it to be accessed
+	// as uint32s.
+	geomStart := (sectorFileCacheHeaderSize + int(mdSize) + 7) &^ 7
+	if geomStart > len(data) || (len(data)-geomStart)%4 != 0 {
+		return ErrCorruptSectorFileCache
+	}
+	var geometry []uint32
+	if n := (len(data) - geomStart) / 4; n > 0 {
+		geometry = unsafe.Slice((*uint32)(unsafe.Pointer(&data[geomStart])), n)
+	}
+
+	// Validate and convert all of the StaticDrawables before touching
+	// the StaticDatabase.
+	var cacheErr error
+	drawables := func(cached []cachedStaticDrawable) []StaticDrawable {
+		var sds []StaticDrawable
+		for _, c := range cached {
+			if c.Offset < 0 || c.Length < 0 || c.Offset+c.Length > len(geometry) ||
+				c.RGBOffset < 0 || c.RGBLength < 0 || c.RGBOffset+c.RGBLength > c.Length {
+				cacheErr = ErrCorruptSectorFileCache
+				return nil
+			}
+
+			sd := StaticDrawable{
+				name:             c.Name,
+				bounds:           Extent2D{p0: c.Bounds[0], p1: c.Bounds[1]},
+				colorBufferIndex: ColorBufferIndex{m: c.Colors.M, ids: c.Colors.Ids},
+			}
+			// Limit the capacity so that nothing could append to one of
+			// these and clobber the following one.
+			sd.cb.buf = geometry[c.Offset : c.Offset+c.Length : c.Offset+c.Length]
+			if c.RGBLength > 0 {
+				sd.rgbSlice = sd.cb.FloatSlice(4*c.RGBOffset, c.RGBLength)
+			}
+			sds = append(sds, sd)
+		}
+		return sds
+	}
+	labels := func(cached []cachedLabel) []Label {
+		return MapSlice(cached, func(l cachedLabel) Label { return Label{name: l.Name, p: l.P, color: l.Color} })
+	}
+
+	runwayTiles := drawables(md.RunwayTiles)
+	lowAirwayTiles := drawables(md.LowAirwayTiles)
+	highAirwayTiles := drawables(md.HighAirwayTiles)
+	regions := drawables(md.Regions)
+	artcc := drawables(md.ARTCC)
+	artccLow := drawables(md.ARTCCLow)
+	artccHigh := drawables(md.ARTCCHigh)
+	geos := drawables(md.Geos)
+	geosNoColor := drawables(md.GeosNoColor)
+	sids := drawables(md.SIDs)
+	stars := drawables(md.STARs)
+	sidsNoColor := drawables(md.SIDsNoColor)
+	starsNoColor := drawables(md.STARsNoColor)
+	if cacheErr != nil {
+		return cacheErr
+	}
+
+	// gob leaves empty maps as nil; make sure that they're all allocated
+	// as they would be after parsing.
+	for _, m := range []*map[string]Point2LL{&md.VORs, &md.NDBs, &md.Fixes, &md.Airports} {
+		if *m == nil {
+			*m = make(map[string]Point2LL)
+		}
+	}
+	if md.Runways == nil {
+		md.Runways = make(map[string][]Runway)
+	}
+	if md.Colors == nil {
+		md.Colors = make(map[string]RGB)
+	}
+	if md.LabelColors.M == nil {
+		md.LabelColors.M = make(map[string]int)
+	}
+
+	db.defaultAirport = md.DefaultAirport
+	db.defaultCenter = md.DefaultCenter
+	db.NmPerLatitude = md.NmPerLatitude
+	db.NmPerLongitude = md.NmPerLongitude
+	db.MagneticVariation = md.MagneticVariation
+	db.sectorFileId = md.SectorFileId
+
+	db.VORs = md.VORs
+	db.NDBs = md.NDBs
+	db.fixes = md.Fixes
+	db.airports = md.Airports
+	db.runways = md.Runways
+	db.sectorFileColors = md.Colors
+
+	db.runwayTiles = runwayTiles
+	db.lowAirwayTiles = lowAirwayTiles
+	db.highAirwayTiles = highAirwayTiles
+	db.regions = regions
+	db.ARTCC = artcc
+	db.ARTCCLow = artccLow
+	db.ARTCCHigh = artccHigh
+	db.geos = geos
+	db.geosNoColor = geosNoColor
+	db.SIDs = sids
+	db.STARs = stars
+	db.SIDsNoColor = sidsNoColor
+	db.STARsNoColor = starsNoColor
+
+	db.lowAirwayLabels = labels(md.LowAirwayLabels)
+	db.highAirwayLabels = labels(md.HighAirwayLabels)
+	db.labels = labels(md.Labels)
+	db.labelColorBufferIndex = ColorBufferIndex{m: md.LabelColors.M, ids: md.LabelColors.Ids}
+
+	return nil
+}
@@ -33,15 +33,16 @@ var (
 		errorText     map[string]func() bool
 		menuBarHeight float32
 
-		showAboutDialog   bool
-		showRadarSettings bool
-		showFKeySettings  bool
-		showATISSettings  bool
-		showColorEditor   bool
-		showFilesEditor   bool
-		showServersEditor bool
-		showSoundConfig   bool
-		showRadioSettings bool
+		showAboutDialog    bool
+		showRadarSettings  bool
+		showFKeySettings   bool
+		showATISSettings   bool
+		showColorEditor    bool
+		showFilesEditor    bool
+		showServersEditor  bool
+		showSoundConfig    bool
+		showRadioSettings  bool
+		showReplayControls bool
 
 		iconTextureID     uint32
 		sadTowerTextureID uint32
@@ -207,7 +208,7 @@ func drawUI(cs *ColorScheme, platform Platform) {
 		}
 	}
 
-	imgui.PushFont(ui.font.ifont)
+	imgui.PushFont(ui.font.ImguiFont())
 	if imgui.BeginMainMenuBar() {
 		if imgui.BeginMenu("Connection") {
 			if imgui.MenuItemV("Connect...", "", false, !server.Connected()) {
@@ -216,6 +217,9 @@ func drawUI(cs *ColorScheme, platform Platform) {
 			if imgui.MenuItemV("Disconnect...", "", false, server.Connected()) {
 				uiShowModalDialog(NewModalDialogBox(&DisconnectModalClient{}), false)
 			}
+			if imgui.MenuItemV("Replay controls...", "", false, replayServer() != nil) {
+				ui.showReplayControls = true
+			}
 			imgui.EndMenu()
 		}
 
@@ -225,6 +229,9 @@ func drawUI(cs *ColorScheme, platform Platform) {
 					ShowErrorDialog("Error saving configuration file: %v", err)
 				}
 			}
+			if imgui.MenuItemV("Autosave", "", globalConfig.Autosave, true) {
+				globalConfig.Autosave = !globalConfig.Autosave
+			}
 			if imgui.MenuItem("Files...") {
 				ui.showFilesEditor = true
 			}
@@ -354,6 +361,16 @@ func drawActiveDialogBoxes() {
 }
 
 func drawActiveSettingsWindows() {
+	if ui.showReplayControls {
+		if v := replayServer(); v == nil {
+			ui.showReplayControls = false
+		} else {
+			imgui.BeginV("Replay Controls", &ui.showReplayControls, imgui.WindowFlagsAlwaysAutoResize)
+			drawReplayControls(v)
+			imgui.End()
+		}
+	}
+
 	if ui.showRadarSettings {
 		imgui.BeginV("Radar Settings", &ui.showRadarSettings, imgui.WindowFlagsAlwaysAutoResize)
 		positionConfig.DrawRadarUI()
@@ -794,7 +811,9 @@ type VATSIMReplayConfiguration struct {
 	filename string
 	rate     float32
 	offset   int32
-	dialog   *FileSelectDialogBox
+	// Replay as quickly as possible, ignoring the messages' timestamps.
+	unbounded bool
+	dialog    *FileSelectDialogBox
 }
 
 func (v *VATSIMReplayConfiguration) Initialize() {
@@ -817,8 +836,11 @@ func (v *VATSIMReplayConfiguration) DrawUI() bool {
 	}
 	v.dialog.Draw()
 
-	imgui.SliderFloatV("Playback rate multiplier", &v.rate, 0.1, 300, "%.1f",
-		imgui.SliderFlagsLogarithmic)
+	imgui.Checkbox("Replay as fast as possible", &v.unbounded)
+	if !v.unbounded {
+		imgui.SliderFloatV("Playback rate multiplier", &v.rate, 0.1, 300, "%.1f",
+			imgui.SliderFlagsLogarithmic)
+	}
 	imgui.InputIntV("Playback starting offset (seconds)", &v.offset, 0, 3600, 0)
 
 	return false
@@ -830,10 +852,57 @@ func (v *VATSIMReplayConfiguration) Valid() bool {
 
 func (v *VATSIMReplayConfiguration) Connect() error {
 	var err error
-	server, err = NewVATSIMReplayServer(v.filename, int(v.offset), v.rate)
+	rate := v.rate
+	if v.unbounded {
+		rate = 0
+	}
+	server, err = NewVATSIMReplayServer(v.filename, int(v.offset), rate)
 	return err
 }
 
+// replayServer returns the current server if it is replaying a recorded
+// VATSIM session and nil otherwise.
+func replayServer() *VATSIMServer {
+	if v, ok := server.(*VATSIMServer); ok && v.replayConnection() != nil {
+		return v
+	}
+	return nil
+}
+
+func drawReplayControls(v *VATSIMServer) {
+	rc := v.replayConnection()
+	start, end := rc.TimeRange()
+	now := v.CurrentTime()
+
+	imgui.Text(fmt.Sprintf("Session: %s - %s UTC", start.UTC().Format("15:04:05"),
+		end.UTC().Format("15:04:05")))
+	imgui.Text(fmt.Sprintf("Current time: %s UTC", now.UTC().Format("15:04:05")))
+
+	offset := int32(now.Sub(start).Seconds())
+	length := int32(end.Sub(start).Seconds())
+	if imgui.SliderIntV("Offset (seconds)", &offset, 0, length, "%d", 0 /* flags */) {
+		if err := v.SeekReplay(start.Add(time.Duration(offset) * time.Second)); err != nil {
+			ShowErrorDialog("Unable to seek: %v", err)
+		}
+	}
+
+	unbounded := rc.Rate() == 0
+	if imgui.Checkbox("Replay as fast as possible", &unbounded) {
+		if unbounded {
+			rc.SetRate(0)
+		} else {
+			rc.SetRate(1)
+		}
+	}
+	if !unbounded {
+		rate := rc.Rate()
+		if imgui.SliderFloatV("Playback rate multiplier", &rate, 0.1, 300, "%.1f",
+			imgui.SliderFlagsLogarithmic) {
+			rc.SetRate(rate)
+		}
+	}
+}
+
 type ConnectModalClient struct {
 	connectionType ConnectionType
 	err            string
@@ -1277,7 +1346,7 @@ func showAboutDialog() {
 		imgui.Text(s)
 	}
 
-	imgui.PushFont(ui.aboutFont.ifont)
+	imgui.PushFont(ui.aboutFont.ImguiFont())
 	center("vice: a client for VATSIM")
 	center(FontAwesomeIconCopyright + "2022 Matt Pharr")
 	center("Licensed under the GPL, Version 3")
@@ -1522,7 +1591,7 @@ func ShowFatalErrorDialog(s string, args ...interface{}) {
 		platform.ProcessEvents()
 		platform.NewFrame()
 		imgui.NewFrame()
-		imgui.PushFont(ui.font.ifont)
+		imgui.PushFont(ui.font.ImguiFont())
 		d.Draw()
 		imgui.PopFont()
 
@@ -8,6 +8,8 @@ import (
 	"fmt"
 	"golang.org/x/exp/constraints"
 	"math"
+	"os"
+	"path"
 	"sort"
 	"strconv"
 	"strings"
@@ -34,6 +36,65 @@ func decompressZstd(s string) string {
 	return string(b)
 }
 
+///////////////////////////////////////////////////////////////////////////
+// files
+
+// cacheFilePath returns the path to the file with the given name in
+// vice's directory in the user's cache directory.
+func cacheFilePath(name string) (string, error) {
+	dir, err := os.UserCacheDir()
+	if err != nil {
+		return "", err
+	}
+	return path.Join(dir, "Vice", name), nil
+}
+
+// writeFileAtomically writes the given contents to the specified file,
+// creating its directory if needed. The contents are first written to a
+// temporary file that is then renamed so that other instances of vice
+// never see a partially-written file.
+func writeFileAtomically(filename string, contents []byte) error {
+	dir := path.Dir(filename)
+	if err := os.MkdirAll(dir, 0o700); err != nil {
+		return err
+	}
+
+	// CreateTemp makes a file that only the user can read and write;
+	// keep the permissions of the existing file, if there is one, and
+	// otherwise use the usual ones for new files.
+	perm := os.FileMode(0o644)
+	if fi, err := os.Stat(filename); err == nil {
+		perm = fi.Mode().Perm()
+	}
+
+	f, err := os.CreateTemp(dir, path.Base(filename)+".*.tmp")
+	if err != nil {
+		return err
+	}
+	if _, err := f.Write(contents); err != nil {
+		f.Close()
+		os.Remove(f.Name())
+		return err
+	}
+	// Make sure the contents are on disk before the rename so that a
+	// crash can't leave an empty file in place of the old one.
+	if err := f.Sync(); err != nil {
+		f.Close()
+		os.Remove(f.Name())
+		return err
+	}
+	if err := f.Chmod(perm); err != nil {
+		f.Close()
+		os.Remove(f.Name())
+		return err
+	}
+	if err := f.Close(); err != nil {
+		os.Remove(f.Name())
+		return err
+	}
+	return os.Rename(f.Name(), filename)
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // text
 
@@ -409,6 +470,13 @@ func Overlaps(a Extent2D, b Extent2D) bool {
 	return x && y
 }
 
+// Union returns an Extent2D that bounds both of the provided Extent2Ds.
+func Union(a Extent2D, b Extent2D) Extent2D {
+	return Extent2D{
+		p0: [2]float32{min(a.p0[0], b.p0[0]), min(a.p0[1], b.p0[1])},
+		p1: [2]float32{max(a.p1[0], b.p1[0]), max(a.p1[1], b.p1[1])}}
+}
+
 // ClosestPointInBox returns the closest point to p that is inside the
 // Extent2D.  (If p is already inside it, then it is returned.)
 func (e Extent2D) ClosestPointInBox(p [2]float32) [2]float32 {
@@ -865,6 +933,44 @@ func FilterSlice[V any](s []V, pred func(V) bool) []V {
 	return filtered
 }
 
+// FilterSliceInPlace applies the given filter function pred to the given
+// slice, returning a slice that only contains elements where pred
+// returned true and that reuses the memory of the provided slice.
+func FilterSliceInPlace[V any](s []V, pred func(V) bool) []V {
+	filtered := s[:0]
+	for _, item := range s {
+		if pred(item) {
+			filtered = append(filtered, item)
+		}
+	}
+	return filtered
+}
+
+// MergeSortedSlices merges the slice b into the slice a, where both are
+// sorted according to less, and returns the result. Elements of a come
+// before equal elements of b.
+func MergeSortedSlices[V any](a, b []V, less func(V, V) bool) []V {
+	if len(b) == 0 {
+		return a
+	}
+
+	n := len(a)
+	a = append(a, b...)
+	// Merge from the back so that the unmerged elements of a are never
+	// overwritten.
+	i, j := n-1, len(b)-1
+	for k := len(a) - 1; j >= 0; k-- {
+		if i >= 0 && less(b[j], a[i]) {
+			a[k] = a[i]
+			i--
+		} else {
+			a[k] = b[j]
+			j--
+		}
+	}
+	return a
+}
+
 // Find returns the index of the first instance of the given value in the
 // slice or -1 if it is not present.
 func Find[V comparable](s []V, value V) int {
@@ -213,6 +213,31 @@ func TestFilterSlice(t *testing.T) {
 	}
 }
 
+func TestFilterSliceInPlace(t *testing.T) {
+	a := []int{1, 2, 3, 4, 5}
+	b := FilterSliceInPlace(a, func(i int) bool { return i%2 == 1 })
+	if len(b) != 3 || b[0] != 1 || b[1] != 3 || b[2] != 5 {
+		t.Errorf("filter odds failed: %+v", b)
+	}
+	if &a[0] != &b[0] {
+		t.Errorf("filtered slice doesn't reuse the original")
+	}
+}
+
+func TestMergeSortedSlices(t *testing.T) {
+	less := func(a, b int) bool { return a < b }
+	for _, test := range []struct{ a, b, expected []int }{
+		{nil, nil, nil},
+		{[]int{1, 3}, nil, []int{1, 3}},
+		{nil, []int{2}, []int{2}},
+		{[]int{1, 3, 5, 7}, []int{0, 3, 4, 8, 9}, []int{0, 1, 3, 3, 4, 5, 7, 8, 9}},
+	} {
+		if m := MergeSortedSlices(test.a, test.b, less); !SliceEqual(m, test.expected) {
+			t.Errorf("merge %+v %+v: expected %+v, got %+v", test.a, test.b, test.expected, m)
+		}
+	}
+}
+
 func TestFindSlice(t *testing.T) {
 	a := []int{0, 1, 2, 3, 4, 5}
 	for i := 0; i < 5; i++ {
@@ -102,8 +102,9 @@ func handleAR(v *VATSIMServer, sender string, args []string) error {
 	return nil
 }
 
-// Flightplan
-func handleFP(v *VATSIMServer, sender string, args []string) error {
+// Flightplan; decodeFP does all of the parsing, independently of the
+// VATSIMServer, so that it can be done as messages are received.
+func decodeFP(sender string, args []string) (interface{}, error) {
 	var fp FlightPlan
 
 	switch args[2] {
@@ -116,34 +117,34 @@ func handleFP(v *VATSIMServer, sender string, args []string) error {
 	case "S":
 		fp.Rules = SVFR
 	default:
-		return MalformedMessageError{"Unexpected flight rules: " + args[2]}
+		return nil, MalformedMessageError{"Unexpected flight rules: " + args[2]}
 	}
 
 	fp.AircraftType = args[3]
 
 	var err error
 	if fp.CruiseSpeed, err = strconv.Atoi(args[4]); err != nil {
-		return MalformedMessageError{"Unable to parse cruise airspeed: " + args[4]}
+		return nil, MalformedMessageError{"Unable to parse cruise airspeed: " + args[4]}
 	}
 
 	fp.DepartureAirport = args[5]
 
 	if fp.DepartTimeEst, err = strconv.Atoi(args[6]); err != nil {
-		return MalformedMessageError{"Unable to parse departTime: " + args[6]}
+		return nil, MalformedMessageError{"Unable to parse departTime: " + args[6]}
 	}
 	if fp.DepartTimeActual, err = strconv.Atoi(args[7]); err != nil {
-		return MalformedMessageError{"Unable to parse departTime: " + args[7]}
+		return nil, MalformedMessageError{"Unable to parse departTime: " + args[7]}
 	}
 
 	if args[8] != "" {
 		if strings.HasPrefix(strings.ToUpper(args[8]), "FL") {
 			if alt, err := strconv.Atoi(args[8][2:]); err != nil {
-				return MalformedMessageError{"Unable to parse altitude: " + args[8]}
+				return nil, MalformedMessageError{"Unable to parse altitude: " + args[8]}
 			} else {
 				fp.Altitude = alt * 100
 			}
 		} else if alt, err := strconv.Atoi(args[8]); err != nil {
-			return MalformedMessageError{"Unable to parse altitude: " + args[8]}
+			return nil, MalformedMessageError{"Unable to parse altitude: " + args[8]}
 		} else {
 			fp.Altitude = alt
 		}
@@ -152,24 +153,29 @@ func handleFP(v *VATSIMServer, sender string, args []string) error {
 	fp.ArrivalAirport = args[9]
 
 	if fp.Hours, err = strconv.Atoi(args[10]); err != nil {
-		return MalformedMessageError{"Unable to parse enroute hours: " + args[10]}
+		return nil, MalformedMessageError{"Unable to parse enroute hours: " + args[10]}
 	}
 	if fp.Minutes, err = strconv.Atoi(args[11]); err != nil {
-		return MalformedMessageError{"Unable to parse enroute minutes: " + args[11]}
+		return nil, MalformedMessageError{"Unable to parse enroute minutes: " + args[11]}
 	}
 	if fp.FuelHours, err = strconv.Atoi(args[12]); err != nil {
-		return MalformedMessageError{"Unable to parse fuel hours: " + args[12]}
+		return nil, MalformedMessageError{"Unable to parse fuel hours: " + args[12]}
 	}
 	if fp.FuelMinutes, err = strconv.Atoi(args[13]); err != nil {
-		return MalformedMessageError{"Unable to parse fuel minutes: " + args[13]}
+		return nil, MalformedMessageError{"Unable to parse fuel minutes: " + args[13]}
 	}
 
 	fp.AlternateAirport = args[14]
 	fp.Remarks = args[15]
 	fp.Route = args[16]
 
-	ac := v.getOrCreateAircraft(sender)
-	ac.FlightPlan = &fp
+	return &fp, nil
+}
+
+func applyFP(v *VATSIMServer, sender string, decoded interface{}) error {
+	fp := decoded.(*FlightPlan)
+	ac := v.getOrCreateAircraft(sender, AircraftFlightPlanChanged)
+	ac.FlightPlan = fp
 
 	if strings.Contains(fp.Remarks, "/v/") || strings.Contains(fp.Remarks, "/V/") {
 		ac.VoiceCapability = VoiceFull
@@ -186,7 +192,7 @@ func handleFP(v *VATSIMServer, sender string, args []string) error {
 // $HAABE_TWR:ABE_APP:N11TV
 func handleHA(v *VATSIMServer, sender string, args []string) error {
 	from, callsign := args[1], args[2]
-	ac := v.getOrCreateAircraft(callsign)
+	ac := v.getOrCreateAircraft(callsign, AircraftOtherChanged)
 
 	if ac.TrackingController != from {
 		lg.Printf("%s: %s is tracking but %s accepted h/o from %s?", callsign, ac.TrackingController,
@@ -209,7 +215,7 @@ func handleHA(v *VATSIMServer, sender string, args []string) error {
 func handleHO(v *VATSIMServer, sender string, args []string) error {
 	receiver, callsign := args[1], args[2]
 	if receiver == v.callsign {
-		ac := v.getOrCreateAircraft(callsign)
+		ac := v.getOrCreateAircraft(callsign, AircraftOtherChanged)
 		ac.InboundHandoffController = sender
 		eventStream.Post(&OfferedHandoffEvent{controller: sender, ac: ac})
 	}
@@ -252,9 +258,18 @@ func handleTM(v *VATSIMServer, sender string, args []string) error {
 	return nil
 }
 
+// vatsimPositionReport stores the decoded fields of an aircraft update
+// message.
+type vatsimPositionReport struct {
+	callsign string
+	squawk   Squawk
+	mode     TransponderMode
+	track    RadarTrack // Time is set when the report is applied
+}
+
 // Aircraft update
 // @(mode):(callsign):(squawk):(rating):(lat):(lon):(alt):(groundspeed):(num1):(num2)
-func handleAt(v *VATSIMServer, trmode string, args []string) error {
+func decodeAt(trmode string, args []string) (interface{}, error) {
 	callsign := args[1]
 
 	var mode TransponderMode
@@ -266,12 +281,12 @@ func handleAt(v *VATSIMServer, trmode string, args []string) error {
 	case "Y":
 		mode = Ident
 	default:
-		return MalformedMessageError{"Unexpected squawk type: " + args[0]}
+		return nil, MalformedMessageError{"Unexpected squawk type: " + args[0]}
 	}
 
 	squawk, err := ParseSquawk(args[2])
 	if err != nil {
-		return err
+		return nil, err
 	}
 
 	var altitude, groundspeed int
@@ -279,23 +294,23 @@ func handleAt(v *VATSIMServer, trmode string, args []string) error {
 
 	latlong, err := parseLatitudeLongitude(args[4], args[5])
 	if err != nil {
-		return err
+		return nil, err
 	}
 
 	if altitude, err = strconv.Atoi(args[6]); err != nil {
-		return MalformedMessageError{"Error parsing altitude in update: " + args[6]}
+		return nil, MalformedMessageError{"Error parsing altitude in update: " + args[6]}
 	}
 	if groundspeed, err = strconv.Atoi(args[7]); err != nil {
-		return MalformedMessageError{"Error parsing ground speed in update: " + args[7]}
+		return nil, MalformedMessageError{"Error parsing ground speed in update: " + args[7]}
 	}
 	if surfaces, err = strconv.ParseUint(args[8], 10, 64); err != nil {
-		return MalformedMessageError{"Error parsing flight surfaces in update: " + args[8]}
+		return nil, MalformedMessageError{"Error parsing flight surfaces in update: " + args[8]}
 	}
 	if _, err = strconv.Atoi(args[9]); err != nil {
 		// args[9] is a pressure delta: altitude + pressure gives pressure
 		// altitude (currently ignored--is this what we should be reporting
 		// on the scope, though?)
-		return MalformedMessageError{"Error parsing pressure in update: " + args[9]}
+		return nil, MalformedMessageError{"Error parsing pressure in update: " + args[9]}
 	}
 
 	// Decode flight surfaces; we ignore pitch and bank and just grab heading
@@ -307,15 +322,37 @@ func handleAt(v *VATSIMServer, trmode string, args []string) error {
 		heading -= 360
 	}
 
-	ac := v.getOrCreateAircraft(callsign)
-	ac.Squawk = squawk
-	ac.Mode = mode
-	ac.AddTrack(RadarTrack{
-		Position:    latlong,
-		Altitude:    int(altitude),
-		Groundspeed: int(groundspeed),
-		Heading:     heading,
-		Time:        v.CurrentTime()})
+	return &vatsimPositionReport{
+		callsign: callsign,
+		squawk:   squawk,
+		mode:     mode,
+		track: RadarTrack{
+			Position:    latlong,
+			Altitude:    int(altitude),
+			Groundspeed: int(groundspeed),
+			Heading:     heading,
+		}}, nil
+}
+
+func applyAt(v *VATSIMServer, trmode string, decoded interface{}) error {
+	report := decoded.(*vatsimPositionReport)
+
+	changes := AircraftTrackChanged
+	if ac, ok := v.aircraft[report.callsign]; ok {
+		if ac.Squawk != report.squawk {
+			changes |= AircraftSquawkChanged
+		}
+		if ac.Mode != report.mode {
+			changes |= AircraftOtherChanged
+		}
+	}
+
+	ac := v.getOrCreateAircraft(report.callsign, changes)
+	ac.Squawk = report.squawk
+	ac.Mode = report.mode
+	track := report.track
+	track.Time = v.CurrentTime()
+	ac.AddTrack(track)
 
 	return nil
 }
@@ -416,7 +453,7 @@ func (v *VATSIMServer) altitudeAssigned(strs []string, csIndex int, altIndex int
 	if alt, err := strconv.Atoi(strs[altIndex]); err != nil {
 		return MalformedMessageError{"invalid altitude: " + strs[altIndex]}
 	} else if ac := v.GetAircraft(callsign); ac != nil && ac.FlightPlan != nil {
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftFlightPlanChanged})
 		ac.FlightPlan.Altitude = alt
 	}
 	return nil
@@ -431,7 +468,7 @@ func (v *VATSIMServer) temporaryAltitudeAssigned(strs []string, csIndex int, alt
 	if alt, err := strconv.Atoi(strs[altIndex]); err != nil {
 		return MalformedMessageError{"invalid temporary altitude: " + strs[altIndex]}
 	} else {
-		ac := v.getOrCreateAircraft(callsign)
+		ac := v.getOrCreateAircraft(callsign, AircraftOtherChanged)
 		ac.TempAltitude = alt
 		return nil
 	}
@@ -446,7 +483,7 @@ func (v *VATSIMServer) squawkCodeAssigned(strs []string, csIndex int, sqIndex in
 	if squawk, err := ParseSquawk(strs[sqIndex]); err != nil {
 		return err
 	} else {
-		ac := v.getOrCreateAircraft(callsign)
+		ac := v.getOrCreateAircraft(callsign, AircraftSquawkChanged)
 		ac.AssignedSquawk = squawk
 		return nil
 	}
@@ -458,7 +495,7 @@ func (v *VATSIMServer) scratchpadSet(strs []string, csIndex int, spIndex int) er
 	}
 
 	callsign := strs[csIndex]
-	ac := v.getOrCreateAircraft(callsign)
+	ac := v.getOrCreateAircraft(callsign, AircraftScratchpadChanged)
 	ac.Scratchpad = strs[spIndex]
 	return nil
 }
@@ -469,7 +506,7 @@ func (v *VATSIMServer) voiceTypeSet(strs []string, csIndex int, vtIndex int) err
 	}
 
 	callsign := strs[csIndex]
-	ac := v.getOrCreateAircraft(callsign)
+	ac := v.getOrCreateAircraft(callsign, AircraftOtherChanged)
 	switch strs[vtIndex] {
 	case "v":
 		ac.VoiceCapability = VoiceFull
@@ -495,7 +532,7 @@ func init() {
 
 	r(NewMessageSpec("%", 6, handlePct))
 
-	r(NewMessageSpec("@", 10, handleAt))
+	r(NewDecodingMessageSpec("@", 10, decodeAt, applyAt))
 
 	r(NewMessageSpec("#AA", 7, handleAA))
 
@@ -525,7 +562,7 @@ func init() {
 
 	r(NewMessageSpec("$CQ::DR", 4, func(v *VATSIMServer, sender string, args []string) error {
 		callsign := args[3]
-		ac := v.getOrCreateAircraft(callsign)
+		ac := v.getOrCreateAircraft(callsign, AircraftOtherChanged)
 
 		if ac.TrackingController != sender {
 			lg.Printf("%s: %s dropped track but currently tracked by %s", callsign, sender,
@@ -558,7 +595,7 @@ func init() {
 
 	r(NewMessageSpec("$CQ::HT", 5, func(v *VATSIMServer, sender string, args []string) error {
 		callsign := args[3]
-		ac := v.getOrCreateAircraft(callsign)
+		ac := v.getOrCreateAircraft(callsign, AircraftOtherChanged)
 		ac.TrackingController = sender
 		if ac.OutboundHandoffController != "" {
 			ac.OutboundHandoffController = ""
@@ -693,6 +730,7 @@ func init() {
 	r(NewMessageSpec("#DP", 2, func(v *VATSIMServer, callsign string, args []string) error {
 		if ac := v.GetAircraft(callsign); ac != nil {
 			eventStream.Post(&RemovedAircraftEvent{ac: ac})
+			ac.Tracks.Release()
 		}
 		delete(v.aircraft, callsign)
 		delete(v.pilots, callsign)
@@ -700,7 +738,7 @@ func init() {
 		return nil
 	}))
 
-	r(NewMessageSpec("$FP", 17, handleFP))
+	r(NewDecodingMessageSpec("$FP", 17, decodeFP, applyFP))
 
 	r(NewMessageSpec("$HA", 3, handleHA))
 
@@ -719,7 +757,7 @@ func init() {
 
 	r(NewMessageSpec("#PC::CCP:HC", 5, func(v *VATSIMServer, sender string, args []string) error {
 		callsign := args[4]
-		ac := v.getOrCreateAircraft(callsign)
+		ac := v.getOrCreateAircraft(callsign, AircraftOtherChanged)
 		if ac.OutboundHandoffController != "" {
 			ac.OutboundHandoffController = ""
 			eventStream.Post(&RejectedHandoffEvent{controller: sender, ac: ac})
@@ -739,7 +777,7 @@ func init() {
 	r(NewMessageSpec("#PC::CCP:PT", 5, func(v *VATSIMServer, sender string, args []string) error {
 		if args[1] == v.callsign {
 			callsign := args[4]
-			ac := v.getOrCreateAircraft(callsign)
+			ac := v.getOrCreateAircraft(callsign, AircraftOtherChanged)
 			eventStream.Post(&PointOutEvent{controller: sender, ac: ac})
 		}
 		return nil
@@ -59,6 +59,10 @@ func (m MalformedMessageError) Error() string {
 	return m.Err
 }
 
+// vatsimUpdateTimeBudget is the maximum amount of time that GetUpdates
+// spends handling received messages each time it is called.
+const vatsimUpdateTimeBudget = 4 * time.Millisecond
+
 var (
 	// We maintain these as global variables so that they can be
 	// initialized by init() functions when we compile with the secret
@@ -93,6 +97,17 @@ type VATSIMServer struct {
 	airportsForWeather map[string]interface{}
 
 	atcValid bool
+
+	dispatcher *VATSIMMessageDispatcher
+	// Messages that have been received but not yet handled.
+	backlog []VATSIMMessage
+	// Reused across messages to avoid allocating when splitting them
+	// into fields.
+	fields []string
+
+	// When replaying a session, snapshots of the server's state taken at
+	// regular intervals, sorted by message index.
+	replaySnapshots []*vatsimServerSnapshot
 }
 
 func NewVATSIMServer() *VATSIMServer {
@@ -106,6 +121,9 @@ func NewVATSIMServer() *VATSIMServer {
 		users:              make(map[string]*User),
 		pilots:             make(map[string]*Pilot),
 		airportsForWeather: make(map[string]interface{}),
+		// All of the specs have been registered by init() functions by
+		// the time we get here.
+		dispatcher: NewVATSIMMessageDispatcher(vatsimMessageSpecs),
 	}
 }
 
@@ -114,7 +132,7 @@ func NewVATSIMNetworkServer(address string) (*VATSIMServer, error) {
 	v.callsign = positionConfig.VatsimCallsign
 
 	var err error
-	if v.connection, err = NewVATSIMNetConnection(address); err != nil {
+	if v.connection, err = NewVATSIMNetConnection(address, v.dispatcher); err != nil {
 		return nil, err
 	}
 	v.controlDelegate = makeVatsimAircraftController(v)
@@ -139,12 +157,21 @@ func NewVATSIMReplayServer(filename string, offsetSeconds int, replayRate float3
 	v.callsign = "(none)"
 	v.controlDelegate = &InertAircraftController{}
 
-	var err error
-	if v.connection, err = NewVATSIMReplayConnection(filename, offsetSeconds, replayRate); err != nil {
+	rc, err := NewVATSIMReplayConnection(filename, replayRate)
+	if err != nil {
 		return nil, err
-	} else {
-		return v, nil
 	}
+	v.connection = rc
+
+	if offsetSeconds > 0 {
+		// Apply the messages before the offset right away so that
+		// flight plans, squawk codes, controllers, etc., that were sent
+		// earlier in the session are all there at the start.
+		if err := v.SeekReplay(rc.streamStart.Add(time.Duration(offsetSeconds) * time.Second)); err != nil {
+			return nil, err
+		}
+	}
+	return v, nil
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -253,7 +280,7 @@ func (v *VATSIMServer) SetSquawk(callsign string, code Squawk) error {
 		return ErrOtherControllerHasTrack
 	} else {
 		ac.AssignedSquawk = code
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftSquawkChanged})
 		return v.controlDelegate.SetSquawk(callsign, code)
 	}
 }
@@ -315,7 +342,7 @@ func (v *VATSIMServer) SetScratchpad(callsign string, scratchpad string) error {
 		return ErrScratchpadTooLong
 	} else {
 		ac.Scratchpad = scratchpad
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftScratchpadChanged})
 		return v.controlDelegate.SetScratchpad(callsign, scratchpad)
 	}
 }
@@ -329,7 +356,7 @@ func (v *VATSIMServer) SetTemporaryAltitude(callsign string, altitude int) error
 		return ErrOtherControllerHasTrack
 	} else {
 		ac.TempAltitude = altitude
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftOtherChanged})
 		return v.controlDelegate.SetTemporaryAltitude(callsign, altitude)
 	}
 }
@@ -384,7 +411,7 @@ func (v *VATSIMServer) AmendFlightPlan(callsign string, fp FlightPlan) error {
 		return ErrNoFlightPlanFiled
 	} else {
 		ac.FlightPlan = &fp
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftFlightPlanChanged})
 		return v.controlDelegate.AmendFlightPlan(callsign, fp)
 	}
 }
@@ -410,7 +437,7 @@ func (v *VATSIMServer) InitiateTrack(callsign string) error {
 		return ErrOtherControllerHasTrack
 	} else {
 		ac.TrackingController = v.callsign
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftOtherChanged})
 		return v.controlDelegate.InitiateTrack(callsign)
 	}
 }
@@ -426,7 +453,7 @@ func (v *VATSIMServer) DropTrack(callsign string) error {
 		return ErrNotTrackedByMe
 	} else {
 		ac.TrackingController = ""
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftOtherChanged})
 		return v.controlDelegate.DropTrack(callsign)
 	}
 }
@@ -443,7 +470,7 @@ func (v *VATSIMServer) Handoff(callsign string, controller string) error {
 	} else {
 		// Use c.callsign in case we were given a sector id...
 		ac.OutboundHandoffController = c.Callsign
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftOtherChanged})
 		return v.controlDelegate.Handoff(callsign, c.Callsign)
 	}
 }
@@ -457,7 +484,7 @@ func (v *VATSIMServer) AcceptHandoff(callsign string) error {
 		return ErrNotBeingHandedOffToMe
 	} else {
 		ac.TrackingController = v.callsign
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftOtherChanged})
 		err := v.controlDelegate.AcceptHandoff(callsign)
 		ac.InboundHandoffController = "" // only do this now so delegate can get the controller
 		return err
@@ -472,7 +499,7 @@ func (v *VATSIMServer) RejectHandoff(callsign string) error {
 	} else if ac.InboundHandoffController == "" {
 		return ErrNotBeingHandedOffToMe
 	} else {
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftOtherChanged})
 		err := v.controlDelegate.RejectHandoff(callsign)
 		ac.InboundHandoffController = "" // only do this now so delegate can get the controller
 		return err
@@ -487,7 +514,7 @@ func (v *VATSIMServer) CancelHandoff(callsign string) error {
 	} else if ac.OutboundHandoffController == "" {
 		return ErrNotHandingOffAircraft
 	} else {
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftOtherChanged})
 		err := v.controlDelegate.CancelHandoff(callsign)
 		ac.OutboundHandoffController = "" // only do this now so delegate can get the controller
 		return err
@@ -535,36 +562,43 @@ func (v *VATSIMServer) GetUpdates() {
 	if v.connection != nil {
 		// Receive messages here; this runs in the same thread as the GUI et
 		// al., so there's nothing to worry about w.r.t. races.
-		messages := v.connection.GetMessages()
-		for _, msg := range messages {
-			strs := strings.Split(strings.TrimSpace(msg.Contents), ":")
-			if len(strs) == 0 {
-				lg.Printf("vatsim: empty message received?")
-				continue
-			}
-			if len(strs[0]) == 0 {
-				lg.Printf("vatsim: empty first field? \"%s\"", msg.Contents)
-				continue
-			}
+		//
+		// When a replay is running as fast as possible, there are always
+		// more messages available; only take more once the previous
+		// ones have been handled.
+		if rc := v.replayConnection(); rc == nil || rc.Rate() != 0 || len(v.backlog) == 0 {
+			v.backlog = append(v.backlog, v.connection.GetMessages()...)
+		}
 
-			if *logTraffic {
-				lg.Printf("Received: %s", msg.Contents)
-			}
+		// Many messages may update the same aircraft; subscribers only
+		// need to hear about each one once.
+		eventStream.BeginCoalescing()
+		defer eventStream.EndCoalescing()
+
+		// Handle as many messages as we can within the time budget; any
+		// that remain are left in the backlog until the next time we're
+		// called, so that a burst of messages doesn't cause a long stall.
+		start := time.Now()
+		n := 0
+		for n < len(v.backlog) && (n == 0 || time.Since(start) < vatsimUpdateTimeBudget) {
+			v.handleMessage(&v.backlog[n])
+			n++
+		}
 
-			matches := 0
-			for _, spec := range vatsimMessageSpecs {
-				if sender, ok := spec.Match(strs); ok {
-					matches++
-					if spec.handler != nil {
-						if err := spec.handler(v, sender, strs); err != nil {
-							lg.Printf("FSD message error: %T: %s: %s", err, err, msg.Contents)
-						}
-					}
-				}
-			}
-			if matches == 0 {
-				lg.Printf("No rule matched: %s", msg.Contents)
-			}
+		// Shift the remaining messages to the front, clearing the ones
+		// that were handled so that they can be garbage collected.
+		remaining := copy(v.backlog, v.backlog[n:])
+		for i := remaining; i < len(v.backlog); i++ {
+			v.backlog[i] = VATSIMMessage{}
+		}
+		v.backlog = v.backlog[:remaining]
+
+		if nc, ok := v.connection.(*VATSIMNetConnection); ok {
+			stats.vatsimSend = nc.SendStats()
+		} else if rc, ok := v.connection.(*VATSIMReplayConnection); ok && len(v.backlog) == 0 {
+			// Only snapshot once all of the delivered messages have been
+			// handled, so that the snapshot corresponds to rc.next.
+			v.maybeTakeReplaySnapshot(rc)
 		}
 
 		// Do this after processing the messages.
@@ -576,13 +610,36 @@ func (v *VATSIMServer) GetUpdates() {
 	// Clean up anyone who we haven't heard from in 30 minutes
 	now := v.CurrentTime()
 	for callsign, ac := range v.aircraft {
-		if now.Sub(ac.Tracks[0].Time).Minutes() > 30. {
+		if now.Sub(ac.Tracks.At(0).Time).Minutes() > 30. {
 			delete(v.aircraft, callsign)
 			eventStream.Post(&RemovedAircraftEvent{ac: ac})
+			ac.Tracks.Release()
 		}
 	}
 }
 
+// handleMessage dispatches a single received message to the handlers
+// registered for it.
+func (v *VATSIMServer) handleMessage(msg *VATSIMMessage) {
+	fields := msg.fields
+	if fields == nil {
+		v.fields = splitVATSIMFields(strings.TrimSpace(msg.Contents), v.fields[:0])
+		fields = v.fields
+	}
+	if len(fields[0]) == 0 {
+		lg.Printf("vatsim: empty first field? \"%s\"", msg.Contents)
+		return
+	}
+
+	if *logTraffic {
+		lg.Printf("Received: %s", msg.Contents)
+	}
+
+	if v.dispatcher.Dispatch(v, msg, fields) == 0 {
+		lg.Printf("No rule matched: %s", msg.Contents)
+	}
+}
+
 func (v *VATSIMServer) Disconnect() {
 	if v.connection == nil {
 		return
@@ -598,6 +655,7 @@ func (v *VATSIMServer) Disconnect() {
 
 	for _, ac := range v.aircraft {
 		eventStream.Post(&RemovedAircraftEvent{ac: ac})
+		ac.Tracks.Release()
 	}
 
 	v.aircraft = make(map[string]*Aircraft)
@@ -607,6 +665,7 @@ func (v *VATSIMServer) Disconnect() {
 	v.controllerSectors = make(map[string]*Controller)
 	v.metar = make(map[string]METAR)
 	v.atis = make(map[string][]ATIS)
+	v.replaySnapshots = nil
 }
 
 func (v *VATSIMServer) Connected() bool {
@@ -645,9 +704,13 @@ func (v *VATSIMServer) send(fields ...interface{}) {
 	}
 }
 
-func (v *VATSIMServer) getOrCreateAircraft(callsign string) *Aircraft {
+// getOrCreateAircraft returns the Aircraft with the given callsign,
+// creating it if necessary. For an existing aircraft, a
+// ModifiedAircraftEvent with the given changes is posted, since the
+// caller is about to update it.
+func (v *VATSIMServer) getOrCreateAircraft(callsign string, changes AircraftChanges) *Aircraft {
 	if ac, ok := v.aircraft[callsign]; ok {
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: changes})
 		return ac
 	} else {
 		ac = &Aircraft{Callsign: callsign}
@@ -667,7 +730,232 @@ func (v *VATSIMServer) trackInitiated(callsign string, controller string) error
 			// lg.Printf("%s: %s is tracking controller but %s initiated track?", callsign, ac.TrackingController, controller)
 		}
 		ac.TrackingController = controller
-		eventStream.Post(&ModifiedAircraftEvent{ac: ac})
+		eventStream.Post(&ModifiedAircraftEvent{ac: ac, changes: AircraftOtherChanged})
+	}
+	return nil
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Replay
+
+// How often, in session time, the server's state is snapshotted while a
+// session is replayed.  Seeking to an earlier time restores the most
+// recent snapshot before that time and then re-applies the messages
+// after it, so this bounds the amount of work done for a seek.
+const vatsimReplaySnapshotInterval = 5 * time.Minute
+
+// vatsimServerSnapshot stores a copy of a VATSIMServer's state at a point
+// in a replayed session.
+type vatsimServerSnapshot struct {
+	// Index of the first replay message that is not reflected in the
+	// snapshot.
+	next int
+
+	aircraft          map[string]*Aircraft
+	flightStrips      map[string]*FlightStrip
+	users             map[string]*User
+	controllers       map[string]*Controller
+	controllerSectors map[string]*Controller
+	pilots            map[string]*Pilot
+	metar             map[string]METAR
+	atis              map[string][]ATIS
+}
+
+// duplicatePointerMap returns a newly-allocated map that stores pointers
+// to copies of the values pointed to by the given map.
+func duplicatePointerMap[K comparable, V any](m map[K]*V) map[K]*V {
+	mnew := make(map[K]*V, len(m))
+	for k, v := range m {
+		vnew := *v
+		mnew[k] = &vnew
+	}
+	return mnew
+}
+
+// clone returns a deep copy of the snapshot, such that changes to the
+// server state stored in the returned snapshot do not affect the
+// original.
+func (s *vatsimServerSnapshot) clone() *vatsimServerSnapshot {
+	c := &vatsimServerSnapshot{
+		next:              s.next,
+		aircraft:          make(map[string]*Aircraft, len(s.aircraft)),
+		flightStrips:      duplicatePointerMap(s.flightStrips),
+		users:             duplicatePointerMap(s.users),
+		controllers:       make(map[string]*Controller, len(s.controllers)),
+		controllerSectors: make(map[string]*Controller, len(s.controllerSectors)),
+		pilots:            duplicatePointerMap(s.pilots),
+		metar:             DuplicateMap(s.metar),
+		atis:              make(map[string][]ATIS, len(s.atis)),
+	}
+
+	for callsign, ac := range s.aircraft {
+		acnew := *ac
+		acnew.Tracks = ac.Tracks.Duplicate()
+		if ac.FlightPlan != nil {
+			fp := *ac.FlightPlan
+			acnew.FlightPlan = &fp
+		}
+		c.aircraft[callsign] = &acnew
+	}
+
+	// controllerSectors points to the same Controllers as controllers, so
+	// keep track of what became of each one.
+	newController := make(map[*Controller]*Controller, len(s.controllers))
+	for callsign, ctrl := range s.controllers {
+		ctrlnew := *ctrl
+		c.controllers[callsign] = &ctrlnew
+		newController[ctrl] = &ctrlnew
 	}
+	for id, ctrl := range s.controllerSectors {
+		if ctrlnew, ok := newController[ctrl]; ok {
+			c.controllerSectors[id] = ctrlnew
+		} else {
+			ctrlnew := *ctrl
+			c.controllerSectors[id] = &ctrlnew
+		}
+	}
+
+	for airport, atis := range s.atis {
+		c.atis[airport] = DuplicateSlice(atis)
+	}
+
+	return c
+}
+
+// maybeTakeReplaySnapshot snapshots the server's state if enough session
+// time has passed since the previous snapshot.  All of the messages
+// before rc.next must have been handled.
+func (v *VATSIMServer) maybeTakeReplaySnapshot(rc *VATSIMReplayConnection) {
+	if rc.next == 0 {
+		return
+	}
+
+	interval := func(next int) int64 {
+		t := rc.messages[next-1].Time
+		return int64(t.Sub(rc.streamStart) / vatsimReplaySnapshotInterval)
+	}
+	current := interval(rc.next)
+	if current == 0 {
+		// The empty initial state serves for the first interval.
+		return
+	}
+
+	// After seeking backward, previously-snapshotted intervals will be
+	// replayed again; only take one snapshot per interval.
+	snaps := v.replaySnapshots
+	i := sort.Search(len(snaps), func(i int) bool { return snaps[i].next >= rc.next })
+	if (i > 0 && interval(snaps[i-1].next) == current) ||
+		(i < len(snaps) && interval(snaps[i].next) == current) {
+		return
+	}
+
+	snap := (&vatsimServerSnapshot{
+		next:              rc.next,
+		aircraft:          v.aircraft,
+		flightStrips:      v.flightStrips,
+		users:             v.users,
+		controllers:       v.controllers,
+		controllerSectors: v.controllerSectors,
+		pilots:            v.pilots,
+		metar:             v.metar,
+		atis:              v.atis,
+	}).clone()
+
+	v.replaySnapshots = append(snaps, nil)
+	copy(v.replaySnapshots[i+1:], v.replaySnapshots[i:])
+	v.replaySnapshots[i] = snap
+}
+
+// restoreReplaySnapshot resets the server's state to the one stored in
+// the given snapshot, or to the initial empty state if it is nil.
+func (v *VATSIMServer) restoreReplaySnapshot(snap *vatsimServerSnapshot) {
+	for _, ac := range v.aircraft {
+		eventStream.Post(&RemovedAircraftEvent{ac: ac})
+		ac.Tracks.Release()
+	}
+	for _, ctrl := range v.controllers {
+		eventStream.Post(&RemovedControllerEvent{Controller: ctrl})
+	}
+
+	if snap == nil {
+		snap = &vatsimServerSnapshot{}
+	}
+	// Restore a copy so that the snapshot can be used again.
+	s := snap.clone()
+	v.aircraft = s.aircraft
+	v.flightStrips = s.flightStrips
+	v.users = s.users
+	v.controllers = s.controllers
+	v.controllerSectors = s.controllerSectors
+	v.pilots = s.pilots
+	v.metar = s.metar
+	v.atis = s.atis
+
+	for _, ac := range v.aircraft {
+		eventStream.Post(&AddedAircraftEvent{ac: ac})
+	}
+	for _, ctrl := range v.controllers {
+		eventStream.Post(&AddedControllerEvent{Controller: ctrl})
+	}
+}
+
+// replayConnection returns the server's connection if it is replaying a
+// recorded session and nil otherwise.
+func (v *VATSIMServer) replayConnection() *VATSIMReplayConnection {
+	rc, _ := v.connection.(*VATSIMReplayConnection)
+	return rc
+}
+
+// SeekReplay moves the replay of a recorded session to the given time,
+// updating the server's state to match the state at that time.
+func (v *VATSIMServer) SeekReplay(t time.Time) error {
+	rc := v.replayConnection()
+	if rc == nil {
+		return errors.New("Not replaying a session")
+	}
+
+	// Index of the first message that hasn't yet been handled.
+	current := rc.next - len(v.backlog)
+	v.backlog = v.backlog[:0]
+
+	rc.Seek(t)
+	target := rc.next
+
+	// Find the most recent snapshot before the target time.
+	snaps := v.replaySnapshots
+	i := sort.Search(len(snaps), func(i int) bool { return snaps[i].next > target })
+	var snap *vatsimServerSnapshot
+	start := 0
+	if i > 0 {
+		snap = snaps[i-1]
+		start = snap.next
+	}
+
+	if current >= start && current <= target {
+		// Seeking forward from the current state is less work than
+		// starting from the snapshot.
+		start = current
+	} else {
+		v.restoreReplaySnapshot(snap)
+	}
+
+	// Apply the messages between there and the target time, taking
+	// snapshots along the way if we haven't been there before.
+	eventStream.BeginCoalescing()
+	defer eventStream.EndCoalescing()
+
+	for i := start; i < target; i++ {
+		msg := rc.messages[i]
+		// Handlers may use the current time, e.g. for radar tracks.
+		rc.setCurrentTime(msg.Time)
+		v.handleMessage(&msg)
+
+		rc.next = i + 1
+		v.maybeTakeReplaySnapshot(rc)
+	}
+
+	rc.next = target
+	rc.setCurrentTime(t)
+
 	return nil
 }
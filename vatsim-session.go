@@ -0,0 +1,328 @@
+// vatsim-session.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+// This file implements reading and writing of recorded VATSIM sessions
+// (.vsess files). Sessions are stored in a compact binary format: after a
+// short uncompressed header, the rest of the file is a zstd-compressed
+// stream of messages.  Each message is encoded as:
+//
+//   - a uvarint holding the length of the message contents, shifted left
+//     by one and with the low bit set if the message was sent by the
+//     client.
+//   - a varint holding the difference between the message's time and the
+//     previous message's time, in nanoseconds.  (The first message's time
+//     is relative to the Unix epoch.)
+//   - the message contents.
+//
+// Older sessions were stored as a JSON stream of VATSIMMessages; those
+// can still be read.
+
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/binary"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"io"
+	"os"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/klauspost/compress/zstd"
+)
+
+// vatsimSessionMagic is at the start of all binary session files; the
+// final byte is the format version.
+var vatsimSessionMagic = []byte{'V', 'I', 'C', 'E', 'S', 'E', 'S', 1}
+
+var ErrCorruptSession = errors.New("corrupt VATSIM session file")
+
+// Maximum length of a message's contents in a binary session file.  FSD
+// messages are much shorter than this; the limit ensures that a corrupt
+// length in a session file can't lead to a huge allocation.  (The length
+// can't be checked against the amount of data remaining, since that's
+// not known until the compressed stream has been decoded.)
+const vatsimSessionMaxMessageLength = 1 << 20
+
+// VATSIMSessionWriter writes VATSIMMessages to a binary session file.
+type VATSIMSessionWriter struct {
+	zw *zstd.Encoder
+	// last is the time of the previous message, in nanoseconds since the
+	// Unix epoch.
+	last int64
+	// Message headers are encoded here before they're written.
+	buf []byte
+}
+
+// NewVATSIMSessionWriter returns a VATSIMSessionWriter that writes to the
+// provided io.Writer. The caller must call Close to finish the session.
+func NewVATSIMSessionWriter(w io.Writer) (*VATSIMSessionWriter, error) {
+	if _, err := w.Write(vatsimSessionMagic); err != nil {
+		return nil, err
+	}
+
+	zw, err := zstd.NewWriter(w)
+	if err != nil {
+		return nil, err
+	}
+	return &VATSIMSessionWriter{zw: zw, buf: make([]byte, 2*binary.MaxVarintLen64)}, nil
+}
+
+// Write adds the provided message to the session.
+func (s *VATSIMSessionWriter) Write(msg VATSIMMessage) error {
+	if len(msg.Contents) > vatsimSessionMaxMessageLength {
+		return fmt.Errorf("%d byte message is too long to record", len(msg.Contents))
+	}
+
+	header := uint64(len(msg.Contents)) << 1
+	if msg.Sent {
+		header |= 1
+	}
+	t := msg.Time.UnixNano()
+
+	n := binary.PutUvarint(s.buf, header)
+	n += binary.PutVarint(s.buf[n:], t-s.last)
+	s.last = t
+
+	if _, err := s.zw.Write(s.buf[:n]); err != nil {
+		return err
+	}
+	_, err := io.WriteString(s.zw, msg.Contents)
+	return err
+}
+
+// Flush ensures that all of the messages written so far have been passed
+// along to the underlying io.Writer.
+func (s *VATSIMSessionWriter) Flush() error {
+	return s.zw.Flush()
+}
+
+// Close finishes writing the session. It does not close the underlying
+// io.Writer.
+func (s *VATSIMSessionWriter) Close() error {
+	return s.zw.Close()
+}
+
+// VATSIMSessionReader reads the VATSIMMessages stored in a session file,
+// in either the binary format or the older JSON format.
+type VATSIMSessionReader struct {
+	// Exactly one of zr and decoder is non-nil, depending on the file
+	// format.
+	zr      *zstd.Decoder
+	br      *bufio.Reader
+	last    int64
+	decoder *json.Decoder
+}
+
+// NewVATSIMSessionReader returns a VATSIMSessionReader for the session
+// stored in the provided io.Reader; the file format is detected
+// automatically.
+func NewVATSIMSessionReader(r io.Reader) (*VATSIMSessionReader, error) {
+	br := bufio.NewReader(r)
+
+	if magic, err := br.Peek(len(vatsimSessionMagic)); err == nil && bytes.Equal(magic, vatsimSessionMagic) {
+		br.Discard(len(vatsimSessionMagic))
+
+		zr, err := zstd.NewReader(br)
+		if err != nil {
+			return nil, err
+		}
+		return &VATSIMSessionReader{zr: zr, br: bufio.NewReader(zr)}, nil
+	} else if err == nil && len(magic) > 0 && bytes.Equal(magic[:len(magic)-1], vatsimSessionMagic[:len(magic)-1]) {
+		return nil, fmt.Errorf("unsupported VATSIM session file version %d", magic[len(magic)-1])
+	}
+
+	// Assume that it's a JSON stream.
+	return &VATSIMSessionReader{decoder: json.NewDecoder(br)}, nil
+}
+
+// Read reads the next message from the session into msg, returning io.EOF
+// once all of the messages have been read.
+func (s *VATSIMSessionReader) Read(msg *VATSIMMessage) error {
+	if s.decoder != nil {
+		return s.decoder.Decode(msg)
+	}
+
+	header, err := binary.ReadUvarint(s.br)
+	if err != nil {
+		// A clean io.EOF is fine here; that's the end of the session.
+		return err
+	}
+	delta, err := binary.ReadVarint(s.br)
+	if err != nil {
+		return ErrCorruptSession
+	}
+
+	if header>>1 > vatsimSessionMaxMessageLength {
+		return ErrCorruptSession
+	}
+	contents := make([]byte, header>>1)
+	if _, err := io.ReadFull(s.br, contents); err != nil {
+		return ErrCorruptSession
+	}
+
+	s.last += delta
+	*msg = VATSIMMessage{
+		Contents: string(contents),
+		Sent:     header&1 != 0,
+		Time:     time.Unix(0, s.last),
+	}
+	return nil
+}
+
+// Close releases the resources used by the reader. It does not close the
+// underlying io.Reader.
+func (s *VATSIMSessionReader) Close() {
+	if s.zr != nil {
+		s.zr.Close()
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////
+// VATSIMSessionRecorder
+
+const (
+	// Maximum number of messages that may be waiting to be written to the
+	// session file; messages recorded when the queue is full are dropped.
+	vatsimRecorderQueueSize = 16384
+	// How often the session file is flushed, bounding how much is lost if
+	// vice crashes.
+	vatsimRecorderFlushInterval = 5 * time.Second
+)
+
+// VATSIMSessionRecorder incrementally writes messages to a session file
+// from a background goroutine, so that the messages don't need to be kept
+// in memory and so that a recording is available even if vice exits
+// unexpectedly.
+type VATSIMSessionRecorder struct {
+	filename string
+	f        *os.File
+
+	// mu protects closed, which ensures that no messages are sent to ch
+	// after it's been closed.
+	mu     sync.Mutex
+	closed bool
+	ch     chan VATSIMMessage
+	done   chan struct{}
+
+	// Accessed atomically.
+	dropped int64
+	// Only accessed by the writer goroutine until it exits.
+	recorded int
+}
+
+// NewVATSIMSessionRecorder creates the specified session file and starts
+// recording to it.
+func NewVATSIMSessionRecorder(filename string) (*VATSIMSessionRecorder, error) {
+	f, err := os.Create(filename)
+	if err != nil {
+		return nil, err
+	}
+
+	r := &VATSIMSessionRecorder{
+		filename: filename,
+		f:        f,
+		ch:       make(chan VATSIMMessage, vatsimRecorderQueueSize),
+		done:     make(chan struct{}),
+	}
+	go r.writeMessages()
+
+	return r, nil
+}
+
+func (r *VATSIMSessionRecorder) writeMessages() {
+	defer close(r.done)
+
+	// Buffer the writes to the file; the zstd encoder writes in small
+	// chunks.
+	bw := bufio.NewWriter(r.f)
+	w, err := NewVATSIMSessionWriter(bw)
+	if err != nil {
+		lg.Errorf("%s: %v", r.filename, err)
+		// Drain the channel so that Record doesn't fill it up.
+		for range r.ch {
+		}
+		return
+	}
+
+	flush := func() {
+		if err := w.Flush(); err != nil {
+			lg.Errorf("%s: %v", r.filename, err)
+		} else if err := bw.Flush(); err != nil {
+			lg.Errorf("%s: %v", r.filename, err)
+		}
+	}
+
+	ticker := time.NewTicker(vatsimRecorderFlushInterval)
+	defer ticker.Stop()
+
+	for {
+		select {
+		case msg, ok := <-r.ch:
+			if !ok {
+				// All done
+				if err := w.Close(); err != nil {
+					lg.Errorf("%s: %v", r.filename, err)
+				}
+				if err := bw.Flush(); err != nil {
+					lg.Errorf("%s: %v", r.filename, err)
+				}
+				return
+			}
+
+			if err := w.Write(msg); err != nil {
+				lg.Errorf("%s: %v", r.filename, err)
+			} else {
+				r.recorded++
+			}
+
+		case <-ticker.C:
+			flush()
+		}
+	}
+}
+
+// Record adds a message to the session; it may be called concurrently
+// from multiple goroutines and doesn't block.
+func (r *VATSIMSessionRecorder) Record(msg VATSIMMessage) {
+	// Don't hold on to the fields and decoded message, if present.
+	msg = VATSIMMessage{Contents: msg.Contents, Sent: msg.Sent, Time: msg.Time}
+
+	r.mu.Lock()
+	defer r.mu.Unlock()
+
+	if r.closed {
+		return
+	}
+	select {
+	case r.ch <- msg:
+	default:
+		atomic.AddInt64(&r.dropped, 1)
+	}
+}
+
+// Close finishes writing the session file, returning the number of
+// messages that were recorded.
+func (r *VATSIMSessionRecorder) Close() int {
+	r.mu.Lock()
+	if !r.closed {
+		r.closed = true
+		close(r.ch)
+	}
+	r.mu.Unlock()
+
+	<-r.done
+	if err := r.f.Close(); err != nil {
+		lg.Errorf("%s: %v", r.filename, err)
+	}
+	if n := atomic.LoadInt64(&r.dropped); n > 0 {
+		lg.Errorf("%s: %d messages dropped since the recording queue was full", r.filename, n)
+	}
+
+	return r.recorded
+}
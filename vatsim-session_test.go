@@ -0,0 +1,114 @@
+// vatsim-session_test.go
+// Copyright(c) 2022 Matt Pharr, licensed under the GNU Public License, Version 3.
+// SPDX: GPL-3.0-only
+
+package main
+
+import (
+	"bytes"
+	"encoding/binary"
+	"encoding/json"
+	"io"
+	"testing"
+	"time"
+
+	"github.com/klauspost/compress/zstd"
+)
+
+func TestVATSIMSessionRoundTrip(t *testing.T) {
+	start := time.Date(2022, 11, 5, 18, 30, 0, 12345, time.UTC)
+	messages := []VATSIMMessage{
+		VATSIMMessage{Contents: "@N:AAL123:1200:1:40.63944:-73.76639:13:0:4261412866:0\r\n", Time: start},
+		VATSIMMessage{Contents: "$CQJFK_TWR:SERVER:ATC:JFK_TWR\r\n", Time: start.Add(time.Second), Sent: true},
+		VATSIMMessage{Contents: "", Time: start.Add(time.Second)},
+		// Messages may be recorded slightly out of order.
+		VATSIMMessage{Contents: "#TMBOS_CTR:@19100:hello", Time: start.Add(500 * time.Millisecond)},
+	}
+
+	var buf bytes.Buffer
+	w, err := NewVATSIMSessionWriter(&buf)
+	if err != nil {
+		t.Fatalf("NewVATSIMSessionWriter: %v", err)
+	}
+	for _, msg := range messages {
+		if err := w.Write(msg); err != nil {
+			t.Fatalf("Write: %v", err)
+		}
+	}
+	if err := w.Close(); err != nil {
+		t.Fatalf("Close: %v", err)
+	}
+
+	read := func(b []byte) ([]VATSIMMessage, error) {
+		r, err := NewVATSIMSessionReader(bytes.NewReader(b))
+		if err != nil {
+			return nil, err
+		}
+		defer r.Close()
+
+		var msgs []VATSIMMessage
+		for {
+			var msg VATSIMMessage
+			if err := r.Read(&msg); err == io.EOF {
+				return msgs, nil
+			} else if err != nil {
+				return msgs, err
+			}
+			msgs = append(msgs, msg)
+		}
+	}
+	check := func(got []VATSIMMessage) {
+		t.Helper()
+		if len(got) != len(messages) {
+			t.Fatalf("got %d messages, expected %d", len(got), len(messages))
+		}
+		for i := range got {
+			if got[i].Contents != messages[i].Contents || got[i].Sent != messages[i].Sent ||
+				!got[i].Time.Equal(messages[i].Time) {
+				t.Errorf("message %d: got %+v, expected %+v", i, got[i], messages[i])
+			}
+		}
+	}
+
+	if got, err := read(buf.Bytes()); err != nil {
+		t.Errorf("reading session: %v", err)
+	} else {
+		check(got)
+	}
+
+	// Sessions in the older JSON format can still be read.
+	var jbuf bytes.Buffer
+	enc := json.NewEncoder(&jbuf)
+	for _, msg := range messages {
+		if err := enc.Encode(msg); err != nil {
+			t.Fatalf("json Encode: %v", err)
+		}
+	}
+	if got, err := read(jbuf.Bytes()); err != nil {
+		t.Errorf("reading JSON session: %v", err)
+	} else {
+		check(got)
+	}
+
+	// A corrupt message length is reported as an error rather than
+	// leading to a huge allocation.
+	var cbuf bytes.Buffer
+	cbuf.Write(vatsimSessionMagic)
+	zw, err := zstd.NewWriter(&cbuf)
+	if err != nil {
+		t.Fatalf("zstd.NewWriter: %v", err)
+	}
+	header := make([]byte, 2*binary.MaxVarintLen64)
+	n := binary.PutUvarint(header, 1<<40)
+	n += binary.PutVarint(header[n:], 0)
+	zw.Write(header[:n])
+	zw.Close()
+	if _, err := read(cbuf.Bytes()); err != ErrCorruptSession {
+		t.Errorf("got error %v for corrupt message length, expected ErrCorruptSession", err)
+	}
+
+	// As is a truncated session.
+	if got, err := read(buf.Bytes()[:len(buf.Bytes())-8]); err == nil && len(got) == len(messages) {
+		t.Errorf("no error for truncated session")
+	}
+}
@@ -6,13 +6,14 @@ package main
 
 import (
 	"bufio"
-	"encoding/json"
 	"fmt"
 	"io"
 	"net"
 	"os"
 	"path"
 	"runtime/debug"
+	"sort"
+	"strconv"
 	"strings"
 	"sync"
 	"time"
@@ -27,6 +28,14 @@ type VATSIMMessage struct {
 	Contents string
 	Sent     bool
 	Time     time.Time
+
+	// Connections that receive messages on a separate goroutine may
+	// also split them into fields and decode them there (see
+	// VATSIMMessageDispatcher.Decode), so that less work is left for the
+	// main thread.
+	fields    []string
+	decoded   interface{}
+	decodedBy *VATSIMMessageSpec
 }
 
 // VATSIMConnection provides a simple abstraction for connections to the
@@ -65,20 +74,63 @@ type VATSIMConnection interface {
 // the usual case of a true network connection to VATSIM.
 type VATSIMNetConnection struct {
 	address     string
+	dispatcher  *VATSIMMessageDispatcher
 	messageChan chan VATSIMMessage
 	conn        *net.TCPConn
 	connected   bool
 
-	// All network traffic is logged in allMessages so that it can be saved
-	// for replays or debugging.  Access to the allMessages array is protected
-	// by messagesMutex.
-	messagesMutex sync.Mutex
-	allMessages   []VATSIMMessage
+	// In devmode, all network traffic is recorded so that it can be saved
+	// for replays or debugging.
+	recorder *VATSIMSessionRecorder
+
+	// Outgoing messages are formatted in sendBuf, which is only accessed
+	// from the main thread, and then appended to sendQueue. A separate
+	// goroutine periodically sends everything in sendQueue with a single
+	// write.  sendQueue, sendQueueMessages, sendStats, and sendClosed are
+	// protected by sendMutex; sendSpace is signaled when the writer has
+	// taken the queued messages or has exited.
+	sendBuf           []byte
+	sendMutex         sync.Mutex
+	sendSpace         *sync.Cond
+	sendQueue         []byte
+	sendQueueMessages int
+	sendStats         VATSIMSendStats
+	sendClosed        bool
+	sendDone          chan struct{}
+	writerDone        chan struct{}
+}
+
+const (
+	// Maximum number of bytes of outgoing messages that may be queued;
+	// sending a message when the queue is full waits for the writer.
+	vatsimSendQueueLimit = 64 * 1024
+	// How often queued outgoing messages are written to the connection.
+	vatsimSendInterval = 10 * time.Millisecond
+)
+
+// VATSIMSendStats collects statistics about the messages sent by a
+// VATSIMNetConnection.
+type VATSIMSendStats struct {
+	queueDepth       int // messages waiting to be sent
+	maxQueueDepth    int
+	messagesSent     int
+	messagesDropped  int // not sent, due to write errors or a closed connection
+	stalls           int // sends that waited for the queue to have room
+	writes           int
+	lastWriteLatency time.Duration
+	maxWriteLatency  time.Duration
+}
+
+func (s VATSIMSendStats) String() string {
+	return fmt.Sprintf("queue %d (max %d) sent %d dropped %d stalls %d writes %d latency %s (max %s)",
+		s.queueDepth, s.maxQueueDepth, s.messagesSent, s.messagesDropped, s.stalls, s.writes,
+		s.lastWriteLatency, s.maxWriteLatency)
 }
 
 // NewVATSIMNetConnection attempts to initiate a VATSIM connection with the
-// provided network address.
-func NewVATSIMNetConnection(address string) (*VATSIMNetConnection, error) {
+// provided network address. The provided dispatcher is used to decode
+// messages as they are received.
+func NewVATSIMNetConnection(address string, dispatcher *VATSIMMessageDispatcher) (*VATSIMNetConnection, error) {
 	if !strings.ContainsAny(address, ":") {
 		address += ":6809"
 	}
@@ -86,8 +138,12 @@ func NewVATSIMNetConnection(address string) (*VATSIMNetConnection, error) {
 
 	c := &VATSIMNetConnection{
 		address:     address,
+		dispatcher:  dispatcher,
 		messageChan: make(chan VATSIMMessage, 4096),
+		sendDone:    make(chan struct{}),
+		writerDone:  make(chan struct{}),
 	}
+	c.sendSpace = sync.NewCond(&c.sendMutex)
 
 	raddr, err := net.ResolveTCPAddr("tcp", address)
 	if err != nil {
@@ -101,6 +157,20 @@ func NewVATSIMNetConnection(address string) (*VATSIMNetConnection, error) {
 
 	c.connected = true
 
+	if *devmode {
+		// Record the session in the user's home directory; the user is
+		// asked whether to keep it when the connection is closed.
+		home, err := os.UserHomeDir()
+		if err != nil {
+			home = ""
+		}
+		fn := "vice-session-" + time.Now().Format("2006-01-02@150405") + ".vsess"
+		fn = path.Join(home, fn)
+		if c.recorder, err = NewVATSIMSessionRecorder(fn); err != nil {
+			lg.Errorf("%s: %v", fn, err)
+		}
+	}
+
 	// Receive messages in a separate goroutine and send them along the channel; this
 	// lets us block on waiting for new messages without any bother.
 	go func(c *VATSIMNetConnection) {
@@ -117,11 +187,14 @@ func NewVATSIMNetConnection(address string) (*VATSIMNetConnection, error) {
 			if str, err := r.ReadString('\n'); err == nil {
 				msg := VATSIMMessage{Contents: str, Sent: false, Time: time.Now()}
 				// Add the message to the log
-				c.messagesMutex.Lock()
-				c.allMessages = append(c.allMessages, msg)
-				c.messagesMutex.Unlock()
-				// And send it on the chan
+				if c.recorder != nil {
+					c.recorder.Record(msg)
+				}
+				// Do as much of the work of handling the message as we
+				// can here, and send it on the chan.
+				c.dispatcher.Decode(&msg)
 				c.messageChan <- msg
+				wakeMainLoop()
 			} else {
 				close(c.messageChan)
 				c.connected = false
@@ -131,9 +204,80 @@ func NewVATSIMNetConnection(address string) (*VATSIMNetConnection, error) {
 		}
 	}(c)
 
+	go c.writeMessages()
+
 	return c, nil
 }
 
+// writeMessages runs in its own goroutine, periodically writing all of
+// the queued outgoing messages to the connection.
+func (c *VATSIMNetConnection) writeMessages() {
+	defer close(c.writerDone)
+	defer func() {
+		// Don't leave senders waiting for room in the queue.
+		c.sendMutex.Lock()
+		c.sendClosed = true
+		c.sendSpace.Broadcast()
+		c.sendMutex.Unlock()
+	}()
+
+	ticker := time.NewTicker(vatsimSendInterval)
+	defer ticker.Stop()
+
+	// buf is swapped with sendQueue each time, so after the first few
+	// writes, no further allocations are needed.
+	var buf []byte
+	for {
+		done := false
+		select {
+		case <-ticker.C:
+		case <-c.sendDone:
+			// Send anything that's still pending before exiting.
+			done = true
+		}
+
+		c.sendMutex.Lock()
+		buf, c.sendQueue = c.sendQueue, buf[:0]
+		n := c.sendQueueMessages
+		c.sendQueueMessages = 0
+		c.sendStats.queueDepth = 0
+		c.sendSpace.Broadcast()
+		c.sendMutex.Unlock()
+
+		if len(buf) > 0 {
+			start := time.Now()
+			_, err := c.conn.Write(buf)
+			latency := time.Since(start)
+
+			c.sendMutex.Lock()
+			if err == nil {
+				c.sendStats.messagesSent += n
+			} else {
+				c.sendStats.messagesDropped += n
+			}
+			c.sendStats.writes++
+			c.sendStats.lastWriteLatency = latency
+			c.sendStats.maxWriteLatency = max(c.sendStats.maxWriteLatency, latency)
+			c.sendMutex.Unlock()
+
+			if err != nil {
+				lg.Printf("Send error: %v", err)
+			}
+		}
+
+		if done {
+			return
+		}
+	}
+}
+
+// SendStats returns statistics about the messages sent so far.
+func (c *VATSIMNetConnection) SendStats() VATSIMSendStats {
+	c.sendMutex.Lock()
+	defer c.sendMutex.Unlock()
+	return c.sendStats
+}
+
 func (c *VATSIMNetConnection) GetMessages() []VATSIMMessage {
 	var messages []VATSIMMessage
 	for {
@@ -153,20 +297,22 @@ func (c *VATSIMNetConnection) GetMessages() []VATSIMMessage {
 }
 
 func (c *VATSIMNetConnection) SendMessage(callsign string, fields ...interface{}) {
-	msg := ""
+	msg := c.sendBuf[:0]
 	for i, f := range fields {
 		// Append the string representation of |f| to the message
 		// Currently, the message fields must be strings, integers, or
 		// floats.  (That's all that's currently used.)
 		switch v := f.(type) {
 		case string:
-			msg += v
+			msg = append(msg, v...)
 		case int:
-			msg += fmt.Sprintf("%d", v)
-		case float32, float64:
-			msg += fmt.Sprintf("%f", v)
+			msg = strconv.AppendInt(msg, int64(v), 10)
+		case float32:
+			msg = strconv.AppendFloat(msg, float64(v), 'f', 6, 32)
+		case float64:
+			msg = strconv.AppendFloat(msg, v, 'f', 6, 64)
 		case Squawk:
-			msg += v.String()
+			msg = append(msg, v.String()...)
 		default:
 			lg.Errorf("Unhandled type passed to SendMessage(): %T", v)
 			continue
@@ -174,26 +320,45 @@ func (c *VATSIMNetConnection) SendMessage(callsign string, fields ...interface{}
 
 		// The first field gets our callsign appended
 		if i == 0 {
-			msg += callsign
+			msg = append(msg, callsign...)
 		}
 		// And colons in between fields until the last one.
 		if i < len(fields)-1 {
-			msg += ":"
+			msg = append(msg, ':')
 		}
 	}
-	msg += "\r\n"
+	msg = append(msg, '\r', '\n')
+	c.sendBuf = msg
 
 	if *logTraffic {
 		lg.Printf("Sent: %s", msg)
 	}
 
-	if _, err := c.conn.Write([]byte(msg)); err != nil {
-		lg.Printf("Send error: %v", err)
+	// Queue the message for the writer goroutine.  If the queue is full,
+	// wait for the writer to take it rather than dropping the message;
+	// protocol messages can't be lost.
+	c.sendMutex.Lock()
+	if len(c.sendQueue) > 0 && len(c.sendQueue)+len(msg) > vatsimSendQueueLimit && !c.sendClosed {
+		c.sendStats.stalls++
+		for len(c.sendQueue) > 0 && len(c.sendQueue)+len(msg) > vatsimSendQueueLimit && !c.sendClosed {
+			c.sendSpace.Wait()
+		}
+	}
+	if c.sendClosed {
+		c.sendStats.messagesDropped++
+		c.sendMutex.Unlock()
+		lg.Errorf("Connection closed; unable to send message: %s", msg)
+		return
+	}
+	c.sendQueue = append(c.sendQueue, msg...)
+	c.sendQueueMessages++
+	c.sendStats.queueDepth = c.sendQueueMessages
+	c.sendStats.maxQueueDepth = max(c.sendStats.maxQueueDepth, c.sendQueueMessages)
+	c.sendMutex.Unlock()
+
+	if c.recorder != nil {
+		c.recorder.Record(VATSIMMessage{Contents: string(msg), Time: time.Now(), Sent: true})
 	}
-
-	c.messagesMutex.Lock()
-	c.allMessages = append(c.allMessages, VATSIMMessage{Contents: msg, Time: time.Now(), Sent: true})
-	c.messagesMutex.Unlock()
 }
 
 func (c *VATSIMNetConnection) CurrentTime() time.Time {
@@ -219,36 +384,32 @@ func (c *VATSIMNetConnection) Connected() bool {
 }
 
 func (c *VATSIMNetConnection) Close() {
+	// Give the writer goroutine a chance to send any pending messages,
+	// but don't wait too long if the connection is stuck.
+	c.conn.SetWriteDeadline(time.Now().Add(time.Second))
+	close(c.sendDone)
+	<-c.writerDone
+
 	// Closing the connection will cause the goroutine to see an error,
 	// close the chan, and exit.
 	c.conn.Close()
 
-	if *devmode && len(c.allMessages) > 0 {
+	if c.recorder == nil {
+		return
+	}
+
+	fn := c.recorder.filename
+	if c.recorder.Close() == 0 {
+		os.Remove(fn)
+	} else {
 		save := &YesOrNoModalClient{
 			title: "Save Session?",
 			query: "Would you like to save the traffic from this session\n" +
 				"for debugging or future replaying?",
-			ok: func() {
-				home, err := os.UserHomeDir()
-				if err != nil {
-					home = ""
-				}
-				fn := "vice-session-" + time.Now().Format("2006-01-02@150405") + ".vsess"
-				fn = path.Join(home, fn)
-				if f, err := os.Create(fn); err != nil {
+			ok: func() { lg.Printf("Saved session in %s", fn) },
+			notok: func() {
+				if err := os.Remove(fn); err != nil {
 					lg.Errorf("%s: %v", fn, err)
-				} else {
-					defer f.Close()
-					enc := json.NewEncoder(f)
-					c.messagesMutex.Lock()
-					defer c.messagesMutex.Unlock()
-
-					for _, msg := range c.allMessages {
-						if err := enc.Encode(msg); err != nil {
-							lg.Errorf("encoding %+v: %v", msg, err)
-							return
-						}
-					}
 				}
 			},
 		}
@@ -259,6 +420,9 @@ func (c *VATSIMNetConnection) Close() {
 // VATSIMReplayConnection implements the VATSIMConnection interface for the
 // purpose of replaying a captured network connection (e.g., using vsniff
 // or VATSIMNetConnection's functionality for doing so.
+//
+// All of the session's messages are loaded when the connection is
+// created, which allows seeking to arbitrary times in the session.
 type VATSIMReplayConnection struct {
 	// Timestamp of the first message
 	streamStart time.Time
@@ -267,81 +431,109 @@ type VATSIMReplayConnection struct {
 	// account for any requested offset into the stream as well as replay
 	// rate time scaling, so this is actually the time corresponding to the
 	// beginning of the stream.
-	replayStart        time.Time
+	replayStart time.Time
+	// If timeRateMultiplier is zero, messages are replayed as quickly as
+	// they can be processed, regardless of their timestamps.
 	timeRateMultiplier float32
+	// When replaying as quickly as possible, the current time is the
+	// timestamp of the most recently delivered message.
+	unboundedTime time.Time
 
-	// next always stores the next undelivered message, so that we can peek
-	// at its time and see when we should send it along.
-	next VATSIMMessage
+	// All of the messages received in the session, sorted by time.
+	messages []VATSIMMessage
+	// next is the index of the next undelivered message.
+	next int
 
 	filename string
-	f        io.ReadCloser
-	decoder  *json.Decoder
 }
 
+// Number of messages returned by each call to GetMessages when replaying
+// as quickly as possible.
+const vatsimReplayBatchSize = 1024
+
 // NewVATSIMReplayConnection tries to create a new VATSIMReplayConnection
-// from the specified file, which should contain a JSON-formatted array of
-// VATSIMMessages.  It further takes an offset into the trace at which to
-// start, specified in seconds, as well as a time rate multiplier for
-// slowing down or speeding up the replay.
-func NewVATSIMReplayConnection(filename string, offsetSeconds int, replayRate float32) (*VATSIMReplayConnection, error) {
-	offset := -time.Duration(time.Duration(float32(offsetSeconds)/replayRate) * time.Second)
+// from the specified session file (see VATSIMSessionReader).  It further
+// takes a time rate multiplier for slowing down or speeding up the
+// replay.  A rate of zero causes the trace to be replayed as quickly as
+// it can be processed.  The replay starts at the beginning of the
+// session; see VATSIMServer.SeekReplay for starting later.
+func NewVATSIMReplayConnection(filename string, replayRate float32) (*VATSIMReplayConnection, error) {
+	f, err := os.Open(filename)
+	if err != nil {
+		return nil, fmt.Errorf("%s: %s", filename, err)
+	}
+	defer f.Close()
+
+	reader, err := NewVATSIMSessionReader(f)
+	if err != nil {
+		return nil, fmt.Errorf("%s: %w", filename, err)
+	}
+	defer reader.Close()
 
 	c := &VATSIMReplayConnection{
 		filename:           filename,
-		replayStart:        time.Now().Add(offset),
 		timeRateMultiplier: replayRate,
 	}
 
-	var err error
-	if c.f, err = os.Open(filename); err != nil {
-		return nil, fmt.Errorf("%s: %s", filename, err)
-	}
-
-	c.decoder = json.NewDecoder(c.f)
+	for {
+		var msg VATSIMMessage
+		if err := reader.Read(&msg); err == io.EOF {
+			break
+		} else if err != nil {
+			if len(c.messages) == 0 {
+				return nil, fmt.Errorf("%s: error decoding initial message: %w", filename, err)
+			}
+			// Replay what we've got.
+			lg.Errorf("%s: %v", filename, err)
+			break
+		}
 
-	if err = c.decoder.Decode(&c.next); err != nil {
-		return nil, fmt.Errorf("%s: error decoding initial message: %w", filename, err)
+		// Don't report messages that the client originally sent
+		if !msg.Sent {
+			msg.Contents = strings.TrimSpace(msg.Contents) + "\r\n"
+			c.messages = append(c.messages, msg)
+		}
 	}
-	c.streamStart = c.next.Time
+	if len(c.messages) == 0 {
+		return nil, fmt.Errorf("%s: no messages found", filename)
+	}
+
+	// Messages from different goroutines may have been recorded slightly
+	// out of order.
+	sort.SliceStable(c.messages, func(i, j int) bool {
+		return c.messages[i].Time.Before(c.messages[j].Time)
+	})
+	c.streamStart = c.messages[0].Time
+	c.setCurrentTime(c.streamStart)
 
 	return c, nil
 }
 
 func (r *VATSIMReplayConnection) GetMessages() []VATSIMMessage {
-	if r.f == nil {
-		// We previously reached EOF
-		return nil
-	}
-
-	var messages []VATSIMMessage
-
-	streamNow := r.CurrentTime() // Current time w.r.t. the stream
+	start := r.next
 
-	// As long as the next message is before the current stream time, add
-	// it to the messages array.
-	for r.next.Time.Before(streamNow) {
-		// Don't report messages that the client originally sent
-		if !r.next.Sent {
-			msg := strings.TrimSpace(r.next.Contents) + "\r\n"
-			messages = append(messages, VATSIMMessage{Contents: msg, Sent: false, Time: r.next.Time})
+	if r.timeRateMultiplier == 0 {
+		r.next = min(r.next+vatsimReplayBatchSize, len(r.messages))
+		if r.next > start {
+			r.unboundedTime = r.messages[r.next-1].Time
 		}
+	} else {
+		streamNow := r.CurrentTime() // Current time w.r.t. the stream
 
-		if err := r.decoder.Decode(&r.next); err == io.EOF {
-			r.f.Close()
-			r.f = nil
-			break
+		// Deliver all of the messages before the current stream time.
+		for r.next < len(r.messages) && r.messages[r.next].Time.Before(streamNow) {
+			r.next++
 		}
 	}
 
-	return messages
+	return r.messages[start:r.next]
 }
 
 func (r *VATSIMReplayConnection) SendMessage(callsign string, m ...interface{}) {}
 
 func (r *VATSIMReplayConnection) GetWindowTitle() string {
 	t := "replay " + r.filename + " - "
-	if r.f != nil {
+	if r.Connected() {
 		t += "active"
 	} else {
 		t += "finished"
@@ -350,6 +542,10 @@ func (r *VATSIMReplayConnection) GetWindowTitle() string {
 }
 
 func (r *VATSIMReplayConnection) CurrentTime() time.Time {
+	if r.timeRateMultiplier == 0 {
+		return r.unboundedTime
+	}
+
 	// How many seconds into the stream are we?
 	ds := time.Since(r.replayStart).Seconds() * float64(r.timeRateMultiplier)
 	s := time.Duration(ds * float64(time.Second))
@@ -357,16 +553,54 @@ func (r *VATSIMReplayConnection) CurrentTime() time.Time {
 	return r.streamStart.Add(s)
 }
 
-func (r *VATSIMReplayConnection) Connected() bool {
-	return r.f != nil
+// setCurrentTime updates the replay clock so that CurrentTime returns
+// the given time.
+func (r *VATSIMReplayConnection) setCurrentTime(t time.Time) {
+	if r.timeRateMultiplier == 0 {
+		r.unboundedTime = t
+	} else {
+		ds := t.Sub(r.streamStart).Seconds() / float64(r.timeRateMultiplier)
+		r.replayStart = time.Now().Add(-time.Duration(ds * float64(time.Second)))
+	}
 }
 
-func (r *VATSIMReplayConnection) Close() {
-	if r.f != nil {
-		r.f.Close()
-	}
+// TimeRange returns the times of the first and last messages in the
+// session.
+func (r *VATSIMReplayConnection) TimeRange() (time.Time, time.Time) {
+	return r.streamStart, r.messages[len(r.messages)-1].Time
+}
+
+// Rate returns the current replay rate multiplier; zero indicates that
+// messages are being replayed as quickly as possible.
+func (r *VATSIMReplayConnection) Rate() float32 {
+	return r.timeRateMultiplier
+}
+
+// SetRate changes the replay rate multiplier without changing the current
+// replay time.
+func (r *VATSIMReplayConnection) SetRate(rate float32) {
+	t := r.CurrentTime()
+	r.timeRateMultiplier = rate
+	r.setCurrentTime(t)
+}
+
+// Seek repositions the replay so that the next message delivered is the
+// first one at or after the given time and the replay clock is set to
+// that time.  Note that it's up to the caller to reset any state that
+// was based on messages that were previously delivered.
+func (r *VATSIMReplayConnection) Seek(t time.Time) {
+	r.next = sort.Search(len(r.messages), func(i int) bool {
+		return !r.messages[i].Time.Before(t)
+	})
+	r.setCurrentTime(t)
 }
 
+func (r *VATSIMReplayConnection) Connected() bool {
+	return r.next < len(r.messages)
+}
+
+func (r *VATSIMReplayConnection) Close() {}
+
 ///////////////////////////////////////////////////////////////////////////
 // VATSIMMessageSpec
 
@@ -378,6 +612,13 @@ type VATSIMMessageSpec struct {
 	minFields int
 	match     []string
 	handler   func(v *VATSIMServer, sender string, args []string) error
+
+	// Specs created with NewDecodingMessageSpec split the work of
+	// handling a message into decoding, which doesn't access the
+	// VATSIMServer and so can be done on any goroutine, and applying the
+	// decoded message to the VATSIMServer.
+	decode func(sender string, args []string) (interface{}, error)
+	apply  func(v *VATSIMServer, sender string, decoded interface{}) error
 }
 
 // NewMessageSpec returns a VATSIMMessageSpec corresponding to the provided
@@ -409,6 +650,28 @@ func NewMessageSpec(pattern string, minFields int,
 		handler:   handler}
 }
 
+// NewDecodingMessageSpec returns a VATSIMMessageSpec for the given pattern
+// (see NewMessageSpec) that handles messages by first calling decode and
+// then calling apply with its result.  The decode function must not access
+// the VATSIMServer or other global state, as it may be called
+// asynchronously as messages are received.
+func NewDecodingMessageSpec(pattern string, minFields int,
+	decode func(sender string, args []string) (interface{}, error),
+	apply func(v *VATSIMServer, sender string, decoded interface{}) error) *VATSIMMessageSpec {
+	return &VATSIMMessageSpec{
+		minFields: minFields,
+		match:     strings.Split(pattern, ":"),
+		handler: func(v *VATSIMServer, sender string, args []string) error {
+			if decoded, err := decode(sender, args); err != nil {
+				return err
+			} else {
+				return apply(v, sender, decoded)
+			}
+		},
+		decode: decode,
+		apply:  apply}
+}
+
 // Match checks to see if the provided VATSIM message (already split at
 // colons into separate string fields) matches the VATSIMMessageSpec.  It
 // returns the sender of the message (i.e., the text after the match in the
@@ -434,3 +697,163 @@ func (s *VATSIMMessageSpec) Match(fields []string) (sender string, matched bool)
 	matched = true
 	return
 }
+
+// splitVATSIMFields splits a VATSIM message at colons, appending the
+// fields to the provided slice, which is returned.  The fields are
+// substrings of the message, so if the caller reuses the slice across
+// messages, no allocations are necessary.
+func splitVATSIMFields(msg string, fields []string) []string {
+	for {
+		if i := strings.IndexByte(msg, ':'); i == -1 {
+			return append(fields, msg)
+		} else {
+			fields = append(fields, msg[:i])
+			msg = msg[i+1:]
+		}
+	}
+}
+
+// VATSIMMessageDispatcher finds the VATSIMMessageSpecs that match a
+// VATSIM message without having to try all of them. Specs are bucketed by
+// the prefix that they match in the first field and then within each
+// bucket by the last field that they require to match.
+type VATSIMMessageDispatcher struct {
+	buckets map[string]*vatsimDispatchBucket
+	// Lengths of all of the prefixes in buckets.
+	prefixLengths []int
+}
+
+type vatsimDispatchBucket struct {
+	// Specs that only match the first field.
+	prefixOnly []*VATSIMMessageSpec
+	// Specs that also match later fields, indexed by the index and value
+	// of the last field they match.
+	byField map[vatsimFieldMatch][]*VATSIMMessageSpec
+	// Distinct field indices used in byField.
+	fieldIndices []int
+}
+
+type vatsimFieldMatch struct {
+	index int
+	value string
+}
+
+func NewVATSIMMessageDispatcher(specs []*VATSIMMessageSpec) *VATSIMMessageDispatcher {
+	d := &VATSIMMessageDispatcher{buckets: make(map[string]*vatsimDispatchBucket)}
+
+	for _, spec := range specs {
+		prefix := spec.match[0]
+		b, ok := d.buckets[prefix]
+		if !ok {
+			b = &vatsimDispatchBucket{byField: make(map[vatsimFieldMatch][]*VATSIMMessageSpec)}
+			d.buckets[prefix] = b
+			if Find(d.prefixLengths, len(prefix)) == -1 {
+				d.prefixLengths = append(d.prefixLengths, len(prefix))
+			}
+		}
+
+		// Find the last field that must match exactly.
+		last := len(spec.match) - 1
+		for last > 0 && spec.match[last] == "" {
+			last--
+		}
+		if last == 0 {
+			b.prefixOnly = append(b.prefixOnly, spec)
+		} else {
+			fm := vatsimFieldMatch{index: last, value: spec.match[last]}
+			b.byField[fm] = append(b.byField[fm], spec)
+			if Find(b.fieldIndices, last) == -1 {
+				b.fieldIndices = append(b.fieldIndices, last)
+			}
+		}
+	}
+
+	return d
+}
+
+// visitCandidates calls the provided callback for each of the specs that
+// may match the given message fields, stopping if it returns false.
+func (d *VATSIMMessageDispatcher) visitCandidates(fields []string, visit func(spec *VATSIMMessageSpec) bool) {
+	visitSpecs := func(specs []*VATSIMMessageSpec) bool {
+		for _, spec := range specs {
+			if !visit(spec) {
+				return false
+			}
+		}
+		return true
+	}
+
+	for _, n := range d.prefixLengths {
+		if len(fields[0]) < n {
+			continue
+		}
+		b, ok := d.buckets[fields[0][:n]]
+		if !ok {
+			continue
+		}
+
+		if !visitSpecs(b.prefixOnly) {
+			return
+		}
+		for _, idx := range b.fieldIndices {
+			if idx < len(fields) {
+				if !visitSpecs(b.byField[vatsimFieldMatch{index: idx, value: fields[idx]}]) {
+					return
+				}
+			}
+		}
+	}
+}
+
+// Decode splits the given message into fields and, if it matches a spec
+// created with NewDecodingMessageSpec, decodes it, storing the results in
+// the message.  Decode only reads the dispatcher's specs and so may be
+// called concurrently from multiple goroutines.  If decoding fails, the
+// message is left undecoded; the error is then reported when the message
+// is dispatched.
+func (d *VATSIMMessageDispatcher) Decode(msg *VATSIMMessage) {
+	msg.fields = splitVATSIMFields(strings.TrimSpace(msg.Contents), nil)
+	if len(msg.fields[0]) == 0 {
+		return
+	}
+
+	d.visitCandidates(msg.fields, func(spec *VATSIMMessageSpec) bool {
+		if spec.decode == nil {
+			return true
+		}
+		if sender, ok := spec.Match(msg.fields); !ok {
+			return true
+		} else if decoded, err := spec.decode(sender, msg.fields); err == nil {
+			msg.decoded, msg.decodedBy = decoded, spec
+		}
+		return false
+	})
+}
+
+// Dispatch calls the handlers of all of the VATSIMMessageSpecs that match
+// the given message, already split into fields, returning the number of
+// specs that matched.  If the message was previously decoded by one of
+// them, its decoded form is applied directly.  Errors returned by
+// handlers are logged.
+func (d *VATSIMMessageDispatcher) Dispatch(v *VATSIMServer, msg *VATSIMMessage, fields []string) (matches int) {
+	d.visitCandidates(fields, func(spec *VATSIMMessageSpec) bool {
+		sender, ok := spec.Match(fields)
+		if !ok {
+			return true
+		}
+
+		matches++
+		var err error
+		if spec == msg.decodedBy {
+			err = spec.apply(v, sender, msg.decoded)
+		} else if spec.handler != nil {
+			err = spec.handler(v, sender, fields)
+		}
+		if err != nil {
+			lg.Printf("FSD message error: %T: %s: %s", err, err, msg.Contents)
+		}
+		return true
+	})
+
+	return
+}
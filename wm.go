@@ -14,7 +14,11 @@ package main
 import (
 	"encoding/json"
 	"fmt"
+	"runtime"
 	"sort"
+	"sync"
+	"sync/atomic"
+	"time"
 
 	"github.com/go-gl/mathgl/mgl32"
 	"github.com/mmp/imgui-go/v4"
@@ -63,6 +67,28 @@ var (
 		// temporarily (e.g., the FlightStripPane), then this lets us pop
 		// back to the previous one (e.g., the CLIPane.)
 		keyboardFocusStack []Pane
+
+		// If set, the Panes' CommandBuffer is rendered as is, rather than
+		// first merging compatible draw calls via BatchCommandBuffer.
+		disableDrawBatching bool
+		// If set, all Panes are drawn on the main thread, even those that
+		// implement PaneConcurrentDrawer.
+		disableConcurrentDraw bool
+
+		// The most recent CommandBuffer drawn by each Pane; see
+		// PaneDamageTracker.
+		paneDrawCache map[Pane]*paneDrawCache
+		// Earliest time at which a PaneDamageTracker has asked to be
+		// redrawn; zero if there are none.
+		nextRedraw time.Time
+		// If set, all Panes are redrawn every frame and the main loop
+		// never waits for events.
+		redrawContinuously bool
+		// Number of consecutive frames without any user input and the
+		// EventStream's count of posted events as of the last frame;
+		// these are used by wmIdleTimeout.
+		idleFrames       int
+		lastEventsPosted int64
 	}
 )
 
@@ -560,7 +586,7 @@ func wmAddPaneMenuSettings() {
 }
 
 func wmDrawConfigEditor(p Platform) {
-	imgui.PushFont(ui.font.ifont)
+	imgui.PushFont(ui.font.ImguiFont())
 
 	var flags imgui.WindowFlags
 	flags = imgui.WindowFlagsNoDecoration
@@ -780,6 +806,12 @@ func wmDrawPanes(platform Platform, renderer Renderer) {
 	} else {
 		wm.configEditorHeight = 0
 	}
+	// Receive any new weather radar images and upload them to textures
+	// here, on the main thread, before the Panes are drawn.
+	scope := profiler.Begin("weather upload", "weather", 0)
+	weatherService.update()
+	scope.End()
+
 	topItemsHeight := ui.menuBarHeight + wmStatusBarHeight() + wm.configEditorHeight
 
 	// Area left for actually drawing Panes
@@ -882,22 +914,54 @@ func wmDrawPanes(platform Platform, renderer Renderer) {
 			root = wm.fullScreenDisplayNode
 		}
 
-		// Actually visit the panes.
+		// Actually visit the panes. Each one draws into its own
+		// CommandBuffer, which is kept from frame to frame so that Panes
+		// that implement PaneDamageTracker and haven't changed needn't be
+		// redrawn. Panes that implement PaneConcurrentDrawer and aren't
+		// handling user input this frame are drawn in parallel after the
+		// others have been drawn on the main thread.
 		var keyboard *KeyboardState
 		if !imgui.CurrentIO().WantCaptureKeyboard() {
 			keyboard = NewKeyboardState()
 		}
+
+		// Keyboard input and clicks may affect what any of the Panes draw,
+		// either directly or via their settings windows, so all of them
+		// are redrawn when there is any.
+		inputActivity := isDragging || isClicked || io.WantCaptureKeyboard() ||
+			imgui.IsMouseReleased(MouseButtonPrimary) ||
+			imgui.IsMouseReleased(MouseButtonSecondary) ||
+			imgui.IsMouseReleased(MouseButtonTertiary) ||
+			(keyboard != nil && (keyboard.Input != "" || len(keyboard.Pressed) > 0))
+
+		if wm.paneDrawCache == nil {
+			wm.paneDrawCache = make(map[Pane]*paneDrawCache)
+		}
+		now := time.Now()
+		var jobs, drawnJobs, concurrentJobs []*paneDrawJob
 		root.VisitPanesWithBounds(paneDisplayExtent, paneDisplayExtent,
 			func(paneExtent Extent2D, parentExtent Extent2D, pane Pane) {
+				cache, ok := wm.paneDrawCache[pane]
+				if !ok {
+					cache = &paneDrawCache{cb: GetCommandBuffer()}
+					wm.paneDrawCache[pane] = cache
+				}
+				cache.visited = true
+
 				haveFocus := pane == wm.keyboardFocusPane && !imgui.CurrentIO().WantCaptureKeyboard()
-				ctx := PaneContext{
-					paneExtent:       paneExtent,
-					parentPaneExtent: parentExtent,
-					platform:         platform,
-					events:           eventStream,
-					keyboard:         keyboard,
-					haveFocus:        haveFocus,
-					cs:               positionConfig.GetColorScheme()}
+				job := &paneDrawJob{
+					pane: pane,
+					cb:   cache.cb,
+					ctx: PaneContext{
+						paneExtent:       paneExtent,
+						parentPaneExtent: parentExtent,
+						platform:         platform,
+						events:           eventStream,
+						keyboard:         keyboard,
+						haveFocus:        haveFocus,
+						cs:               positionConfig.GetColorScheme()},
+				}
+				jobs = append(jobs, job)
 
 				// Similarly make the mouse events available only to the
 				// one Pane that should see them.
@@ -908,62 +972,120 @@ func wmDrawPanes(platform Platform, renderer Renderer) {
 				if ownsMouse {
 					// Full display size, including the menu and status bar.
 					displayTrueFull := Extent2D{p0: [2]float32{0, 0}, p1: [2]float32{displaySize[0], displaySize[1]}}
-					ctx.InitializeMouse(displayTrueFull)
+					job.ctx.InitializeMouse(displayTrueFull)
 				}
 
-				// Specify the scissor rectangle and viewport that
-				// correspond to the pixels that the Pane covers. In this
-				// way, not only can the Pane be implemented in terms of
-				// Pane coordinates, independent of where it is actually
-				// placed in the overall window, but this also ensures that
-				// the Pane can't inadvertently draw over other Panes.
-				//
-				// One messy detail here is that these windows are
-				// specified in framebuffer coordinates, not display
-				// coordinates, so they must be scaled by the DPI scale for
-				// e.g., retina displays.
-				x0, y0 := int(highDPIScale*paneExtent.p0[0]), int(highDPIScale*paneExtent.p0[1])
-				w, h := int(highDPIScale*paneExtent.Width()), int(highDPIScale*paneExtent.Height())
-				commandBuffer.Scissor(x0, y0, w, h)
-				commandBuffer.Viewport(x0, y0, w, h)
-
-				// Let the Pane do its thing
-				pane.Draw(&ctx, commandBuffer)
-
-				// And reset the graphics state to the standard baseline,
-				// so no state changes leak and affect subsequent drawing.
-				commandBuffer.ResetState()
+				// Figure out if the Pane needs to be redrawn; this has to
+				// happen before PrepareDraw, which may consume events.
+				dirty := true
+				if dt, ok := pane.(PaneDamageTracker); ok && cache.valid && !wm.redrawContinuously {
+					dirty = ownsMouse || inputActivity || dt.Dirty(&job.ctx) ||
+						cache.extent != paneExtent || cache.cs != job.ctx.cs ||
+						cache.fontGeneration != fontAtlas.generation || !now.Before(cache.nextRedraw)
+				}
 
-				// If the config editor is active and the user has clicked
-				// a button that is expecting a Pane to be selected (e.g.,
-				// to delete it, etc.), then blend a semi-transparent
-				// quadrilateral over the pane that the mouse is inside to
-				// indicate that it is selected.
-				if pane == mousePane && wm.handlePanePick != nil {
-					ctx.SetWindowCoordinateMatrices(commandBuffer)
-					commandBuffer.Blend()
-
-					w, h := paneExtent.Width(), paneExtent.Height()
-					p := [4][2]float32{[2]float32{0, 0}, [2]float32{w, 0}, [2]float32{w, h}, [2]float32{0, h}}
-					pidx := commandBuffer.Float2Buffer(p[:])
-
-					indices := [4]int32{0, 1, 2, 3}
-					indidx := commandBuffer.IntBuffer(indices[:])
-
-					commandBuffer.SetRGBA(RGBA{0.5, 0.5, 0.5, 0.5})
-					commandBuffer.VertexArray(pidx, 2, 2*4)
-					commandBuffer.DrawQuads(indidx, 4)
-					commandBuffer.ResetState()
+				cd, concurrent := pane.(PaneConcurrentDrawer)
+				if concurrent {
+					scope := profiler.Begin(pane.Name(), "prepare", 0)
+					cd.PrepareDraw(&job.ctx)
+					scope.End()
+				}
+				if !dirty {
+					return
 				}
 
-				// Draw a border around the pane if it has keyboard focus.
-				if haveFocus {
-					ctx.SetWindowCoordinateMatrices(commandBuffer)
-					w, h := paneExtent.Width(), paneExtent.Height()
-					drawBorder(commandBuffer, w, h, ctx.cs.TextHighlight)
+				cache.cb.Reset()
+				cache.valid, cache.extent, cache.cs = true, paneExtent, job.ctx.cs
+				cache.fontGeneration = fontAtlas.generation
+				drawnJobs = append(drawnJobs, job)
+
+				// Let the Pane do its thing, now or later.
+				if concurrent && !ownsMouse && !haveFocus && !wm.disableConcurrentDraw {
+					concurrentJobs = append(concurrentJobs, job)
+				} else {
+					job.draw()
 				}
 			})
 
+		wmDrawPanesConcurrently(concurrentJobs)
+
+		// Record when the Panes that were drawn will next need to be
+		// redrawn and discard the CommandBuffers of Panes that have gone
+		// away.
+		for _, job := range drawnJobs {
+			if dt, ok := job.pane.(PaneDamageTracker); ok {
+				wm.paneDrawCache[job.pane].nextRedraw = dt.NextRedraw()
+			}
+		}
+		wm.nextRedraw = time.Time{}
+		for pane, cache := range wm.paneDrawCache {
+			if !cache.visited {
+				ReturnCommandBuffer(cache.cb)
+				delete(wm.paneDrawCache, pane)
+				continue
+			}
+			cache.visited = false
+			if _, ok := pane.(PaneDamageTracker); ok &&
+				(wm.nextRedraw.IsZero() || cache.nextRedraw.Before(wm.nextRedraw)) {
+				wm.nextRedraw = cache.nextRedraw
+			}
+		}
+
+		for _, job := range jobs {
+			pane, paneExtent := job.pane, job.ctx.paneExtent
+
+			// Specify the scissor rectangle and viewport that
+			// correspond to the pixels that the Pane covers. In this
+			// way, not only can the Pane be implemented in terms of
+			// Pane coordinates, independent of where it is actually
+			// placed in the overall window, but this also ensures that
+			// the Pane can't inadvertently draw over other Panes.
+			//
+			// One messy detail here is that these windows are
+			// specified in framebuffer coordinates, not display
+			// coordinates, so they must be scaled by the DPI scale for
+			// e.g., retina displays.
+			x0, y0 := int(highDPIScale*paneExtent.p0[0]), int(highDPIScale*paneExtent.p0[1])
+			w, h := int(highDPIScale*paneExtent.Width()), int(highDPIScale*paneExtent.Height())
+			commandBuffer.Scissor(x0, y0, w, h)
+			commandBuffer.Viewport(x0, y0, w, h)
+
+			commandBuffer.Call(*job.cb)
+
+			// And reset the graphics state to the standard baseline,
+			// so no state changes leak and affect subsequent drawing.
+			commandBuffer.ResetState()
+
+			// If the config editor is active and the user has clicked
+			// a button that is expecting a Pane to be selected (e.g.,
+			// to delete it, etc.), then blend a semi-transparent
+			// quadrilateral over the pane that the mouse is inside to
+			// indicate that it is selected.
+			if pane == mousePane && wm.handlePanePick != nil {
+				job.ctx.SetWindowCoordinateMatrices(commandBuffer)
+				commandBuffer.Blend()
+
+				w, h := paneExtent.Width(), paneExtent.Height()
+				p := [4][2]float32{[2]float32{0, 0}, [2]float32{w, 0}, [2]float32{w, h}, [2]float32{0, h}}
+				pidx := commandBuffer.Float2Buffer(p[:])
+
+				indices := [4]int32{0, 1, 2, 3}
+				indidx := commandBuffer.IntBuffer(indices[:])
+
+				commandBuffer.SetRGBA(RGBA{0.5, 0.5, 0.5, 0.5})
+				commandBuffer.VertexArray(pidx, 2, 2*4)
+				commandBuffer.DrawQuads(indidx, 4)
+				commandBuffer.ResetState()
+			}
+
+			// Draw a border around the pane if it has keyboard focus.
+			if job.ctx.haveFocus {
+				job.ctx.SetWindowCoordinateMatrices(commandBuffer)
+				w, h := paneExtent.Width(), paneExtent.Height()
+				drawBorder(commandBuffer, w, h, job.ctx.cs.TextHighlight)
+			}
+		}
+
 		// Clear mouseConsumerOverride if the user has stopped dragging;
 		// only do this after visiting the Panes so that the override Pane
 		// still sees the mouse button release event.
@@ -972,8 +1094,28 @@ func wmDrawPanes(platform Platform, renderer Renderer) {
 		}
 
 		// Finally, render the entire command buffer for all of the Panes
-		// all at once.
-		stats.render = renderer.RenderCommandBuffer(commandBuffer)
+		// all at once, merging compatible draw calls first unless
+		// that has been disabled.
+		rendered := false
+		if !wm.disableDrawBatching {
+			batched := GetCommandBuffer()
+			scope := profiler.Begin("batch", "render", 0)
+			merged, ok := BatchCommandBuffer(commandBuffer, batched)
+			scope.End()
+			if ok {
+				scope := profiler.Begin("submit", "render", 0)
+				stats.render = renderer.RenderCommandBuffer(batched)
+				scope.End()
+				stats.render.nMergedDrawCalls = merged
+				rendered = true
+			}
+			ReturnCommandBuffer(batched)
+		}
+		if !rendered {
+			scope := profiler.Begin("submit", "render", 0)
+			stats.render = renderer.RenderCommandBuffer(commandBuffer)
+			scope.End()
+		}
 	}
 
 	if wm.showConfigEditor {
@@ -981,6 +1123,131 @@ func wmDrawPanes(platform Platform, renderer Renderer) {
 	}
 }
 
+// paneDrawJob records what's needed to draw a single Pane into its own
+// CommandBuffer.
+type paneDrawJob struct {
+	pane Pane
+	ctx  PaneContext
+	cb   *CommandBuffer
+}
+
+// draw calls the Pane's Draw method, recording its timing with the
+// profiler.
+func (job *paneDrawJob) draw() {
+	defer profiler.Begin(job.pane.Name(), "draw", job.ctx.profileTrack).End()
+	job.pane.Draw(&job.ctx, job.cb)
+}
+
+const (
+	// Maximum amount of time that the main loop waits for events before
+	// going ahead and drawing a new frame, which bounds how out of date
+	// Panes that aren't PaneDamageTrackers can be.
+	wmMaxIdleInterval = 250 * time.Millisecond
+	// Number of frames to keep drawing after user input before waiting
+	// for events, so that imgui's state settles.
+	wmIdleFramesBeforeWaiting = 3
+)
+
+// wmNoteEvents should be called by the main loop each frame after it
+// processes events; anyEvents indicates whether there was user input.
+func wmNoteEvents(anyEvents bool) {
+	if anyEvents {
+		wm.idleFrames = 0
+	} else {
+		wm.idleFrames++
+	}
+}
+
+// wmIdleTimeout returns the amount of time that the main loop should wait
+// for events before drawing the next frame; it returns zero if the frame
+// should be drawn right away, either because something is going on or
+// because a Pane needs to be redrawn.
+func wmIdleTimeout() time.Duration {
+	posted := eventStream.Posted()
+	newEvents := posted != wm.lastEventsPosted
+	wm.lastEventsPosted = posted
+
+	if wm.redrawContinuously || newEvents || wm.idleFrames < wmIdleFramesBeforeWaiting ||
+		imgui.CurrentIO().WantCaptureKeyboard() {
+		return 0
+	}
+
+	timeout := wmMaxIdleInterval
+	if !wm.nextRedraw.IsZero() {
+		timeout = min(timeout, time.Until(wm.nextRedraw))
+	}
+	return max(timeout, 0)
+}
+
+// paneDrawCache stores the CommandBuffer that a Pane most recently drew
+// into along with the information needed to decide whether it can be
+// reused.
+type paneDrawCache struct {
+	cb     *CommandBuffer
+	valid  bool
+	extent Extent2D
+	cs     *ColorScheme
+	// fontGeneration is the font atlas generation that the cached text
+	// was rendered with.
+	fontGeneration int
+	nextRedraw     time.Time
+	// visited is used to find Panes that have been removed.
+	visited bool
+}
+
+// wmDrawPanesConcurrently calls the Draw methods of the provided Panes
+// using a pool of worker goroutines (including the calling one), and
+// returns once all of them have finished.  If a Pane's Draw method
+// panics, the panic is re-raised on the calling goroutine so that the
+// usual crash handling applies.
+func wmDrawPanesConcurrently(jobs []*paneDrawJob) {
+	if len(jobs) == 0 {
+		return
+	} else if len(jobs) == 1 {
+		jobs[0].draw()
+		return
+	}
+
+	var next int32
+	var panicMutex sync.Mutex
+	var panicked interface{}
+	work := func(track int32) {
+		defer func() {
+			if err := recover(); err != nil {
+				panicMutex.Lock()
+				if panicked == nil {
+					panicked = err
+				}
+				panicMutex.Unlock()
+			}
+		}()
+		for {
+			i := int(atomic.AddInt32(&next, 1)) - 1
+			if i >= len(jobs) {
+				return
+			}
+			jobs[i].ctx.profileTrack = track
+			jobs[i].draw()
+		}
+	}
+
+	var wg sync.WaitGroup
+	nWorkers := min(runtime.NumCPU(), len(jobs))
+	for i := 1; i < nWorkers; i++ {
+		wg.Add(1)
+		go func(track int32) {
+			defer wg.Done()
+			work(track)
+		}(int32(i))
+	}
+	work(0)
+	wg.Wait()
+
+	if panicked != nil {
+		panic(panicked)
+	}
+}
+
 // drawBorder emits drawing commands to the provided CommandBuffer to draw
 // a border rectangle with given dimensions, inset 1 pixel.
 func drawBorder(cb *CommandBuffer, w, h float32, color RGB) {